@@ -26,6 +26,7 @@
 #include <list>
 #include <any>
 #include <map>
+#include <string>
 
 #include "def.h"
 #include "types.h"
@@ -50,6 +51,70 @@ public:
     virtual std::vector<Sp<NodeInfo>>& getBootstrapNodes() = 0;
 
     virtual std::map<std::string, std::any>& getAddons() = 0;
+
+    /**
+     * The number of SO_REUSEPORT sockets, each served by its own receive worker
+     * thread, bound per address family. 0 keeps the single receive thread.
+     */
+    virtual int receiveWorkers() {
+        return 0;
+    }
+
+    /**
+     * The number of worker threads that decrypt and parse the received packets
+     * before they go to the DHT. 0 decodes the packets on the receiving thread.
+     */
+    virtual int packetWorkers() {
+        return 0;
+    }
+
+    /**
+     * The number of worker threads that verify the signatures of the values and
+     * peers received from the network. 0 verifies them on the receiving thread.
+     */
+    virtual int verifyWorkers() {
+        return 0;
+    }
+
+    /**
+     * The backend of the node storage: "sqlite" keeps the values and peers in
+     * node.db under the storage path, "memory" keeps them in memory only and
+     * they are lost when the node stops.
+     */
+    virtual std::string storageBackend() {
+        return "sqlite";
+    }
+
+    /**
+     * The SQLite journal mode of the node storage: DELETE, TRUNCATE, PERSIST,
+     * MEMORY, WAL or OFF.
+     */
+    virtual std::string storageJournalMode() {
+        return "WAL";
+    }
+
+    /**
+     * The SQLite synchronous setting of the node storage: OFF, NORMAL, FULL or EXTRA.
+     */
+    virtual std::string storageSynchronous() {
+        return "NORMAL";
+    }
+
+    /**
+     * The maximum number of bytes of the node storage accessed through memory-mapped
+     * I/O. 0 disables memory-mapped I/O.
+     */
+    virtual int64_t storageMmapSize() {
+        return 0;
+    }
+
+    /**
+     * The SQLite page cache size of the node storage, in pages if positive or in
+     * KiB if negative. 0 keeps the SQLite default.
+     */
+    virtual int storageCacheSize() {
+        return 0;
+    }
 };
 
 } // namespace boson
@@ -69,6 +69,38 @@ public:
         return addons;
     }
 
+    int receiveWorkers() override {
+        return rxWorkers;
+    }
+
+    int packetWorkers() override {
+        return decodeWorkers;
+    }
+
+    int verifyWorkers() override {
+        return verifiers;
+    }
+
+    std::string storageBackend() override {
+        return backend;
+    }
+
+    std::string storageJournalMode() override {
+        return journalMode;
+    }
+
+    std::string storageSynchronous() override {
+        return synchronous;
+    }
+
+    int64_t storageMmapSize() override {
+        return mmapSize;
+    }
+
+    int storageCacheSize() override {
+        return cacheSize;
+    }
+
     class BOSON_PUBLIC Builder {
     public:
         Builder() {
@@ -144,6 +176,42 @@ public:
             bootstrapNodes.clear();
         }
 
+        void setReceiveWorkers(int workers) {
+            if (workers < 0 || workers > 64)
+                throw std::invalid_argument("Invalid receive workers: " + std::to_string(workers));
+
+            this->rxWorkers = workers;
+        }
+
+        void setPacketWorkers(int workers) {
+            if (workers < 0 || workers > 64)
+                throw std::invalid_argument("Invalid packet workers: " + std::to_string(workers));
+
+            this->decodeWorkers = workers;
+        }
+
+        void setVerifyWorkers(int workers) {
+            if (workers < 0 || workers > 64)
+                throw std::invalid_argument("Invalid verify workers: " + std::to_string(workers));
+
+            this->verifiers = workers;
+        }
+
+        void setStorageBackend(const std::string& backend);
+        void setStorageJournalMode(const std::string& mode);
+        void setStorageSynchronous(const std::string& synchronous);
+
+        void setStorageMmapSize(int64_t size) {
+            if (size < 0)
+                throw std::invalid_argument("Invalid storage mmap size: " + std::to_string(size));
+
+            this->mmapSize = size;
+        }
+
+        void setStorageCacheSize(int size) {
+            this->cacheSize = size;
+        }
+
         void load(const std::string& path);
         void reset();
 
@@ -158,6 +226,14 @@ public:
         std::string storagePath {};
         std::vector<Sp<NodeInfo>> bootstrapNodes {};
         std::map<std::string, std::any> addons {};
+        int rxWorkers {0};
+        int decodeWorkers {0};
+        int verifiers {0};
+        std::string backend {"sqlite"};
+        std::string journalMode {"WAL"};
+        std::string synchronous {"NORMAL"};
+        int64_t mmapSize {0};
+        int cacheSize {0};
     };
 
 private:
@@ -167,6 +243,14 @@ private:
     std::string storagePath {};
     std::vector<Sp<NodeInfo>> bootstrapNodes {};
     std::map<std::string, std::any> addons {};
+    int rxWorkers {0};
+    int decodeWorkers {0};
+    int verifiers {0};
+    std::string backend {"sqlite"};
+    std::string journalMode {"WAL"};
+    std::string synchronous {"NORMAL"};
+    int64_t mmapSize {0};
+    int cacheSize {0};
 };
 
 } // namespace boson
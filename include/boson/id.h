@@ -24,6 +24,7 @@
 #pragma once
 
 #include <array>
+#include <cstring>
 #include <vector>
 #include <stdexcept>
 #include <string>
@@ -167,3 +168,17 @@ private:
 };
 
 } // namespace boson
+
+namespace std {
+
+// Ids are public keys or digests, any 8 bytes of them are uniformly distributed
+template <>
+struct hash<boson::Id> {
+    size_t operator()(const boson::Id& id) const noexcept {
+        size_t h;
+        std::memcpy(&h, id.data(), sizeof(h));
+        return h;
+    }
+};
+
+} // namespace std
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "constants.h"
+#include "utils/time.h"
+#include "caching_storage.h"
+
+namespace boson {
+
+// the list node, the index node and the key, roughly
+static const size_t ENTRY_OVERHEAD = 96;
+
+static size_t estimate(const Sp<Value>& value) {
+    if (!value)
+        return 0;
+    return sizeof(Value) + value->getData().size() + (value->isSigned() ? value->getSignature().size() : 0);
+}
+
+static size_t estimate(const std::vector<PeerInfo>& peers) {
+    size_t bytes = 0;
+    for (const auto& peer : peers)
+        bytes += sizeof(PeerInfo) + peer.getSignature().size() +
+                (peer.hasAlternativeURL() ? peer.getAlternativeURL().size() : 0);
+    return bytes;
+}
+
+template <typename T>
+typename CachingStorage::Cache<T>::Entry* CachingStorage::Cache<T>::find(const Id& key, uint64_t now) {
+    auto it = index.find(key);
+    if (it == index.end())
+        return nullptr;
+
+    auto entry = it->second;
+    if (now >= entry->expiration) {
+        memory -= entry->bytes;
+        lru.erase(entry);
+        index.erase(it);
+        return nullptr;
+    }
+
+    lru.splice(lru.begin(), lru, entry);
+    return &*entry;
+}
+
+template <typename T>
+typename CachingStorage::Cache<T>::Entry* CachingStorage::Cache<T>::peek(const Id& key) {
+    auto it = index.find(key);
+    return it != index.end() ? &*it->second : nullptr;
+}
+
+template <typename T>
+bool CachingStorage::Cache<T>::fits(size_t bytes) const {
+    return bytes + sizeof(Entry) + ENTRY_OVERHEAD <= capacity;
+}
+
+template <typename T>
+size_t CachingStorage::Cache<T>::put(const Id& key, T&& data, size_t bytes, uint64_t expiration) {
+    invalidate(key);
+
+    if (!fits(bytes))
+        return 0;
+    bytes += sizeof(Entry) + ENTRY_OVERHEAD;
+
+    size_t evicted = 0;
+    while (memory + bytes > capacity) {
+        auto& last = lru.back();
+        memory -= last.bytes;
+        index.erase(last.key);
+        lru.pop_back();
+        evicted++;
+    }
+
+    lru.push_front(Entry {key, std::move(data), bytes, expiration});
+    index.emplace(key, lru.begin());
+    memory += bytes;
+    return evicted;
+}
+
+template <typename T>
+size_t CachingStorage::Cache<T>::resize(Entry* entry, size_t bytes) {
+    bytes += sizeof(Entry) + ENTRY_OVERHEAD;
+    memory = memory - entry->bytes + bytes;
+    entry->bytes = bytes;
+
+    size_t evicted = 0;
+    while (memory > capacity) {
+        auto& last = lru.back();
+        memory -= last.bytes;
+        index.erase(last.key);
+        lru.pop_back();
+        evicted++;
+    }
+    return evicted;
+}
+
+template <typename T>
+void CachingStorage::Cache<T>::invalidate(const Id& key) {
+    auto it = index.find(key);
+    if (it == index.end())
+        return;
+
+    memory -= it->second->bytes;
+    lru.erase(it->second);
+    index.erase(it);
+}
+
+template <typename T>
+void CachingStorage::Cache<T>::clear() {
+    index.clear();
+    lru.clear();
+    memory = 0;
+}
+
+CachingStorage::CachingStorage(Sp<DataStorage> _backend, size_t capacity, int _ttl)
+    : backend(std::move(_backend)), ttl(_ttl) {
+    values.capacity = capacity / 2;
+    peers.capacity = capacity - values.capacity;
+}
+
+CachingStorage::CachingStorage(Sp<DataStorage> backend)
+    : CachingStorage(std::move(backend), Constants::STORAGE_CACHE_CAPACITY, Constants::STORAGE_CACHE_TTL) {
+}
+
+void CachingStorage::close() {
+    backend->close();
+
+    std::lock_guard<std::mutex> lk(lock);
+    values.clear();
+    peers.clear();
+}
+
+void CachingStorage::invalidateValue(const Id& valueId) {
+    std::lock_guard<std::mutex> lk(lock);
+    values.invalidate(valueId);
+    values.epoch++;
+}
+
+void CachingStorage::updatePeers(const PeerInfo& peer) {
+    std::lock_guard<std::mutex> lk(lock);
+    // a load racing with the write may miss it, don't cache that
+    peers.epoch++;
+
+    auto entry = peers.peek(peer.getId());
+    if (!entry)
+        return;
+
+    auto& set = entry->data;
+    auto it = std::find_if(set.peers.begin(), set.peers.end(), [&](const PeerInfo& p) {
+        return p.getNodeId() == peer.getNodeId() && p.getOrigin() == peer.getOrigin();
+    });
+    if (it != set.peers.end())
+        *it = peer;
+    else if (set.complete || set.peers.empty())
+        set.peers.push_back(peer);
+    else
+        // a bounded sample stays bounded, the new peer takes a random place in it
+        set.peers[random() % set.peers.size()] = peer;
+
+    evictions += peers.resize(entry, estimate(set.peers));
+}
+
+Sp<Value> CachingStorage::getValue(const Id& valueId) {
+    auto now = currentTimeMillis();
+    uint64_t epoch;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        auto entry = values.find(valueId, now);
+        if (entry) {
+            hits++;
+            return entry->data;
+        }
+        epoch = values.epoch;
+    }
+
+    misses++;
+    uint64_t expiration;
+    auto value = backend->loadValue(valueId, expiration);
+
+    std::lock_guard<std::mutex> lk(lock);
+    if (values.epoch == epoch) {
+        auto bytes = estimate(value);
+        auto copy = value;
+        if (values.fits(bytes))
+            evictions += values.put(valueId, std::move(copy), bytes, expire(now, expiration));
+        else
+            oversized++;
+    }
+    return value;
+}
+
+Sp<Value> CachingStorage::putValue(const Value& value, int expectedSeq, bool persistent, bool updateLastAnnounce) {
+    auto old = backend->putValue(value, expectedSeq, persistent, updateLastAnnounce);
+    invalidateValue(value.getId());
+    return old;
+}
+
+bool CachingStorage::removeValue(const Id& valueId) {
+    auto removed = backend->removeValue(valueId);
+    invalidateValue(valueId);
+    return removed;
+}
+
+void CachingStorage::updateValueLastAnnounce(const Id& valueId) {
+    // refreshes the timestamp, which may bring back a value that already aged out
+    backend->updateValueLastAnnounce(valueId);
+    invalidateValue(valueId);
+}
+
+std::vector<Value> CachingStorage::getPersistentValues(uint64_t lastAnnounceBefore) {
+    return backend->getPersistentValues(lastAnnounceBefore);
+}
+
+std::vector<Id> CachingStorage::getAllValues() {
+    return backend->getAllValues();
+}
+
+// A random sample of maxPeers, as the backend returns, or all for maxPeers <= 0
+static std::vector<PeerInfo> sample(const std::vector<PeerInfo>& peers, int maxPeers, std::mt19937& random) {
+    if (maxPeers <= 0 || peers.size() <= (size_t)maxPeers)
+        return peers;
+
+    std::vector<const PeerInfo*> picks {};
+    picks.reserve(peers.size());
+    for (const auto& peer : peers)
+        picks.push_back(&peer);
+
+    std::vector<PeerInfo> result {};
+    result.reserve(maxPeers);
+    for (size_t i = 0; i < (size_t)maxPeers; i++) {
+        auto j = i + random() % (picks.size() - i);
+        std::swap(picks[i], picks[j]);
+        result.push_back(*picks[i]);
+    }
+    return result;
+}
+
+uint64_t CachingStorage::expire(uint64_t now, uint64_t expiration) const {
+    // 0 when the backend can't tell when the records age out
+    return expiration != 0 ? std::min(now + ttl, expiration) : now + ttl;
+}
+
+std::vector<PeerInfo> CachingStorage::getPeer(const Id& peerId, int maxPeers) {
+    auto now = currentTimeMillis();
+    uint64_t epoch;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        auto entry = peers.find(peerId, now);
+        // a bounded sample only serves the lookups it is large enough to vary
+        if (entry && (entry->data.complete ||
+                (maxPeers > 0 && (size_t)maxPeers * PEER_SAMPLE_FACTOR <= entry->data.peers.size()))) {
+            hits++;
+            return sample(entry->data.peers, maxPeers, random);
+        }
+        epoch = peers.epoch;
+    }
+
+    misses++;
+    uint64_t expiration;
+    int limit = maxPeers > 0 ? maxPeers * PEER_SAMPLE_FACTOR : 0;
+    auto loaded = backend->loadPeers(peerId, limit, expiration);
+    bool complete = limit <= 0 || loaded.size() < (size_t)limit;
+
+    std::lock_guard<std::mutex> lk(lock);
+    auto result = sample(loaded, maxPeers, random);
+    if (peers.epoch == epoch) {
+        auto bytes = estimate(loaded);
+        if (peers.fits(bytes))
+            evictions += peers.put(peerId, PeerSet {std::move(loaded), complete}, bytes, expire(now, expiration));
+        else
+            oversized++;
+    }
+    return result;
+}
+
+Sp<PeerInfo> CachingStorage::getPeer(const Id& peerId, const Id& origin) {
+    return backend->getPeer(peerId, origin);
+}
+
+bool CachingStorage::removePeer(const Id& peerId, const Id& origin) {
+    auto removed = backend->removePeer(peerId, origin);
+
+    std::lock_guard<std::mutex> lk(lock);
+    peers.epoch++;
+    auto entry = peers.peek(peerId);
+    if (entry) {
+        auto& cached = entry->data.peers;
+        cached.erase(std::remove_if(cached.begin(), cached.end(), [&](const PeerInfo& p) {
+            return p.getOrigin() == origin;
+        }), cached.end());
+        evictions += peers.resize(entry, estimate(cached));
+    }
+    return removed;
+}
+
+void CachingStorage::putPeer(const std::vector<PeerInfo>& peers) {
+    backend->putPeer(peers);
+    for (const auto& peer : peers)
+        updatePeers(peer);
+}
+
+void CachingStorage::putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) {
+    backend->putPeer(peer, persistent, updateLastAnnounce);
+    updatePeers(peer);
+}
+
+void CachingStorage::updatePeerLastAnnounce(const Id& peerId, const Id& origin) {
+    backend->updatePeerLastAnnounce(peerId, origin);
+
+    // only the timestamp moves, a cached peer stays as it is; a peer not in
+    // the set may be one that aged out and comes back
+    std::lock_guard<std::mutex> lk(lock);
+    peers.epoch++;
+    auto entry = peers.peek(peerId);
+    if (entry && std::none_of(entry->data.peers.begin(), entry->data.peers.end(), [&](const PeerInfo& p) {
+            return p.getOrigin() == origin;
+        }))
+        peers.invalidate(peerId);
+}
+
+std::vector<PeerInfo> CachingStorage::getPersistentPeers(uint64_t lastAnnounceBefore) {
+    return backend->getPersistentPeers(lastAnnounceBefore);
+}
+
+std::vector<Id> CachingStorage::getAllPeers() {
+    return backend->getAllPeers();
+}
+
+size_t CachingStorage::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lk(lock);
+    return values.memory + peers.memory;
+}
+
+size_t CachingStorage::size() const {
+    std::lock_guard<std::mutex> lk(lock);
+    return values.index.size() + peers.index.size();
+}
+
+std::string CachingStorage::toString() const {
+    std::stringstream ss;
+    ss << "### storage cache" << std::endl;
+    ss << "entries: " << size() << ", memory: " << getMemoryUsage() << " bytes" << std::endl;
+    ss << "hits: " << getHits() << ", misses: " << getMisses()
+        << ", hit ratio: " << (int)(getHitRatio() * 100) << "%"
+        << ", evictions: " << getEvictions() << ", oversized: " << getOversized() << std::endl;
+    ss << backend->toString();
+    return ss.str();
+}
+
+} // namespace boson
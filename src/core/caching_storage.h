@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "boson/id.h"
+#include "boson/value.h"
+#include "boson/peer_info.h"
+#include "data_storage.h"
+
+namespace boson {
+
+/*
+ * Keeps the recently read values and peer sets in memory in front of the
+ * backend storage.
+ *
+ * Both maps are LRU ordered and bounded by the estimated bytes they hold, each
+ * gets half of the capacity. An entry is trusted for ttl milliseconds after it
+ * was loaded, but never past the time its record ages out of the backend. A
+ * missing value or peer id is cached as well (negative caching), which is what
+ * most of the lookups for unknown targets end up with.
+ *
+ * A peer id caches a random sample of PEER_SAMPLE_FACTOR times the peers asked
+ * for, or its whole peer set when smaller, and each lookup draws its own sample
+ * from it, so the lookups keep spreading over the announced peers. The peer
+ * writes update a cached set in place rather than dropping it, so announces on
+ * a hot id don't force reloads. A set too large for the cache is not kept, and
+ * counted as oversized.
+ *
+ * Every write through the decorator drops the entries of the ids it touches.
+ * A load racing with such a write is not cached: each map carries an epoch
+ * bumped on every invalidation, and the loaded result is only kept when the
+ * epoch did not move while the backend was read.
+ */
+class CachingStorage final : public DataStorage {
+public:
+    CachingStorage(Sp<DataStorage> backend, size_t capacity, int ttl);
+    explicit CachingStorage(Sp<DataStorage> backend);
+
+    CachingStorage(const CachingStorage&) = delete;
+    CachingStorage& operator=(const CachingStorage&) = delete;
+
+    void close() override;
+
+    using DataStorage::putValue;
+    using DataStorage::putPeer;
+
+    Sp<Value> getValue(const Id& valueId) override;
+    bool removeValue(const Id& valueId) override;
+    Sp<Value> putValue(const Value& value, int expectedSeq = -1, bool persistent = false, bool updateLastAnnounce = false) override;
+    void updateValueLastAnnounce(const Id& valueId) override;
+    std::vector<Value> getPersistentValues(uint64_t lastAnnounceBefore) override;
+    std::vector<Id> getAllValues() override;
+
+    std::vector<PeerInfo> getPeer(const Id& peerId, int maxPeers) override;
+    Sp<PeerInfo> getPeer(const Id& peerId, const Id& origin) override;
+    bool removePeer(const Id& peerId, const Id& origin) override;
+    void putPeer(const std::vector<PeerInfo>& peers) override;
+    void putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) override;
+    void updatePeerLastAnnounce(const Id& peerId, const Id& origin) override;
+    std::vector<PeerInfo> getPersistentPeers(uint64_t lastAnnounceBefore) override;
+    std::vector<Id> getAllPeers() override;
+
+    void transaction(const std::function<void()>& writes) override {
+        backend->transaction(writes);
+    }
+
+    uint64_t getHits() const noexcept {
+        return hits;
+    }
+
+    uint64_t getMisses() const noexcept {
+        return misses;
+    }
+
+    uint64_t getEvictions() const noexcept {
+        return evictions;
+    }
+
+    // Loads too large to be cached
+    uint64_t getOversized() const noexcept {
+        return oversized;
+    }
+
+    double getHitRatio() const noexcept {
+        uint64_t h = hits, m = misses;
+        return h + m == 0 ? 0.0 : (double)h / (h + m);
+    }
+
+    // Estimated bytes held by the cached entries
+    size_t getMemoryUsage() const;
+    size_t size() const;
+
+    std::string toString() const override;
+
+private:
+    template <typename T>
+    class Cache {
+    public:
+        struct Entry {
+            Id key;
+            T data;
+            size_t bytes;
+            uint64_t expiration;
+        };
+
+        // Drops the expired entry, moves a live one to the front
+        Entry* find(const Id& key, uint64_t now);
+        // The entry as it is, to be changed in place
+        Entry* peek(const Id& key);
+        bool fits(size_t bytes) const;
+        // Returns the number of entries evicted to make room
+        size_t put(const Id& key, T&& data, size_t bytes, uint64_t expiration);
+        // Accounts for an entry changed in place, returns the number of entries
+        // evicted to make room, the entry itself possibly
+        size_t resize(Entry* entry, size_t bytes);
+        void invalidate(const Id& key);
+        void clear();
+
+        size_t capacity {0};
+        size_t memory {0};
+        uint64_t epoch {0};
+        std::list<Entry> lru {};
+        std::unordered_map<Id, typename std::list<Entry>::iterator> index {};
+    };
+
+    struct PeerSet {
+        std::vector<PeerInfo> peers;
+        bool complete;      // all the peers of the id, not a bounded sample
+    };
+
+    // the peers loaded for a lookup, per peer asked for
+    static constexpr int PEER_SAMPLE_FACTOR = 4;
+
+    void invalidateValue(const Id& valueId);
+    // Applies a peer write to the cached set, if any
+    void updatePeers(const PeerInfo& peer);
+    // The time an entry loaded at now stops being trusted
+    uint64_t expire(uint64_t now, uint64_t expiration) const;
+
+    Sp<DataStorage> backend;
+    const int ttl;
+
+    mutable std::mutex lock {};
+    Cache<Sp<Value>> values {};
+    Cache<PeerSet> peers {};
+    std::mt19937 random { std::random_device()() };
+
+    std::atomic<uint64_t> hits {0};
+    std::atomic<uint64_t> misses {0};
+    std::atomic<uint64_t> evictions {0};
+    std::atomic<uint64_t> oversized {0};
+};
+
+} // namespace boson
@@ -30,7 +30,21 @@ const int Constants::RPC_SERVER_REACHABILITY_TIMEOUT        = 60 * 1000;
 const int Constants::MAX_ACTIVE_CALLS                       = 256;
 const int Constants::RPC_CALL_TIMEOUT_MAX                   = 10 * 1000;
 const int Constants::RPC_CALL_TIMEOUT_BASELINE_MIN          = 100; // ms
+const int Constants::RPC_CALL_STALL_TIMEOUT_DEFAULT         = 2000; // ms
+const int Constants::RPC_CALL_RTT_MIN_SAMPLES               = 32;
+const int Constants::RPC_CALL_DESTINATION_BURST             = 8;
+const int Constants::RPC_CALL_DESTINATION_RATE              = 8; // calls per second
 const int Constants::RECEIVE_BUFFER_SIZE                    = 5 * 1024;
+const int Constants::RPC_SERVER_IO_BATCH_SIZE               = 32;
+const int Constants::RPC_SERVER_MAX_DATAGRAM_SIZE           = 64 * 1024;
+const int Constants::RPC_SERVER_SEND_RETRY_INTERVAL         = 10; // ms
+const int Constants::RPC_SERVER_OUTBOUND_QUEUE_CAPACITY     = 128; // 4 batches
+const int Constants::RPC_SERVER_INBOUND_QUEUE_CAPACITY      = 4096;
+const int Constants::RPC_SERVER_DECODE_QUEUE_CAPACITY       = 4096;
+const int Constants::SIGNATURE_VERIFY_QUEUE_CAPACITY        = 4096;
+const int Constants::SIGNATURE_VERIFY_BATCH_SIZE            = 32;
+const int Constants::VERIFIED_RECORDS_CAPACITY              = 8192;
+const int Constants::MESSAGE_POOL_CAPACITY                  = 256;
 
 const int Constants::MAX_CONCURRENT_TASK_REQUESTS           = 10;
 const int Constants::MAX_ACTIVE_TASKS                       = 16;
@@ -54,11 +68,21 @@ const int Constants::KBUCKET_PING_BACKOFF_BASE_INTERVAL     = 60 * 1000;
 const int Constants::BUCKET_CACHE_PING_MIN_INTERVAL         = 30 * 1000;
 
 const int Constants::STORAGE_EXPIRE_INTERVAL                = 5 * 60 * 1000;
+const int Constants::STORAGE_EXPIRE_CHUNK_SIZE              = 256;
+const int Constants::STORAGE_EXPIRE_CHUNK_INTERVAL          = 10;
+const int Constants::STORAGE_COMMIT_INTERVAL                = 100;
+const int Constants::STORAGE_COMMIT_BATCH_SIZE              = 256;
+const int Constants::STORAGE_READ_BUSY_TIMEOUT              = 100;
+const int Constants::STORAGE_CACHE_CAPACITY                 = 16 * 1024 * 1024;
+const int Constants::STORAGE_CACHE_TTL                      = 60 * 1000;
 const int Constants::TOKEN_TIMEOUT                          = 5 * 60 * 1000;
 const int Constants::MAX_PEER_AGE                           = 120 * 60 * 1000;
 const int Constants::MAX_VALUE_AGE                          = 120 * 60 * 1000;
 const int Constants::RE_ANNOUNCE_INTERVAL                   = 5 * 60 * 1000;
 
+const int Constants::CRYPTO_CACHE_CAPACITY                  = 4096;
+const int Constants::CRYPTO_CACHE_SHARDS                    = 16;
+
 const std::string Constants::NODE_NAME                      = "Meerkat";
 const std::string Constants::NODE_SHORT_NAME                = "MK";
 const int Constants::NODE_VERSION                           = 1;
@@ -42,7 +42,29 @@ struct Constants {
     static const int        MAX_ACTIVE_CALLS;
     static const int        RPC_CALL_TIMEOUT_MAX;
     static const int        RPC_CALL_TIMEOUT_BASELINE_MIN;
+    // stall deadline while neither the node nor the network has an RTT estimate
+    static const int        RPC_CALL_STALL_TIMEOUT_DEFAULT;
+    // samples needed before the global RTT percentiles drive the deadlines
+    static const int        RPC_CALL_RTT_MIN_SAMPLES;
+    // per-destination token bucket pacing the calls sent to a single node
+    static const int        RPC_CALL_DESTINATION_BURST;
+    static const int        RPC_CALL_DESTINATION_RATE;
     static const int        RECEIVE_BUFFER_SIZE;
+    // max datagrams drained/flushed per recvmmsg/sendmmsg system call
+    static const int        RPC_SERVER_IO_BATCH_SIZE;
+    static const int        RPC_SERVER_MAX_DATAGRAM_SIZE;
+    static const int        RPC_SERVER_SEND_RETRY_INTERVAL;
+    // encrypted datagrams kept per address family while the socket buffer is full
+    static const int        RPC_SERVER_OUTBOUND_QUEUE_CAPACITY;
+    static const int        RPC_SERVER_INBOUND_QUEUE_CAPACITY;
+    static const int        RPC_SERVER_DECODE_QUEUE_CAPACITY;
+    // signature verification workers: pending records and results per executor job
+    static const int        SIGNATURE_VERIFY_QUEUE_CAPACITY;
+    static const int        SIGNATURE_VERIFY_BATCH_SIZE;
+    // recently verified signed records, see VerifiedRecords
+    static const int        VERIFIED_RECORDS_CAPACITY;
+    // recycled objects kept per message class, see ObjectPool
+    static const int        MESSAGE_POOL_CAPACITY;
 
     ///////////////////////////////////////////////////////////////////////////
     // Task & Lookup constants
@@ -80,11 +102,24 @@ struct Constants {
     // Tokens and data storage constants
     ///////////////////////////////////////////////////////////////////////////
     static const int        STORAGE_EXPIRE_INTERVAL;
+    static const int        STORAGE_EXPIRE_CHUNK_SIZE;
+    static const int        STORAGE_EXPIRE_CHUNK_INTERVAL;
+    static const int        STORAGE_COMMIT_INTERVAL;
+    static const int        STORAGE_COMMIT_BATCH_SIZE;
+    static const int        STORAGE_READ_BUSY_TIMEOUT;
+    static const int        STORAGE_CACHE_CAPACITY;
+    static const int        STORAGE_CACHE_TTL;
     static const int        TOKEN_TIMEOUT;
     static const int        MAX_PEER_AGE;
     static const int        MAX_VALUE_AGE;
     static const int        RE_ANNOUNCE_INTERVAL;
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Crypto context cache constants
+    ///////////////////////////////////////////////////////////////////////////
+    static const int        CRYPTO_CACHE_CAPACITY;
+    static const int        CRYPTO_CACHE_SHARDS;
+
     ///////////////////////////////////////////////////////////////////////////
     // Node software name and version
     ///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "boson/blob.h"
+
+namespace boson {
+
+// SipHash-2-4: keyed MAC for short inputs, much cheaper than a SHA-256 digest
+class SipHash {
+public:
+    static const uint32_t BYTES { 8 };
+    static const uint32_t KEY_BYTES { 16 };
+
+    using Key = std::array<uint8_t, KEY_BYTES>;
+
+    static uint64_t digest(const Blob& data, const Key& key);
+};
+
+} // namespace boson
@@ -30,12 +30,13 @@
 
 namespace boson {
 
-class CryptoCache : public LocadingCache<Id, CryptoContext> {
+class CryptoCache : public LoadingCache<Id, CryptoContext> {
 public:
     static const int EXPIRED_CHECK_INTERVAL = 60 * 1000;
 
-    CryptoCache(CryptoBox::KeyPair _keypair)
-        : keypair(_keypair), LocadingCache(Constants::KBUCKET_OLD_AND_STALE_TIME) {}
+    CryptoCache(CryptoBox::KeyPair _keypair, size_t capacity = Constants::CRYPTO_CACHE_CAPACITY)
+        : LoadingCache(capacity, Constants::KBUCKET_OLD_AND_STALE_TIME, Constants::CRYPTO_CACHE_SHARDS),
+          keypair(_keypair) {}
 
 private:
     CryptoContext load(const Id& key) override {
@@ -43,11 +44,6 @@ private:
         return CryptoContext(encryptedPublicKey, keypair);
     };
 
-    void onRemoval(const CryptoContext& val) override {
-        //Don't need to close in native.
-        // val.close();
-    }
-
     CryptoBox::KeyPair keypair;
 };
 
@@ -31,8 +31,8 @@ class CryptoContext
 {
 public:
     CryptoContext() {};
-    CryptoContext(const CryptoContext& cc) : box(cc.box), nonce(cc.nonce) {}
-    CryptoContext(CryptoContext&& cc) : box(cc.box), nonce(cc.nonce) {
+    CryptoContext(const CryptoContext& cc) = delete;
+    CryptoContext(CryptoContext&& cc) noexcept : box(cc.box), nonce(cc.nonce) {
         cc.box.clear();
         cc.nonce.clear();
     }
@@ -43,11 +43,8 @@ public:
         nonce.clear();
     };
 
-    CryptoContext& operator=(const CryptoContext& cc) noexcept {
-        box = cc.box;
-        nonce = cc.nonce;
-        return *this;
-    }
+    // Holds the precomputed shared key: moved, never copied
+    CryptoContext& operator=(const CryptoContext& cc) = delete;
 
     CryptoContext& operator=(CryptoContext&& cc) noexcept {
         box = cc.box;
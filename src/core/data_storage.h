@@ -23,7 +23,10 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
+#include <stdexcept>
+#include <string>
 
 #include "boson/id.h"
 #include "boson/value.h"
@@ -59,7 +62,45 @@ public:
     virtual std::vector<PeerInfo> getPersistentPeers(uint64_t lastAnnounceBefore) = 0;
     virtual std::vector<Id> getAllPeers() = 0;
 
+    // getValue() and getPeer() for a cache in front of the storage: they also tell
+    // when the result ages out of the storage, the earliest record for the peers.
+    // A storage that can't tell leaves the expiration at 0.
+    virtual Sp<Value> loadValue(const Id& valueId, uint64_t& expiration) {
+        expiration = 0;
+        return getValue(valueId);
+    }
+    virtual std::vector<PeerInfo> loadPeers(const Id& peerId, int maxPeers, uint64_t& expiration) {
+        expiration = 0;
+        return getPeer(peerId, maxPeers);
+    }
+
+    // Runs a group of writes as one unit, backends without transactions just run them
+    virtual void transaction(const std::function<void()>& writes) {
+        writes();
+    }
+
+    // Runtime statistics of the storage, empty if it has none
+    virtual std::string toString() const {
+        return {};
+    }
+
     virtual void close() = 0;
+
+protected:
+    // Throws if the stored value may not be replaced by the given one
+    static void checkReplace(const Sp<Value>& old, const Value& value, int expectedSeq) {
+        if (old == nullptr || !old->isMutable())
+            return;
+
+        if(!value.isMutable())
+            throw std::invalid_argument("Can not replace mutable value with immutable is not supported");
+        if (old->hasPrivateKey() && !value.hasPrivateKey())
+            throw std::invalid_argument("Not the owner of value");
+        if(value.getSequenceNumber() < old->getSequenceNumber())
+            throw std::invalid_argument("Sequence number less than current");
+        if(expectedSeq >= 0 && old->getSequenceNumber() >= 0 && old->getSequenceNumber() != expectedSeq)
+            throw std::invalid_argument("CAS failure");
+    }
 };
 
 } // namespace boson
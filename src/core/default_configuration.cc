@@ -21,8 +21,11 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <memory>
+#include <set>
 #include <sys/stat.h>
 
 #include "utils/addr.h"
@@ -49,6 +52,47 @@ void Builder::setStoragePath(const std::string& path) {
     this->storagePath = !path.empty() ? expanduser(path) : path;
 }
 
+static std::string toUpper(const std::string& str) {
+    std::string upper {str};
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) {
+        return std::toupper(c);
+    });
+    return upper;
+}
+
+void Builder::setStorageBackend(const std::string& backend) {
+    static const std::set<std::string> backends { "sqlite", "memory" };
+
+    std::string value {backend};
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
+        return std::tolower(c);
+    });
+    if (backends.find(value) == backends.end())
+        throw std::invalid_argument("Invalid storage backend: " + backend);
+
+    this->backend = value;
+}
+
+void Builder::setStorageJournalMode(const std::string& mode) {
+    static const std::set<std::string> modes { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF" };
+
+    auto value = toUpper(mode);
+    if (modes.find(value) == modes.end())
+        throw std::invalid_argument("Invalid storage journal mode: " + mode);
+
+    this->journalMode = value;
+}
+
+void Builder::setStorageSynchronous(const std::string& synchronous) {
+    static const std::set<std::string> levels { "OFF", "NORMAL", "FULL", "EXTRA" };
+
+    auto value = toUpper(synchronous);
+    if (levels.find(value) == levels.end())
+        throw std::invalid_argument("Invalid storage synchronous: " + synchronous);
+
+    this->synchronous = value;
+}
+
 void Builder::load(const std::string& filePath) {
     const auto& path = expanduser(filePath);
     if (path.empty())
@@ -86,6 +130,36 @@ void Builder::load(const std::string& filePath) {
     if (root.contains("dataDir"))
         setStoragePath(root["dataDir"].get<std::string>());
 
+    if (root.contains("receiveWorkers"))
+        setReceiveWorkers(root["receiveWorkers"].get<int>());
+
+    if (root.contains("packetWorkers"))
+        setPacketWorkers(root["packetWorkers"].get<int>());
+
+    if (root.contains("verifyWorkers"))
+        setVerifyWorkers(root["verifyWorkers"].get<int>());
+
+    if (root.contains("storage")) {
+        const auto storage = root["storage"];
+        if (!storage.is_object())
+            throw std::invalid_argument("Config file error: storage");
+
+        if (storage.contains("backend"))
+            setStorageBackend(storage["backend"].get<std::string>());
+
+        if (storage.contains("journalMode"))
+            setStorageJournalMode(storage["journalMode"].get<std::string>());
+
+        if (storage.contains("synchronous"))
+            setStorageSynchronous(storage["synchronous"].get<std::string>());
+
+        if (storage.contains("mmapSize"))
+            setStorageMmapSize(storage["mmapSize"].get<int64_t>());
+
+        if (storage.contains("cacheSize"))
+            setStorageCacheSize(storage["cacheSize"].get<int>());
+    }
+
     if (root.contains("logger")) {
         auto logSettings = root["logger"].get<nlohmann::json>();
         Logger::setDefaultSettings(jsonToAny(logSettings));
@@ -147,6 +221,14 @@ void Builder::reset() {
     storagePath = {};
     bootstrapNodes.clear();
     addons.clear();
+    rxWorkers = 0;
+    decodeWorkers = 0;
+    verifiers = 0;
+    backend = "sqlite";
+    journalMode = "WAL";
+    synchronous = "NORMAL";
+    mmapSize = 0;
+    cacheSize = 0;
 }
 
 Sp<Configuration> Builder::build() {
@@ -157,6 +239,14 @@ Sp<Configuration> Builder::build() {
         ip6 = getLocalIPv6();
 
     auto dataStorage = std::make_shared<DefaultConfiguration>(ip4, ip6,  port, storagePath, bootstrapNodes, addons);
+    dataStorage->rxWorkers = rxWorkers;
+    dataStorage->decodeWorkers = decodeWorkers;
+    dataStorage->verifiers = verifiers;
+    dataStorage->backend = backend;
+    dataStorage->journalMode = journalMode;
+    dataStorage->synchronous = synchronous;
+    dataStorage->mmapSize = mmapSize;
+    dataStorage->cacheSize = cacheSize;
     return std::static_pointer_cast<Configuration>(dataStorage);
 }
 
@@ -29,6 +29,7 @@
 
 #include "utils/time.h"
 #include "utils/log.h"
+#include "utils/log_formatters.h"
 #include "task/node_lookup.h"
 #include "task/task_manager.h"
 #include "task/value_lookup.h"
@@ -63,7 +64,7 @@ namespace boson {
 void DHT::BootstrapStage::updateConnectionStatus() {
     std::unique_lock<std::mutex> lock(mtx);
 
-    dht->log->debug("BootstrapStage {}: [{}, {}]", dht->getNode().getId().toString(),
+    dht->log->debug("BootstrapStage {}: [{}, {}]", dht->getNode().getId(),
         _fillHomeBucket.toString(), _fillAllBuckets.toString());
 
     if (dht->routingTable.getNumBucketEntries() == 0)
@@ -211,6 +212,7 @@ void DHT::fillHomeBucket(const std::list<Sp<NodeInfo>>& nodes) {
     auto task = std::make_shared<NodeLookup>(this, node.getId());
     task->setBootstrap(true);
     task->setName("Bootstrap: filling home bucket");
+    task->setPriority(RPCCall::Priority::MAINTENANCE);
     task->injectCandidates(nodes);
     task->addListener([&](Task* t) {
         bootstrapping = false;
@@ -317,6 +319,7 @@ void DHT::start(std::vector<Sp<NodeInfo>>& nodes) {
         auto task = std::make_shared<NodeLookup>(this, Id::random());
         task->addListener([](Task* t) {});
         task->setName(type.toString() + ":Random Refresh Lookup");
+        task->setPriority(RPCCall::Priority::MAINTENANCE);
         taskMan.add(task);
     }, Constants::RANDOM_LOOKUP_INTERVAL, Constants::RANDOM_LOOKUP_INTERVAL);
 }
@@ -425,6 +428,11 @@ void DHT::received(Sp<Message> msg) {
     if (call != nullptr) {
         newEntry->signalResponse();
         newEntry->mergeRequestTime(call->getSentTime());
+        // the new entry is merged into the existing one, which keeps its own estimate
+        if (old != nullptr)
+            old->signalRTT(call->getRTT());
+        else
+            newEntry->signalRTT(call->getRTT());
     } else if (old == nullptr) {
         // Verify this new node, speedup the bootstrap process
         auto q = std::make_shared<PingRequest>();
@@ -483,14 +491,16 @@ void DHT::onError(Sp<Message> msg) {
 }
 
 void DHT::onPing(const Sp<Message>& msg) {
-    auto response = std::make_shared<PingResponse>(msg->getTxid());
+    auto response = Message::acquire<PingResponse>();
+    response->setTxid(msg->getTxid());
     response->setRemote(msg->getId(), msg->getOrigin());
     rpcServer->sendMessage(response);
 }
 
 void DHT::onFindNode(const Sp<Message>& msg) {
     auto request = std::dynamic_pointer_cast<FindNodeRequest>(msg);
-    auto response = std::make_shared<FindNodeResponse>(msg->getTxid());
+    auto response = Message::acquire<FindNodeResponse>();
+    response->setTxid(msg->getTxid());
 
     int want4 = request->doesWant4() ? Constants::MAX_ENTRIES_PER_BUCKET : 0;
     int want6 = request->doesWant6() ? Constants::MAX_ENTRIES_PER_BUCKET : 0;
@@ -508,7 +518,8 @@ void DHT::onFindNode(const Sp<Message>& msg) {
 void DHT::onFindValue(const Sp<Message>& msg) {
     auto request = std::dynamic_pointer_cast<FindValueRequest>(msg);
 
-    auto response = std::make_shared<FindValueResponse>(msg->getTxid());
+    auto response = Message::acquire<FindValueResponse>();
+    response->setTxid(msg->getTxid());
 
     auto token = tokenManager->generateToken(request->getId(), request->getOrigin(), node.getId());
     response->setToken(token);
@@ -543,21 +554,34 @@ void DHT::onStoreValue(const Sp<Message>& msg) {
         return;
     }
 
-    if (!value.isValid()) {
-        sendError(request, ErrorCode::ProtocolError, "Invalid value");
-        return;
-    }
+    rpcServer->getVerifier().verify(value, [this, request, value, valueId](bool valid) {
+        if (!valid) {
+            sendError(request, ErrorCode::ProtocolError, "Invalid value");
+            return;
+        }
 
-    node.getStorage()->putValue(value, request->getExpectedSequenceNumber());
+        try {
+            node.getStorage()->putValue(value, request->getExpectedSequenceNumber());
+        } catch (const std::invalid_argument& e) {
+            sendError(request, ErrorCode::ProtocolError, e.what());
+            return;
+        } catch (const std::exception& e) {
+            log->error("Failed to store value {}: {}", valueId, e.what());
+            sendError(request, ErrorCode::ServerError, "Failed to store the value");
+            return;
+        }
 
-    auto response = std::make_shared<StoreValueResponse>(request->getTxid());
-    response->setRemote(request->getId(), request->getOrigin());
-    rpcServer->sendMessage(response);
+        auto response = Message::acquire<StoreValueResponse>();
+        response->setTxid(request->getTxid());
+        response->setRemote(request->getId(), request->getOrigin());
+        rpcServer->sendMessage(response);
+    });
 }
 
 void DHT::onFindPeers(const Sp<Message>& msg) {
     auto request = std::static_pointer_cast<FindPeerRequest>(msg);
-    auto response = std::make_shared<FindPeerResponse>(msg->getTxid());
+    auto response = Message::acquire<FindPeerResponse>();
+    response->setTxid(msg->getTxid());
 
     auto storage = node.getStorage();
     auto target = request->getTarget();
@@ -603,13 +627,27 @@ void DHT::onAnnouncePeer(const Sp<Message>& msg) {
 
 
     auto peer = request->getPeer();
-    log->debug("Received an announce peer request from {}, saving peer {}", request->getOrigin().toString(),
-                request->getTarget().toString());
-    node.getStorage()->putPeer(peer);
+    rpcServer->getVerifier().verify({peer}, [this, request, peer](bool valid) {
+        if (!valid) {
+            sendError(request, ErrorCode::ProtocolError, "Invalid peer");
+            return;
+        }
 
-    auto response = std::make_shared<AnnouncePeerResponse>(request->getTxid());
-    response->setRemote(request->getId(), request->getOrigin());
-    rpcServer->sendMessage(response);
+        log->debug("Received an announce peer request from {}, saving peer {}", request->getOrigin(),
+                    request->getTarget());
+        try {
+            node.getStorage()->putPeer(peer);
+        } catch (const std::exception& e) {
+            log->error("Failed to save peer {}: {}", peer.getId(), e.what());
+            sendError(request, ErrorCode::ServerError, "Failed to save the peer");
+            return;
+        }
+
+        auto response = Message::acquire<AnnouncePeerResponse>();
+        response->setTxid(request->getTxid());
+        response->setRemote(request->getId(), request->getOrigin());
+        rpcServer->sendMessage(response);
+    });
 }
 
 void DHT::onTimeout(RPCCall* call) {
@@ -683,7 +721,7 @@ Sp<Task> DHT::findNode(const Id& id, LookupOption option, std::function<void(Sp<
         completeHandler(*nodeRef);
     });
     task->setName("User-level node lookup");
-    taskMan.add(task);
+    submitTask(task);
     return task;
 }
 
@@ -706,7 +744,7 @@ Sp<Task> DHT::findValue(const Id& id, LookupOption option, std::function<void(Sp
         completeHandler(*valuePtr);
     });
     task->setName("User-level value lookup");
-    taskMan.add(task);
+    submitTask(task);
     return task;
 }
 
@@ -735,11 +773,11 @@ Sp<Task> DHT::storeValue(const Value& value, std::function<void(std::list<Sp<Nod
         });
         announce->setName("Nested value Store");
         t->setNestedTask(announce);
-        taskMan.add(announce);
+        submitTask(announce);
     });
 
     task->setName("StoreValue task");
-    taskMan.add(task);
+    submitTask(task);
     return task;
 }
 
@@ -761,7 +799,7 @@ Sp<Task> DHT::findPeer(const Id& id, int expected, LookupOption option, std::fun
     });
 
     task->setName("User-level peer lookup");
-    taskMan.add(task);
+    submitTask(task);
     return task;
 }
 
@@ -791,29 +829,37 @@ Sp<Task> DHT::announcePeer(const PeerInfo& peer, const std::function<void(std::l
         announce->setName("Nested peer announce");
 
         t->setNestedTask(announce);
-        taskMan.add(announce);
+        submitTask(announce);
     });
 
     task->setName("AnoouncePeer Task");
-    taskMan.add(task);
+    submitTask(task);
     return task;
 }
 
+void DHT::submitTask(Sp<Task> task) {
+    taskMan.add(task);
+
+    // User-level tasks are usually submitted from the application threads, start
+    // them on the rx thread right away instead of on the next maintenance round.
+    rpcServer->post([this]() {
+        taskMan.dequeue();
+    });
+}
+
 void DHT::populateClosestNodes(Sp<LookupResponse> response, const Id& target, int v4, int v6) {
     if (v4 > 0) {
         auto& dht4 = (type == Network::IPv4) ? *this : *node.getDHT(Network::IPv4);
-        auto kclosestNodes = std::make_shared<KClosestNodes>(dht4, target, v4);
-        kclosestNodes->fill(type == Network::IPv4);
-        auto nodes = kclosestNodes->asNodeList();
-        response->setNodes4(nodes);
+        KClosestNodes kclosestNodes(dht4, target, v4);
+        kclosestNodes.fill(type == Network::IPv4);
+        response->setNodes4(kclosestNodes.getEntries());
     }
 
     if (v6 > 0) {
         auto& dht6 = (type == Network::IPv6) ? *this : *node.getDHT(Network::IPv6);
-        auto kclosestNodes = std::make_shared<KClosestNodes>(dht6, target, v6);
-        kclosestNodes->fill(type == Network::IPv6);
-        auto nodes = kclosestNodes->asNodeList();
-        response->setNodes6(nodes);
+        KClosestNodes kclosestNodes(dht6, target, v6);
+        kclosestNodes.fill(type == Network::IPv6);
+        response->setNodes6(kclosestNodes.getEntries());
     }
 }
 
@@ -234,6 +234,8 @@ private:
 
     void populateClosestNodes(Sp<LookupResponse> r, const Id& target, int v4, int v6);
 
+    void submitTask(Sp<Task> task);
+
     void setStatus(ConnectionStatus expected, ConnectionStatus newStatus);
 
 private:
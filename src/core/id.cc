@@ -25,6 +25,16 @@
 #include <climits>
 #include <string>
 #include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define BOSON_ID_SIMD
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #include "boson/id.h"
 #include "utils/random_generator.h"
@@ -34,6 +44,75 @@
 
 namespace boson {
 
+namespace {
+
+/*
+ * Id kernels. An id is 32 bytes, i.e. four 64-bit words or one/two SIMD
+ * registers, so the comparisons on the routing hot paths reduce to a
+ * single mismatch scan instead of a byte loop.
+ */
+
+inline int lowestSetBit(uint32_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, v);
+    return (int)index;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+inline uint64_t loadWord(const uint8_t* p) {
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+inline void storeWord(uint8_t* p, uint64_t w) {
+    std::memcpy(p, &w, sizeof(w));
+}
+
+#ifndef BOSON_ID_SIMD
+inline int firstDiffByte(uint64_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_clzll(x) >> 3;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)(index >> 3);
+#else
+    return __builtin_ctzll(x) >> 3;
+#endif
+}
+#endif
+
+// Index of the first byte that differs between a and b, ID_BYTES if equal.
+inline int mismatch(const uint8_t* a, const uint8_t* b) {
+#if defined(__AVX2__)
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    uint32_t eq = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+    return eq == 0xFFFFFFFFu ? ID_BYTES : lowestSetBit(~eq);
+#elif defined(BOSON_ID_SIMD)
+    __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    __m128i y0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16));
+    __m128i y1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16));
+    uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x0, y0)) |
+            ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x1, y1)) << 16);
+    return eq == 0xFFFFFFFFu ? ID_BYTES : lowestSetBit(~eq);
+#else
+    for (int i = 0; i < ID_BYTES; i += 8) {
+        uint64_t x = loadWord(a + i) ^ loadWord(b + i);
+        if (x != 0)
+            return i + firstDiffByte(x);
+    }
+    return ID_BYTES;
+#endif
+}
+
+} // namespace
+
 Id Id::MIN_ID = Id::zero();
 Id Id::MAX_ID = Id::ofHex("0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF");
 
@@ -65,11 +144,11 @@ Id Id::random() {
 }
 
 Id Id::distance(const Id& to) const {
-    std::vector<uint8_t> buf(ID_BYTES);
-    for (int i = 0; i < ID_BYTES; i++)
-        buf[i] = bytes[i] ^ to.bytes[i];
+    Id result;
+    for (int i = 0; i < ID_BYTES; i += 8)
+        storeWord(result.bytes.data() + i, loadWord(bytes.data() + i) ^ loadWord(to.bytes.data() + i));
 
-    return Id(buf);
+    return result;
 }
 
 Id Id::distance(const Id& id1, const Id& id2) {
@@ -77,14 +156,8 @@ Id Id::distance(const Id& id1, const Id& id2) {
 }
 
 int Id::threeWayCompare(const Id &id1, const Id &id2) const {
-    int mmi = -1;
-    for (int i = 0; i < ID_BYTES; i++) {
-        if (id1.bytes[i] != id2.bytes[i]) {
-            mmi = i;
-            break;
-        }
-    }
-    if (mmi == -1) return 0;
+    int mmi = mismatch(id1.bytes.data(), id2.bytes.data());
+    if (mmi == ID_BYTES) return 0;
 
     uint8_t a = id1.bytes[mmi] ^ bytes[mmi];
     uint8_t b = id2.bytes[mmi] ^ bytes[mmi];
@@ -101,14 +174,7 @@ bool Id::bitsEqual(const Id& id1, const Id& id2, int n) {
     if (n < 0)
         return true;
 
-    int mmi = INT_MAX;
-    for (int i = 0; i < ID_BYTES; i++) {
-        if (id1.bytes[i] != id2.bytes[i]) {
-            mmi = i;
-            break;
-        }
-    }
-
+    int mmi = mismatch(id1.bytes.data(), id2.bytes.data());
     int indexToCheck = n >> 3;
 
     uint8_t diff = (id1.bytes[indexToCheck] ^ id2.bytes[indexToCheck]);
@@ -168,7 +234,8 @@ int Id::getLeadingZeros() {
 }
 
 bool Id::operator<(const Id& other) const {
-    return std::lexicographical_compare(bytes.begin(), bytes.end(), other.bytes.begin(), other.bytes.end());
+    int mmi = mismatch(bytes.data(), other.bytes.data());
+    return mmi != ID_BYTES && bytes[mmi] < other.bytes[mmi];
 }
 
 std::string Id::toHexString() const {
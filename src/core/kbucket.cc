@@ -22,7 +22,6 @@
 
 #include <sstream>
 
-#include "utils/list.h"
 #include "kbucket.h"
 #include "messages/message.h"
 
@@ -61,7 +60,7 @@ void KBucket::_put(Sp<KBucketEntry> newEntry) {
             return;
 
         // try to check the youngest entry
-        auto youngest = list_get(entriesRef, entriesRef.size() - 1);
+        auto youngest = entriesRef.back();
 
         // older entries displace younger ones (although that kind of stuff should
         // probably go through #update directly)
@@ -89,11 +88,8 @@ bool KBucket::_replaceBadEntry(Sp<KBucketEntry> newEntry) {
 void KBucket::_removeIfBad(Sp<KBucketEntry> toRemove, bool force) {
     assert(toRemove);
 
-    if ((force || toRemove->needsReplacement()) && anyMatch([&](Sp<KBucketEntry>& entry) {
-        return entry->getId() == toRemove->getId();
-    })) {
+    if ((force || toRemove->needsReplacement()) && exists(toRemove->getId()))
         _update(toRemove, nullptr);
-    }
 }
 
 void KBucket::_update(Sp<KBucketEntry> toRefresh) {
@@ -108,84 +104,86 @@ void KBucket::_update(Sp<KBucketEntry> toRefresh) {
 }
 
 void KBucket::_update(Sp<KBucketEntry> toRemove, Sp<KBucketEntry> toInsert) {
-    if (toInsert != nullptr && anyMatch([&](Sp<KBucketEntry>& entry) {
+    if (toInsert != nullptr && anyMatch([&](const Sp<KBucketEntry>& entry) {
         return toInsert->matches(*entry);
     })) {
         return;
     }
 
-    std::list<Sp<KBucketEntry>> newEntries { getEntries() };
-    bool removed { false };
-    bool added { false };
-
     // removal never violates ordering constraint, no checks required
     if (toRemove != nullptr) {
-        newEntries.remove(toRemove);
-        removed = true;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i] == toRemove) {
+                eraseEntry(i);
+                break;
+            }
+        }
     }
 
     if (toInsert != nullptr) {
-        int oldSize = newEntries.size();
-        bool wasFull = oldSize >= Constants::MAX_ENTRIES_PER_BUCKET;
-        auto youngest = oldSize > 0 ? list_get(newEntries, oldSize - 1) : nullptr;
-        bool unorderedInsert = youngest != nullptr && toInsert->getCreationTime() < youngest->getCreationTime();
-
-        added = !wasFull || unorderedInsert;
-        if (added) {
-            newEntries.push_back(toInsert);
-        }
+        bool wasFull = entries.size() >= Constants::MAX_ENTRIES_PER_BUCKET;
+        bool unorderedInsert = !entries.empty() && toInsert->getCreationTime() < entries.back()->getCreationTime();
+        if (wasFull && !unorderedInsert)
+            return;
+
+        // an older entry displaces the youngest one of a full bucket
+        if (wasFull)
+            eraseEntry(entries.size() - 1);
 
+        // keep the creation time order, after the entries of the same age
+        size_t index = entries.size();
         if (unorderedInsert) {
-            auto sortKBucketEntry = [](Sp<KBucketEntry> a, Sp<KBucketEntry> b) -> bool {
-                return a->getCreationTime() < b->getCreationTime();
-            };
-            newEntries.sort(sortKBucketEntry);
+            while (index > 0 && toInsert->getCreationTime() < entries[index - 1]->getCreationTime())
+                index--;
         }
-
+        insertEntry(index, toInsert);
     }
+}
 
-    // make changes visible
-    if (added || removed) {
-        setEntries(newEntries);
-    }
+void KBucket::insertEntry(size_t index, Sp<KBucketEntry> entry) {
+    for (size_t i = entries.size(); i > index; i--)
+        ids[i] = ids[i - 1];
+    ids[index] = entry->getId();
+    entries.insert(index, std::move(entry));
+}
+
+void KBucket::eraseEntry(size_t index) {
+    for (size_t i = index + 1; i < entries.size(); i++)
+        ids[i - 1] = ids[i];
+    ids[entries.size() - 1] = Id();
+    entries.erase(index);
 }
 
 void KBucket::_notifyOfResponse(Sp<Message>& msg) {
     if (msg->getType() != Message::Type::RESPONSE || !msg->getAssociatedCall())
         return;
 
-    for (auto& entry: getEntries()) {
-        if (entry->getId() == msg->getId()) {
-            entry->signalResponse();
-            return;
-        }
-    }
+    int index = indexOf(msg->getId());
+    if (index >= 0)
+        entries[index]->signalResponse();
 }
 
 void KBucket::_onTimeout(const Id& id) {
-    for (auto& entry: getEntries()) {
-        if (entry->getId() == id) {
-            entry->signalRequestTimeout();
+    int index = indexOf(id);
+    if (index < 0)
+        return;
 
-            // NOTICE: Test only - merge buckets
-            //   remove when the entry needs replacement
-            // _removeIfBad(entry, false);
+    auto entry = entries[index];
+    entry->signalRequestTimeout();
 
-            // NOTICE: Product
-            //   only removes the entry if it is bad
-            _removeIfBad(entry, false);
-            return;
-        }
-    }
+    // NOTICE: Test only - merge buckets
+    //   remove when the entry needs replacement
+    // _removeIfBad(entry, false);
+
+    // NOTICE: Product
+    //   only removes the entry if it is bad
+    _removeIfBad(entry, false);
 }
 
 void KBucket::_onSend(const Id& id) {
-    for (auto& entry: getEntries()) {
-        if (entry->getId() == id) {
-            entry->signalRequest();
-            return;
-        }
-    }
+    int index = indexOf(id);
+    if (index >= 0)
+        entries[index]->signalRequest();
 }
 
 std::string KBucket::toString() const {
@@ -23,11 +23,13 @@
 
 #pragma once
 
-#include <list>
+#include <array>
+#include <cassert>
 #include <memory>
 
 #include "boson/prefix.h"
 #include "boson/types.h"
+#include "utils/fixed_vector.h"
 #include "utils/random_generator.h"
 #include "utils/log.h"
 #include "constants.h"
@@ -40,10 +42,15 @@ class Message;
 /**
  * A KBucket is just a list of KBucketEntry objects.
  *
- * The list is sorted by time last seen : The first element is the least
- * recently seen, the last the most recently seen.
+ * The list is sorted by creation time : The first element is the oldest
+ * entry, the last the youngest.
  *
- * This is a lock-free k-bucket implementation.
+ * The entries are stored inline with a fixed capacity, and the ids are kept
+ * in a parallel array so lookups by id compare contiguous memory instead of
+ * chasing the entry pointers. Nothing here allocates after construction.
+ *
+ * A bucket takes no locks and its entries are updated in place, so it must
+ * only be used from the thread that runs the routing table.
  *
  * CAUTION:
  *   All methods name leading with _ means that method will WRITE the
@@ -56,7 +63,13 @@ class Message;
  */
 class KBucket {
 public:
+    // Must not be below Constants::MAX_ENTRIES_PER_BUCKET
+    static constexpr size_t CAPACITY = 8;
+
+    using Entries = FixedVector<Sp<KBucketEntry>, CAPACITY>;
+
     KBucket(const Prefix& _prefix, bool isHome): prefix(_prefix), homeBucket(isHome) {
+        assert(Constants::MAX_ENTRIES_PER_BUCKET <= (int)CAPACITY);
         log = Logger::get("KBucket");
     }
 
@@ -70,7 +83,7 @@ public:
         return homeBucket;
     }
 
-    const std::list<Sp<KBucketEntry>>& getEntries() const noexcept {
+    const Entries& getEntries() const noexcept {
         return entries;
     }
 
@@ -87,38 +100,34 @@ public:
         if (entriesRef.empty())
             return nullptr;
 
-        auto it = std::next(entriesRef.begin(), RandomGenerator<int>(0, entriesRef.size() - 1)());
-        return *it;
+        return entriesRef[RandomGenerator<int>(0, entriesRef.size() - 1)()];
     }
 
     Sp<KBucketEntry> get(const Id& id) const noexcept {
-        return findAny([&](Sp<KBucketEntry>& entry) {
-            return entry->getId() == id;
-        });
+        int index = indexOf(id);
+        return index < 0 ? nullptr : entries[index];
     }
 
     Sp<KBucketEntry> find(const Id& id, const SocketAddress& addr) const noexcept {
-        return findAny([&](Sp<KBucketEntry>& entry) {
+        return findAny([&](const Sp<KBucketEntry>& entry) {
             return entry->getId() == id || entry->getAddress() == addr;
         });
     }
 
     bool exists(const Id& id) const noexcept {
-        return anyMatch([&](Sp<KBucketEntry>& entry) {
-            return entry->getId() == id;
-        });
+        return indexOf(id) >= 0;
     }
 
     bool needsToBeRefreshed() const {
         uint64_t now = currentTimeMillis();
         return now - lastRefresh > Constants::BUCKET_REFRESH_INTERVAL
-            && anyMatch([](Sp<KBucketEntry>& entry) {
+            && anyMatch([](const Sp<KBucketEntry>& entry) {
                 return entry->needsPing();
             });
     }
 
     bool needsReplacement() {
-        return anyMatch([](Sp<KBucketEntry>& entry) {
+        return anyMatch([](const Sp<KBucketEntry>& entry) {
             return entry->needsReplacement();
         });
     }
@@ -146,25 +155,36 @@ private:
     void _update(Sp<KBucketEntry> toRemove, Sp<KBucketEntry> toInsert);
     void _notifyOfResponse(Sp<Message>&);
 
-    Sp<KBucketEntry> findAny(std::function<bool(Sp<KBucketEntry>&)> predicate) const {
-        for (auto entry: getEntries()) {
+    int indexOf(const Id& id) const noexcept {
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (ids[i] == id)
+                return i;
+        }
+        return -1;
+    }
+
+    template <typename Predicate>
+    Sp<KBucketEntry> findAny(Predicate&& predicate) const {
+        for (const auto& entry: getEntries()) {
             if (predicate(entry))
                 return entry;
         }
         return nullptr;
     }
-    inline bool anyMatch(std::function<bool(Sp<KBucketEntry>&)> predicate) const {
-        return findAny(std::move(predicate)) != nullptr;
-    }
 
-    void setEntries(const std::list<Sp<KBucketEntry>>& entries) noexcept {
-        this->entries = entries;
+    template <typename Predicate>
+    inline bool anyMatch(Predicate&& predicate) const {
+        return findAny(std::forward<Predicate>(predicate)) != nullptr;
     }
 
+    void insertEntry(size_t index, Sp<KBucketEntry> entry);
+    void eraseEntry(size_t index);
+
     const Prefix prefix;
     bool homeBucket { false };
 
-    std::list<Sp<KBucketEntry>> entries {};
+    Entries entries {};
+    std::array<Id, CAPACITY> ids {};
     uint64_t lastRefresh {0};
 
     Sp<Logger> log;
@@ -63,6 +63,9 @@ void KBucketEntry::merge(Sp<KBucketEntry> other) {
 
     if (other->getFailedRequests() > 0)
         failedRequests = std::min(failedRequests, other->getFailedRequests());
+
+    if (!rtt.hasSamples())
+        rtt = other->getRTTEstimator();
 }
 
 bool KBucketEntry::withinBackoffWindow(uint64_t now) const {
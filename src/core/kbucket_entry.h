@@ -29,6 +29,7 @@
 #include "boson/node_info.h"
 #include "utils/time.h"
 #include "constants.h"
+#include "rtt_estimator.h"
 
 namespace boson {
 
@@ -73,6 +74,10 @@ public:
         return reachable;
     }
 
+    const RTTEstimator& getRTTEstimator() const noexcept {
+        return rtt;
+    }
+
     bool isNeverContacted() const noexcept {
         return lastSend == 0;
     }
@@ -128,6 +133,10 @@ public:
         reachable = true;
     }
 
+    void signalRTT(uint32_t sample) noexcept {
+        rtt.sample(sample);
+    }
+
     void signalRequest() noexcept {
         lastSend = currentTimeMillis();
     }
@@ -144,6 +153,8 @@ public:
             failedRequests = 1;
         else
             failedRequests++;
+
+        rtt.backoff();
     }
 
     static Sp<KBucketEntry> fromJson(nlohmann::json& json);
@@ -183,6 +194,8 @@ private:
 
     bool reachable {false};
     int failedRequests {0};
+
+    RTTEstimator rtt {};
 };
 
 } // namespace boson
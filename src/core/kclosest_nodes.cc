@@ -20,11 +20,12 @@
 * SOFTWARE.
 */
 
+#include <algorithm>
+
 #include "boson/configuration.h"
 #include "boson/prefix.h"
 #include "boson/node.h"
 
-#include "utils/list.h"
 
 #include "dht.h"
 #include "kbucket.h"
@@ -34,44 +35,63 @@
 
 namespace boson {
 
+static inline uint64_t loadBigEndian(const uint8_t* p) {
+    return (uint64_t)p[0] << 56 | (uint64_t)p[1] << 48 | (uint64_t)p[2] << 40 | (uint64_t)p[3] << 32 |
+            (uint64_t)p[4] << 24 | (uint64_t)p[5] << 16 | (uint64_t)p[6] << 8 | (uint64_t)p[7];
+}
+
 KClosestNodes::KClosestNodes(DHT& _dht, const Id& _id, int _maxEntries)
     : KClosestNodes(_dht, _id, _maxEntries, [](const Sp<KBucketEntry>& entry) {
         return entry->isEligibleForNodesList();
 }) {}
 
 KClosestNodes::KClosestNodes(DHT& _dht, const Id& _id, int _maxEntries, std::function<bool(const Sp<KBucketEntry>&)> _filter)
-    : dht(_dht), target(_id), maxEntries(_maxEntries), filter(_filter) {}
+    : dht(_dht), target(_id), maxEntries(std::clamp(_maxEntries, 0, (int)CAPACITY)), filter(_filter) {
+}
+
+KClosestNodes::Distance KClosestNodes::distanceTo(const Id& id) const noexcept {
+    Distance distance;
+    for (size_t i = 0; i < distance.size(); i++)
+        distance[i] = loadBigEndian(target.data() + i * 8) ^ loadBigEndian(id.data() + i * 8);
+    return distance;
+}
 
-void KClosestNodes::insertEntries(Sp<KBucket> bucket) {
+void KClosestNodes::insertEntries(const Sp<KBucket>& bucket) {
     for (const auto& entry: bucket->getEntries()) {
         if (filter(entry))
-            entries.emplace_back(entry);
+            insert(entry);
     }
 }
 
-void KClosestNodes::shave() {
-    int overshoot = entries.size() - maxEntries;
-    if (overshoot <= 0)
+void KClosestNodes::insert(const Sp<KBucketEntry>& entry) {
+    if (maxEntries == 0)
         return;
 
-    entries.sort([&](const Sp<KBucketEntry> &a, const Sp<KBucketEntry>& b) {
-        return target.threeWayCompare(a->getId(), b->getId()) < 0;
-    });
+    auto distance = distanceTo(entry->getId());
+    if (entries.size() < maxEntries) {
+        entries.push_back(entry);
+        distances.push_back(distance);
+        return;
+    }
 
-    auto it = entries.begin();
-    std::advance(it, entries.size() - overshoot);
+    // Full, replace the farthest entry if the new one is closer
+    size_t farthest = 0;
+    for (size_t i = 1; i < distances.size(); i++) {
+        if (distances[farthest] < distances[i])
+            farthest = i;
+    }
 
-    std::list<Sp<KBucketEntry>> obsolete {};
-    obsolete.splice(obsolete.begin(), entries, it, entries.end());
-    // Here obsolete list resource would be freed along with all kbucketEntry
-    // inside.
+    if (distance < distances[farthest]) {
+        entries[farthest] = entry;
+        distances[farthest] = distance;
+    }
 }
 
 void KClosestNodes::fill(bool includeSelf) {
-    auto& buckets = dht.getRoutingTable().getBuckets();
+    auto bucketsRef = dht.getRoutingTable().getBuckets();
+    auto& buckets = *bucketsRef;
     int idx = RoutingTable::indexOf(buckets, target);
-    auto kb = list_get(buckets,idx);
-    insertEntries(kb);
+    insertEntries(buckets[idx]);
 
     int low = idx;
     int high = idx;
@@ -80,10 +100,10 @@ void KClosestNodes::fill(bool includeSelf) {
         Sp<KBucket> highBucket {};
 
         if (low > 0)
-            lowBucket = list_get(buckets, low - 1);
+            lowBucket = buckets[low - 1];
 
         if (high < buckets.size() - 1)
-            highBucket = list_get(buckets, high + 1);
+            highBucket = buckets[high + 1];
 
         if (!lowBucket && !highBucket)
             break;
@@ -114,15 +134,14 @@ void KClosestNodes::fill(bool includeSelf) {
     if (entries.size() < maxEntries) {
         for (const auto& bootstrapNode : dht.getNode().getConfig()->getBootstrapNodes()) {
             if (dht.getType().canUseSocketAddress(bootstrapNode->getAddress()))
-                entries.push_back(std::static_pointer_cast<KBucketEntry>(bootstrapNode));
+                insert(std::static_pointer_cast<KBucketEntry>(bootstrapNode));
         }
     }
 
     if (entries.size() < maxEntries && includeSelf) {
         const auto& sockAddr = dht.getOrigin();
-        entries.push_back(std::make_shared<KBucketEntry>(dht.getNode().getId(), sockAddr));
+        insert(std::make_shared<KBucketEntry>(dht.getNode().getId(), sockAddr));
     }
-    shave();
 }
 
 } // namespace boson
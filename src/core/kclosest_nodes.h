@@ -27,6 +27,7 @@
 #include <algorithm>
 #include "boson/id.h"
 #include "boson/node_info.h"
+#include "utils/fixed_vector.h"
 
 namespace boson {
 
@@ -34,8 +35,19 @@ class DHT;
 class KBucket;
 class KBucketEntry;
 
+/*
+ * Selects the maxEntries entries closest to the target. The selection lives in
+ * inline storage with a parallel array of the precomputed distances, and once
+ * full a candidate only replaces the farthest entry, so a query neither
+ * allocates nor sorts anything. The entries are in no particular order.
+ * maxEntries is clamped to CAPACITY, the most the selection can hold.
+ */
 class KClosestNodes {
 public:
+    static constexpr size_t CAPACITY = 16;
+
+    using Entries = FixedVector<Sp<KBucketEntry>, CAPACITY>;
+
     KClosestNodes(DHT& _dht, const Id& _id, int _maxEntries);
     KClosestNodes(DHT& _dht, const Id& _id, int _maxEntries, std::function<bool(const Sp<KBucketEntry>&)> _filter);
 
@@ -56,7 +68,7 @@ public:
         return entries.size() >= maxEntries;
     }
 
-    const std::list<Sp<KBucketEntry>>& getEntries() const noexcept {
+    const Entries& getEntries() const noexcept {
         return entries;
     }
 
@@ -69,13 +81,18 @@ public:
     }
 
 private:
-    void insertEntries(Sp<KBucket> bucket);
-    void shave();
+    // XOR distance to the target as big-endian words, compared lexicographically
+    using Distance = std::array<uint64_t, ID_BYTES / 8>;
+
+    Distance distanceTo(const Id& id) const noexcept;
+    void insertEntries(const Sp<KBucket>& bucket);
+    void insert(const Sp<KBucketEntry>& entry);
 
     DHT& dht;
     Id target;
 
-    std::list<Sp<KBucketEntry>> entries {};
+    Entries entries {};
+    FixedVector<Distance, CAPACITY> distances {};
     int maxEntries {0};
 
     std::function<bool(const Sp<KBucketEntry>&)> filter;
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "constants.h"
+#include "utils/time.h"
+#include "memory_storage.h"
+
+namespace boson {
+
+Sp<DataStorage> MemoryStorage::open(Scheduler& scheduler) {
+    auto storage = std::make_shared<MemoryStorage>();
+    std::weak_ptr<MemoryStorage> ref = storage;
+    storage->expireJob = scheduler.add([ref]() {
+        if (auto storage = ref.lock())
+            storage->expire(currentTimeMillis());
+    }, 0, Constants::STORAGE_EXPIRE_INTERVAL);
+
+    return std::static_pointer_cast<DataStorage>(storage);
+}
+
+void MemoryStorage::close() {
+    std::lock_guard<std::mutex> lk(lock);
+    // the scheduler outlives the storage, don't leave it jobs pointing here
+    if (expireJob) {
+        expireJob->cancel();
+        expireJob.reset();
+    }
+
+    values.clear();
+    peers.clear();
+    valueExpiry.clear();
+    peerExpiry.clear();
+}
+
+size_t MemoryStorage::expire(uint64_t now) {
+    std::lock_guard<std::mutex> lk(lock);
+    size_t expired = 0;
+
+    // the index is ordered by timestamp, stop at the first live record
+    auto before = now - Constants::MAX_VALUE_AGE;
+    while (!valueExpiry.empty() && valueExpiry.begin()->first < before) {
+        values.erase(valueExpiry.begin()->second);
+        valueExpiry.erase(valueExpiry.begin());
+        expired++;
+    }
+
+    before = now - Constants::MAX_PEER_AGE;
+    while (!peerExpiry.empty() && peerExpiry.begin()->first < before) {
+        const auto& [peerId, key] = peerExpiry.begin()->second;
+        auto it = peers.find(peerId);
+        it->second.erase(key);
+        if (it->second.empty())
+            peers.erase(it);
+
+        peerExpiry.erase(peerExpiry.begin());
+        expired++;
+    }
+
+    return expired;
+}
+
+void MemoryStorage::touch(ValueRecord& record, const Id& valueId, uint64_t timestamp) {
+    if (record.expiry != valueExpiry.end())
+        valueExpiry.erase(record.expiry);
+
+    record.timestamp = timestamp;
+    record.expiry = record.persistent ? valueExpiry.end() : valueExpiry.emplace(timestamp, valueId);
+}
+
+void MemoryStorage::touch(PeerRecord& record, const Id& peerId, const PeerKey& key, uint64_t timestamp) {
+    if (record.expiry != peerExpiry.end())
+        peerExpiry.erase(record.expiry);
+
+    record.timestamp = timestamp;
+    record.expiry = record.persistent ? peerExpiry.end() : peerExpiry.emplace(timestamp, std::make_pair(peerId, key));
+}
+
+const MemoryStorage::ValueRecord* MemoryStorage::findValue(const Id& valueId, uint64_t now) const {
+    auto it = values.find(valueId);
+    if (it == values.end() || it->second.timestamp < now - Constants::MAX_VALUE_AGE)
+        return nullptr;
+    return &it->second;
+}
+
+Sp<Value> MemoryStorage::getValue(const Id& valueId) {
+    uint64_t expiration;
+    return loadValue(valueId, expiration);
+}
+
+Sp<Value> MemoryStorage::loadValue(const Id& valueId, uint64_t& expiration) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto record = findValue(valueId, currentTimeMillis());
+    expiration = record ? record->timestamp + Constants::MAX_VALUE_AGE : 0;
+    return record ? record->value : nullptr;
+}
+
+Sp<Value> MemoryStorage::putValue(const Value& value, int expectedSeq, bool persistent, bool updateLastAnnounce) {
+    if (value.isMutable() && !value.isValid())
+        throw std::invalid_argument("Value signature validation failed");
+
+    std::lock_guard<std::mutex> lk(lock);
+    auto now = currentTimeMillis();
+    auto id = value.getId();
+
+    auto record = findValue(id, now);
+    auto old = record ? record->value : nullptr;
+    checkReplace(old, value, expectedSeq);
+
+    // same as the SQLite upsert: an update keeps the persistent and announce state
+    auto it = values.find(id);
+    if (it == values.end()) {
+        it = values.emplace(id, ValueRecord {nullptr, persistent, now,
+                updateLastAnnounce ? now : 0, valueExpiry.end()}).first;
+    }
+
+    it->second.value = std::make_shared<Value>(value);
+    touch(it->second, id, now);
+    return old;
+}
+
+bool MemoryStorage::removeValue(const Id& valueId) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto it = values.find(valueId);
+    if (it == values.end())
+        return false;
+
+    if (it->second.expiry != valueExpiry.end())
+        valueExpiry.erase(it->second.expiry);
+    values.erase(it);
+    return true;
+}
+
+void MemoryStorage::updateValueLastAnnounce(const Id& valueId) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto it = values.find(valueId);
+    if (it == values.end())
+        return;
+
+    auto now = currentTimeMillis();
+    it->second.announced = now;
+    touch(it->second, valueId, now);
+}
+
+std::vector<Value> MemoryStorage::getPersistentValues(uint64_t lastAnnounceBefore) {
+    std::lock_guard<std::mutex> lk(lock);
+    std::vector<Value> result {};
+    for (const auto& [id, record] : values) {
+        if (record.persistent && record.announced <= lastAnnounceBefore)
+            result.push_back(*record.value);
+    }
+    return result;
+}
+
+std::vector<Id> MemoryStorage::getAllValues() {
+    std::lock_guard<std::mutex> lk(lock);
+    auto now = currentTimeMillis();
+    std::vector<Id> ids {};
+    for (const auto& [id, record] : values) {
+        if (findValue(id, now))
+            ids.push_back(id);
+    }
+
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<PeerInfo> MemoryStorage::getPeer(const Id& peerId, int maxPeers) {
+    uint64_t expiration;
+    return loadPeers(peerId, maxPeers, expiration);
+}
+
+std::vector<PeerInfo> MemoryStorage::loadPeers(const Id& peerId, int maxPeers, uint64_t& expiration) {
+    std::lock_guard<std::mutex> lk(lock);
+    std::vector<const PeerRecord*> records {};
+    std::vector<PeerInfo> result {};
+    expiration = 0;
+
+    auto it = peers.find(peerId);
+    if (it == peers.end())
+        return result;
+
+    const auto before = currentTimeMillis() - Constants::MAX_PEER_AGE;
+    for (const auto& [key, record] : it->second) {
+        if (record.timestamp >= before)
+            records.push_back(&record);
+    }
+
+    // a random sample, as the SQLite storage returns
+    size_t count = maxPeers > 0 ? std::min(records.size(), (size_t)maxPeers) : records.size();
+    for (size_t i = 0; i < count; i++) {
+        auto j = i + random() % (records.size() - i);
+        std::swap(records[i], records[j]);
+
+        result.push_back(records[i]->peer);
+        auto expires = records[i]->timestamp + Constants::MAX_PEER_AGE;
+        if (expiration == 0 || expires < expiration)
+            expiration = expires;
+    }
+
+    return result;
+}
+
+Sp<PeerInfo> MemoryStorage::getPeer(const Id& peerId, const Id& origin) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto it = peers.find(peerId);
+    if (it == peers.end())
+        return nullptr;
+
+    const auto before = currentTimeMillis() - Constants::MAX_PEER_AGE;
+    for (const auto& [key, record] : it->second) {
+        if (key.second == origin && record.timestamp >= before)
+            return std::make_shared<PeerInfo>(record.peer);
+    }
+    return nullptr;
+}
+
+bool MemoryStorage::removePeer(const Id& peerId, const Id& origin) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto it = peers.find(peerId);
+    if (it == peers.end())
+        return false;
+
+    bool removed = false;
+    for (auto rit = it->second.begin(); rit != it->second.end();) {
+        if (rit->first.second != origin) {
+            ++rit;
+            continue;
+        }
+
+        if (rit->second.expiry != peerExpiry.end())
+            peerExpiry.erase(rit->second.expiry);
+        rit = it->second.erase(rit);
+        removed = true;
+    }
+
+    if (it->second.empty())
+        peers.erase(it);
+    return removed;
+}
+
+void MemoryStorage::upsert(const PeerInfo& peer, bool persistent, uint64_t timestamp, uint64_t announced) {
+    auto& records = peers[peer.getId()];
+    PeerKey key {peer.getNodeId(), peer.getOrigin()};
+
+    auto it = records.find(key);
+    if (it == records.end())
+        it = records.emplace(key, PeerRecord {peer, persistent, timestamp, announced, peerExpiry.end()}).first;
+    else
+        it->second.peer = peer;
+
+    it->second.persistent = persistent;
+    it->second.announced = announced;
+    touch(it->second, peer.getId(), key, timestamp);
+}
+
+void MemoryStorage::putPeer(const std::vector<PeerInfo>& peers) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto now = currentTimeMillis();
+    for (const auto& peer : peers)
+        upsert(peer, false, now, 0);
+}
+
+void MemoryStorage::putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto now = currentTimeMillis();
+    upsert(peer, persistent, now, updateLastAnnounce ? now : 0);
+}
+
+void MemoryStorage::updatePeerLastAnnounce(const Id& peerId, const Id& origin) {
+    std::lock_guard<std::mutex> lk(lock);
+    auto it = peers.find(peerId);
+    if (it == peers.end())
+        return;
+
+    auto now = currentTimeMillis();
+    for (auto& [key, record] : it->second) {
+        if (key.second == origin) {
+            record.announced = now;
+            touch(record, peerId, key, now);
+        }
+    }
+}
+
+std::vector<PeerInfo> MemoryStorage::getPersistentPeers(uint64_t lastAnnounceBefore) {
+    std::lock_guard<std::mutex> lk(lock);
+    std::vector<PeerInfo> result {};
+    for (const auto& [id, records] : peers) {
+        for (const auto& [key, record] : records) {
+            if (record.persistent && record.announced <= lastAnnounceBefore)
+                result.push_back(record.peer);
+        }
+    }
+    return result;
+}
+
+std::vector<Id> MemoryStorage::getAllPeers() {
+    std::lock_guard<std::mutex> lk(lock);
+    const auto before = currentTimeMillis() - Constants::MAX_PEER_AGE;
+    std::vector<Id> ids {};
+    for (const auto& [id, records] : peers) {
+        auto live = std::any_of(records.begin(), records.end(), [before](const auto& entry) {
+            return entry.second.timestamp >= before;
+        });
+        if (live)
+            ids.push_back(id);
+    }
+
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+} // namespace boson
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+#include "boson/types.h"
+#include "boson/id.h"
+#include "boson/value.h"
+#include "boson/peer_info.h"
+#include "data_storage.h"
+#include "scheduler.h"
+
+namespace boson {
+
+/*
+ * Keeps the values and peers in memory only, for the nodes that don't need
+ * them to survive a restart (bootstrap and relay nodes, tests).
+ *
+ * The records live in hash maps keyed by id, the peers of an id in a map keyed
+ * by (nodeId, origin) like the primary key of the SQLite table. The
+ * non-persistent records are also indexed by their timestamp, so expire()
+ * walks the expired records only instead of scanning everything.
+ */
+class MemoryStorage final : public DataStorage {
+public:
+    MemoryStorage() {}
+
+    static Sp<DataStorage> open(Scheduler& scheduler);
+    void close() override;
+
+    using DataStorage::putValue;
+    using DataStorage::putPeer;
+
+    Sp<Value> getValue(const Id& valueId) override;
+    bool removeValue(const Id& valueId) override;
+    Sp<Value> putValue(const Value& value, int expectedSeq = -1, bool persistent = false, bool updateLastAnnounce = false) override;
+    void updateValueLastAnnounce(const Id& valueId) override;
+    std::vector<Value> getPersistentValues(uint64_t lastAnnounceBefore) override;
+    std::vector<Id> getAllValues() override;
+
+    std::vector<PeerInfo> getPeer(const Id& peerId, int maxPeers) override;
+    Sp<PeerInfo> getPeer(const Id& peerId, const Id& origin) override;
+    bool removePeer(const Id& peerId, const Id& origin) override;
+    void putPeer(const std::vector<PeerInfo>& peers) override;
+    void putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) override;
+    void updatePeerLastAnnounce(const Id& peerId, const Id& origin) override;
+    std::vector<PeerInfo> getPersistentPeers(uint64_t lastAnnounceBefore) override;
+    std::vector<Id> getAllPeers() override;
+
+    Sp<Value> loadValue(const Id& valueId, uint64_t& expiration) override;
+    std::vector<PeerInfo> loadPeers(const Id& peerId, int maxPeers, uint64_t& expiration) override;
+
+    // Drops the non-persistent records older than their maximum age at now,
+    // returns the number of records dropped
+    size_t expire(uint64_t now);
+
+private:
+    // nodeId, origin
+    using PeerKey = std::pair<Id, Id>;
+    using ValueExpiry = std::multimap<uint64_t, Id>;
+    using PeerExpiry = std::multimap<uint64_t, std::pair<Id, PeerKey>>;
+
+    struct ValueRecord {
+        Sp<Value> value;
+        bool persistent;
+        uint64_t timestamp;
+        uint64_t announced;
+        ValueExpiry::iterator expiry;
+    };
+
+    struct PeerRecord {
+        PeerInfo peer;
+        bool persistent;
+        uint64_t timestamp;
+        uint64_t announced;
+        PeerExpiry::iterator expiry;
+    };
+
+    using PeerRecords = std::map<PeerKey, PeerRecord>;
+
+    const ValueRecord* findValue(const Id& valueId, uint64_t now) const;
+    void touch(ValueRecord& record, const Id& valueId, uint64_t timestamp);
+    void touch(PeerRecord& record, const Id& peerId, const PeerKey& key, uint64_t timestamp);
+    void upsert(const PeerInfo& peer, bool persistent, uint64_t timestamp, uint64_t announced);
+
+    std::unordered_map<Id, ValueRecord> values {};
+    std::unordered_map<Id, PeerRecords> peers {};
+    ValueExpiry valueExpiry {};
+    PeerExpiry peerExpiry {};
+
+    Sp<Scheduler::Job> expireJob {};
+
+    std::mt19937 random { std::random_device()() };
+    mutable std::mutex lock {};
+};
+
+} // namespace boson
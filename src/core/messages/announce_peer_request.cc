@@ -26,49 +26,57 @@
 
 #include "crypto/hex.h"
 #include "message_error.h"
-#include "serializers.h"
 #include "announce_peer_request.h"
 
 namespace boson {
 
-void AnnouncePeerRequest::serializeInternal(nlohmann::json& root) const {
-    nlohmann::json object = {
-        {KEY_REQ_TOKEN, token},
-        {KEY_REQ_TARGET, peerId},
-        {KEY_REQ_PORT, port},
-        {KEY_REQ_SIGNATURE, nlohmann::json::binary_t {signature}}
-    };
+void AnnouncePeerRequest::serializeInternal(CborWriter& writer) const {
+    writer.key(getKeyString());
+    writer.beginMap();
 
-    if (nodeId.has_value())
-        object[KEY_REQ_PROXY_ID] = nodeId.value();
+    if (!alternativeURL.empty()) {
+        writer.key(KEY_REQ_ALT);
+        writer.writeString(alternativeURL);
+    }
 
-    if (!alternativeURL.empty())
-        object[KEY_REQ_ALT] = alternativeURL;
+    writer.key(KEY_REQ_PORT);
+    writer.writeInt(port);
+    writer.key(KEY_REQ_SIGNATURE);
+    writer.writeBytes(signature);
+    writer.key(KEY_REQ_TARGET);
+    writer.writeBytes(peerId.blob());
+    writer.key(KEY_REQ_TOKEN);
+    writer.writeInt(token);
 
-    Message::serializeInternal(root);
-    root[getKeyString()] = object;
+    if (nodeId.has_value()) {
+        writer.key(KEY_REQ_PROXY_ID);
+        writer.writeBytes(nodeId.value().blob());
+    }
+    writer.endMap();
 }
 
-void AnnouncePeerRequest::parse(const std::string& fieldName, nlohmann::json& object) {
-    if (fieldName != KEY_REQUEST || !object.is_object())
+void AnnouncePeerRequest::parse(std::string_view fieldName, CborReader& reader) {
+    if (fieldName != KEY_REQUEST || !reader.isMap())
         throw MessageError("Invalid " + std::to_string((int)getMethod()) + "reqeust message");
 
-    for (const auto& [key, value] : object.items()) {
-        if (key == KEY_REQ_TARGET)
-            value.get_to(peerId);
-        else if(key == KEY_REQ_PROXY_ID)
-            value.get_to(nodeId);
-        else if(key == KEY_REQ_PORT)
-            value.get_to(port);
-        else if(key == KEY_REQ_ALT)
-            value.get_to(alternativeURL);
-        else if(key == KEY_REQ_SIGNATURE)
-            signature = value.get_binary();
-        else if(key == KEY_REQ_TOKEN)
-            value.get_to(token);
-        else
-            throw MessageError("Invalid message with unkown key: " + key);
-    }
+    reader.readMap([&](std::string_view key) {
+        if (key == KEY_REQ_TARGET) {
+            peerId = Id(reader.readBytes());
+        } else if(key == KEY_REQ_PROXY_ID) {
+            nodeId = Id(reader.readBytes());
+        } else if(key == KEY_REQ_PORT) {
+            port = static_cast<uint16_t>(reader.readInt());
+        } else if(key == KEY_REQ_ALT) {
+            alternativeURL = reader.readString();
+        } else if(key == KEY_REQ_SIGNATURE) {
+            auto sig = reader.readBytes();
+            signature.assign(sig.cbegin(), sig.cend());
+        } else if(key == KEY_REQ_TOKEN) {
+            token = reader.readInt();
+        } else {
+            throw MessageError("Invalid message with unkown key: " + std::string(key));
+        }
+    });
 }
 
 int AnnouncePeerRequest::estimateSize() const {
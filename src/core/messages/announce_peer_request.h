@@ -74,16 +74,26 @@ public:
 
     int estimateSize() const override;
 
+    void reset() override {
+        Message::reset();
+        token = 0;
+        peerId = {};
+        nodeId.reset();
+        port = 0;
+        alternativeURL.clear();
+        signature.clear();
+    }
+
 protected:
-    void serializeInternal(nlohmann::json& root) const override;
-    void parse(const std::string& fieldName, nlohmann::json& object) override;
+    void serializeInternal(CborWriter& writer) const override;
+    void parse(std::string_view fieldName, CborReader& reader) override;
     void toString(std::stringstream& ss) const override;
 
 private:
-    int token;
+    int token {0};
     Id peerId;
     std::optional<Id> nodeId {};
-    uint16_t port;
+    uint16_t port {0};
     std::string alternativeURL {};
     std::vector<uint8_t> signature {};
 };
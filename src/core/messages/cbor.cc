@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "cbor.h"
+
+namespace boson {
+
+void CborWriter::writeHeader(uint8_t major, uint64_t value) {
+    uint8_t initial = major << 5;
+    if (value < 24) {
+        out.push_back(initial | static_cast<uint8_t>(value));
+        return;
+    }
+
+    int bytes;
+    if (value <= 0xFF) {
+        initial |= 24;
+        bytes = 1;
+    } else if (value <= 0xFFFF) {
+        initial |= 25;
+        bytes = 2;
+    } else if (value <= 0xFFFFFFFF) {
+        initial |= 26;
+        bytes = 4;
+    } else {
+        initial |= 27;
+        bytes = 8;
+    }
+
+    out.push_back(initial);
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+        out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void CborWriter::beginMap() {
+    if (depth == MAX_DEPTH)
+        throw MessageError("INTERNAL ERROR: CBOR maps nested too deep");
+
+    frames[depth++] = { out.size(), entryCount };
+    // Placeholder for the header, the entry count is only known in endMap()
+    out.push_back(MAJOR_MAP << 5);
+}
+
+void CborWriter::key(std::string_view key) {
+    if (depth == 0)
+        throw MessageError("INTERNAL ERROR: CBOR map key outside of a map");
+    if (entryCount == MAX_ENTRIES)
+        throw MessageError("INTERNAL ERROR: too many CBOR map entries");
+
+    entries[entryCount++] = out.size();
+    writeString(key);
+}
+
+std::string_view CborWriter::keyAt(size_t offset) const {
+    const uint8_t* p = out.data() + offset;
+    uint8_t info = *p++ & 0x1F;
+    uint64_t length = info;
+    if (info >= 24) {
+        length = 0;
+        for (int i = 0; i < (1 << (info - 24)); i++)
+            length = (length << 8) | *p++;
+    }
+    return std::string_view(reinterpret_cast<const char*>(p), length);
+}
+
+void CborWriter::sortEntries(const Frame& frame, size_t count, size_t end) {
+    const size_t* starts = entries.data() + frame.firstEntry;
+
+    std::array<size_t, MAX_ENTRIES> order;
+    for (size_t i = 0; i < count; i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.begin() + count, [&](size_t a, size_t b) {
+        return keyAt(starts[a]) < keyAt(starts[b]);
+    });
+
+    size_t base = starts[0];
+    std::vector<uint8_t> entryData(out.begin() + base, out.begin() + end);
+    auto pos = out.begin() + base;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = order[i];
+        size_t from = starts[index] - base;
+        size_t to = (index + 1 < count ? starts[index + 1] : end) - base;
+        pos = std::copy(entryData.begin() + from, entryData.begin() + to, pos);
+    }
+}
+
+void CborWriter::endMap() {
+    if (depth == 0)
+        throw MessageError("INTERNAL ERROR: unbalanced CBOR map");
+
+    const Frame& frame = frames[--depth];
+    size_t count = entryCount - frame.firstEntry;
+
+    for (size_t i = 1; i < count; i++) {
+        const size_t* starts = entries.data() + frame.firstEntry;
+        if (!(keyAt(starts[i - 1]) < keyAt(starts[i]))) {
+            sortEntries(frame, count, out.size());
+            break;
+        }
+    }
+    entryCount = frame.firstEntry;
+
+    if (count < 24) {
+        out[frame.start] = static_cast<uint8_t>((MAJOR_MAP << 5) | count);
+    } else {
+        // Encode the full header after the entries, then rotate it into place
+        size_t size = out.size();
+        writeHeader(MAJOR_MAP, count);
+        out[frame.start] = out[size];
+        std::rotate(out.begin() + frame.start + 1, out.begin() + size + 1, out.end());
+        out.pop_back();
+    }
+}
+
+uint64_t CborReader::readHeader(uint8_t& major, bool& indefinite) {
+    uint8_t initial = peek();
+    ptr++;
+
+    major = initial >> 5;
+    uint8_t info = initial & 0x1F;
+    indefinite = false;
+
+    if (info < 24)
+        return info;
+
+    if (info == 31) {
+        indefinite = true;
+        return 0;
+    }
+
+    if (info > 27)
+        throw MessageError("Invalid message: malformed CBOR header");
+
+    size_t bytes = size_t(1) << (info - 24);
+    if (static_cast<size_t>(end - ptr) < bytes)
+        throw MessageError("Invalid message: truncated CBOR data");
+
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++)
+        value = (value << 8) | *ptr++;
+    return value;
+}
+
+uint64_t CborReader::readContainerHeader(uint8_t major, bool& indefinite) {
+    uint8_t actual;
+    uint64_t length = readHeader(actual, indefinite);
+    if (actual != major)
+        throw MessageError(major == MAJOR_MAP ? "Invalid message: expected a CBOR map"
+                : "Invalid message: expected a CBOR array");
+
+    // Every item takes at least one byte, reject impossible lengths up front
+    if (!indefinite && length > static_cast<uint64_t>(end - ptr))
+        throw MessageError("Invalid message: truncated CBOR data");
+
+    return length;
+}
+
+bool CborReader::readBreak() {
+    if (peek() != BREAK)
+        return false;
+
+    ptr++;
+    return true;
+}
+
+int64_t CborReader::readInt64() {
+    uint8_t major;
+    bool indefinite;
+    uint64_t value = readHeader(major, indefinite);
+    if (indefinite || (major != MAJOR_UNSIGNED && major != MAJOR_NEGATIVE))
+        throw MessageError("Invalid message: expected a CBOR integer");
+
+    return major == MAJOR_UNSIGNED ? static_cast<int64_t>(value) : -1 - static_cast<int64_t>(value);
+}
+
+Blob CborReader::readString(uint8_t major) {
+    uint8_t actual;
+    bool indefinite;
+    uint64_t length = readHeader(actual, indefinite);
+    if (actual != major)
+        throw MessageError(major == MAJOR_TEXT ? "Invalid message: expected a CBOR text string"
+                : "Invalid message: expected a CBOR byte string");
+
+    if (!indefinite) {
+        if (length > static_cast<uint64_t>(end - ptr))
+            throw MessageError("Invalid message: truncated CBOR data");
+
+        Blob data(ptr, length);
+        ptr += length;
+        return data;
+    }
+
+    auto& chunk = chunks.emplace_back();
+    while (!readBreak()) {
+        length = readHeader(actual, indefinite);
+        if (actual != major || indefinite)
+            throw MessageError("Invalid message: malformed indefinite-length CBOR string");
+        if (length > static_cast<uint64_t>(end - ptr))
+            throw MessageError("Invalid message: truncated CBOR data");
+
+        chunk.insert(chunk.end(), ptr, ptr + length);
+        ptr += length;
+    }
+    return Blob(chunk.data(), chunk.size());
+}
+
+void CborReader::readNull() {
+    if (peek() != SIMPLE_NULL)
+        throw MessageError("Invalid message: expected a CBOR null");
+    ptr++;
+}
+
+void CborReader::skip() {
+    uint8_t major = peek() >> 5;
+    switch (major) {
+    case MAJOR_UNSIGNED:
+    case MAJOR_NEGATIVE:
+        readInt64();
+        break;
+
+    case MAJOR_BYTES:
+    case MAJOR_TEXT:
+        readString(major);
+        break;
+
+    case MAJOR_ARRAY:
+        readArray([this]() { skip(); });
+        break;
+
+    case MAJOR_MAP:
+        readMap([this](std::string_view) { skip(); });
+        break;
+
+    case MAJOR_TAG:
+        throw MessageError("Invalid message: unsupported CBOR tag");
+
+    case MAJOR_SIMPLE:
+    default: {
+        bool indefinite;
+        readHeader(major, indefinite);
+        // Simple values and floats carry their payload in the header
+        if (indefinite)
+            throw MessageError("Invalid message: unexpected CBOR break");
+        break;
+    }
+    }
+}
+
+} // namespace boson
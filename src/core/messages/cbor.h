@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <list>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "boson/blob.h"
+#include "message_error.h"
+
+namespace boson {
+
+/*
+ * Streaming CBOR encoder for the DHT messages.
+ *
+ * The output is byte-identical to nlohmann::json::to_cbor() on the equivalent
+ * document: shortest-form integer and length headers, definite-length
+ * containers, and map entries in ascending key order. Entries may be written
+ * in any order; endMap() sorts them in place if needed.
+ */
+class CborWriter {
+public:
+    explicit CborWriter(std::vector<uint8_t>& _out) noexcept
+        : out(_out) {}
+
+    void writeInt(int64_t value) {
+        if (value >= 0)
+            writeHeader(MAJOR_UNSIGNED, static_cast<uint64_t>(value));
+        else
+            writeHeader(MAJOR_NEGATIVE, static_cast<uint64_t>(-1 - value));
+    }
+
+    void writeBytes(const uint8_t* data, size_t length) {
+        writeHeader(MAJOR_BYTES, length);
+        out.insert(out.end(), data, data + length);
+    }
+
+    void writeBytes(const Blob& data) {
+        writeBytes(data.ptr(), data.size());
+    }
+
+    void writeString(std::string_view value) {
+        writeHeader(MAJOR_TEXT, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    void writeNull() {
+        out.push_back(SIMPLE_NULL);
+    }
+
+    void beginArray(size_t length) {
+        writeHeader(MAJOR_ARRAY, length);
+    }
+
+    void beginMap();
+    void key(std::string_view key);
+    void endMap();
+
+private:
+    static constexpr uint8_t MAJOR_UNSIGNED = 0;
+    static constexpr uint8_t MAJOR_NEGATIVE = 1;
+    static constexpr uint8_t MAJOR_BYTES = 2;
+    static constexpr uint8_t MAJOR_TEXT = 3;
+    static constexpr uint8_t MAJOR_ARRAY = 4;
+    static constexpr uint8_t MAJOR_MAP = 5;
+    static constexpr uint8_t SIMPLE_NULL = 0xF6;
+
+    static constexpr size_t MAX_DEPTH = 4;
+    static constexpr size_t MAX_ENTRIES = 64;
+
+    struct Frame {
+        size_t start;
+        size_t firstEntry;
+    };
+
+    void writeHeader(uint8_t major, uint64_t value);
+    std::string_view keyAt(size_t offset) const;
+    void sortEntries(const Frame& frame, size_t count, size_t end);
+
+    std::vector<uint8_t>& out;
+
+    std::array<Frame, MAX_DEPTH> frames;
+    size_t depth {0};
+    // Start offsets of the entries of all open maps, innermost last
+    std::array<size_t, MAX_ENTRIES> entries;
+    size_t entryCount {0};
+};
+
+/*
+ * Streaming CBOR decoder for the DHT messages.
+ *
+ * Reads straight from the packet buffer: definite-length byte and text strings
+ * are returned as views into the input and stay valid as long as the input
+ * does. Both definite and indefinite-length containers and strings are
+ * accepted, in any key order. Malformed input raises MessageError.
+ */
+class CborReader {
+public:
+    CborReader(const uint8_t* data, size_t length) noexcept
+        : ptr(data), end(data + length) {}
+
+    bool atEnd() const noexcept {
+        return ptr == end;
+    }
+
+    bool isNull() const {
+        return peek() == SIMPLE_NULL;
+    }
+
+    bool isArray() const {
+        return (peek() >> 5) == MAJOR_ARRAY;
+    }
+
+    bool isMap() const {
+        return (peek() >> 5) == MAJOR_MAP;
+    }
+
+    int64_t readInt64();
+
+    int readInt() {
+        return static_cast<int>(readInt64());
+    }
+
+    Blob readBytes() {
+        return readString(MAJOR_BYTES);
+    }
+
+    std::string_view readString() {
+        auto blob = readString(MAJOR_TEXT);
+        return std::string_view(reinterpret_cast<const char*>(blob.ptr()), blob.size());
+    }
+
+    void readNull();
+
+    // Calls f() once per element; f must consume exactly one item
+    template <typename F>
+    void readArray(F&& f) {
+        bool indefinite;
+        uint64_t length = readContainerHeader(MAJOR_ARRAY, indefinite);
+        Nesting nesting(*this);
+        if (indefinite) {
+            while (!readBreak())
+                f();
+        } else {
+            for (uint64_t i = 0; i < length; i++)
+                f();
+        }
+    }
+
+    // Calls f(key) once per entry; f must consume exactly one value item
+    template <typename F>
+    void readMap(F&& f) {
+        bool indefinite;
+        uint64_t length = readContainerHeader(MAJOR_MAP, indefinite);
+        Nesting nesting(*this);
+        if (indefinite) {
+            while (!readBreak())
+                f(readString());
+        } else {
+            for (uint64_t i = 0; i < length; i++)
+                f(readString());
+        }
+    }
+
+    // Skip one complete item of any type
+    void skip();
+
+private:
+    static constexpr uint8_t MAJOR_UNSIGNED = 0;
+    static constexpr uint8_t MAJOR_NEGATIVE = 1;
+    static constexpr uint8_t MAJOR_BYTES = 2;
+    static constexpr uint8_t MAJOR_TEXT = 3;
+    static constexpr uint8_t MAJOR_ARRAY = 4;
+    static constexpr uint8_t MAJOR_MAP = 5;
+    static constexpr uint8_t MAJOR_TAG = 6;
+    static constexpr uint8_t MAJOR_SIMPLE = 7;
+    static constexpr uint8_t SIMPLE_NULL = 0xF6;
+    static constexpr uint8_t BREAK = 0xFF;
+
+    static constexpr int MAX_NESTING = 16;
+
+    struct Nesting {
+        Nesting(CborReader& _reader) : reader(_reader) {
+            if (++reader.nesting > MAX_NESTING)
+                throw MessageError("Invalid message: CBOR nesting too deep");
+        }
+        ~Nesting() {
+            --reader.nesting;
+        }
+        CborReader& reader;
+    };
+
+    uint8_t peek() const {
+        if (ptr == end)
+            throw MessageError("Invalid message: truncated CBOR data");
+        return *ptr;
+    }
+
+    uint64_t readHeader(uint8_t& major, bool& indefinite);
+    uint64_t readContainerHeader(uint8_t major, bool& indefinite);
+    Blob readString(uint8_t major);
+    bool readBreak();
+
+    const uint8_t* ptr;
+    const uint8_t* end;
+    int nesting {0};
+    // Backing store for reassembled indefinite-length strings
+    std::list<std::vector<uint8_t>> chunks {};
+};
+
+} // namespace boson
@@ -28,28 +28,29 @@
 
 namespace boson {
 
-void ErrorMessage::serializeInternal(nlohmann::json& root) const {
-    nlohmann::json object = {
-        {KEY_ERR_CODE, code},
-        {KEY_ERR_MESSAGE, message}
-    };
-    Message::serializeInternal(root);
-    root[getKeyString()] = object;
+void ErrorMessage::serializeInternal(CborWriter& writer) const {
+    writer.key(getKeyString());
+    writer.beginMap();
+    writer.key(KEY_ERR_CODE);
+    writer.writeInt(code);
+    writer.key(KEY_ERR_MESSAGE);
+    writer.writeString(message);
+    writer.endMap();
 }
 
-void ErrorMessage::parse(const std::string& fieldName, nlohmann::json& object) {
-    if (fieldName != KEY_ERROR || !object.is_object())
+void ErrorMessage::parse(std::string_view fieldName, CborReader& reader) {
+    if (fieldName != KEY_ERROR || !reader.isMap())
         throw MessageError("Invalid request message");
 
-    for (const auto& [key, value]: object.items()) {
+    reader.readMap([&](std::string_view key) {
         if (key == KEY_ERR_CODE) {
-            value.get_to(code);
+            code = reader.readInt();
         } else if(key == KEY_ERR_MESSAGE) {
-            value.get_to(message);
+            message = reader.readString();
         } else {
             throw MessageError("Invalid " + getMethodString() + " request message");
         }
-    }
+    });
 }
 
 void ErrorMessage::toString(std::stringstream& ss) const {
@@ -23,7 +23,6 @@
 
 #pragma once
 
-#include <nlohmann/json.hpp>
 #include "message.h"
 
 namespace boson {
@@ -49,9 +48,15 @@ public:
         return Message::estimateSize() + 16 + message.size();
     }
 
+    void reset() override {
+        Message::reset();
+        message.clear();
+        code = 0;
+    }
+
 protected:
-    void serializeInternal(nlohmann::json& root) const override;
-    void parse(const std::string& fieldName, nlohmann::json& object) override;
+    void serializeInternal(CborWriter& writer) const override;
+    void parse(std::string_view fieldName, CborReader& reader) override;
     void toString(std::stringstream& ss) const override;
 
 private:
@@ -23,7 +23,6 @@
 
 #include <sstream>
 
-#include "serializers.h"
 #include "message_error.h"
 #include "find_peer_response.h"
 
@@ -43,62 +42,83 @@ int FindPeerResponse::estimateSize() const {
     return size;
 }
 
-void FindPeerResponse::_serialize(nlohmann::json& json) const {
+void FindPeerResponse::_serialize(CborWriter& writer) const {
     if (peers.empty())
         return;
 
-    auto array = nlohmann::json::array();
-    array.push_back(peers.front().getId());
+    writer.key(KEY_RES_PEERS);
+    writer.beginArray(peers.size() + 1);
+    writer.writeBytes(peers.front().getId().blob());
     for (const auto& peer: peers) {
-        auto ar = nlohmann::json::array();
-        ar.push_back(peer.getNodeId());
+        writer.beginArray(5);
+        writer.writeBytes(peer.getNodeId().blob());
         if (peer.isDelegated())
-            ar.push_back(peer.getOrigin());
+            writer.writeBytes(peer.getOrigin().blob());
         else
-            ar.push_back(nullptr);
-        ar.push_back(peer.getPort());
+            writer.writeNull();
+        writer.writeInt(peer.getPort());
         if (peer.hasAlternativeURL())
-            ar.push_back(peer.getAlternativeURL());
+            writer.writeString(peer.getAlternativeURL());
         else
-            ar.push_back(nullptr);
-        ar.push_back(nlohmann::json::binary_t(peer.getSignature()));
-
-        array.push_back(ar);
+            writer.writeNull();
+        writer.writeBytes(peer.getSignature());
     }
-
-    json[KEY_RES_PEERS] = array;
 }
 
-void FindPeerResponse::_parse(const std::string& fieldName, nlohmann::json& object) {
-    if (!object.is_array())
+void FindPeerResponse::_parse(std::string_view fieldName, CborReader& reader) {
+    if (!reader.isArray())
         throw MessageError("Invalid response peers message");
 
     if (fieldName != KEY_RES_PEERS)
         throw MessageError("invalid find peer response message");
 
     Blob peerId {};
-    for (nlohmann::json::iterator it = object.begin(); it != object.end(); ++it) {
-        if (!it->is_array()) {
-            peerId = it->get_binary();
-        } else {
-            auto id = it->at(0).get_binary();
-
-            Blob origin {};
-            if (!it->at(1).is_null())
-                origin =it->at(1).get_binary();
-
-            auto port = it->at(2).get<uint16_t>();
-
-            std::string alt {};
-            if (!it->at(3).is_null())
-                alt = it->at(3).get<std::string>();
-
-            auto sig = it->at(4).get_binary();
-
-            auto pi = PeerInfo::of(peerId, {}, id, origin, port, alt, sig);
-            peers.emplace_back(pi);
+    reader.readArray([&]() {
+        if (!reader.isArray()) {
+            peerId = reader.readBytes();
+            return;
         }
-    }
+
+        Blob id {};
+        Blob origin {};
+        uint16_t port {0};
+        std::string alt {};
+        Blob sig {};
+        int fields {0};
+        reader.readArray([&]() {
+            switch (fields++) {
+            case 0:
+                id = reader.readBytes();
+                break;
+            case 1:
+                if (reader.isNull())
+                    reader.readNull();
+                else
+                    origin = reader.readBytes();
+                break;
+            case 2:
+                port = static_cast<uint16_t>(reader.readInt());
+                break;
+            case 3:
+                if (reader.isNull())
+                    reader.readNull();
+                else
+                    alt = reader.readString();
+                break;
+            case 4:
+                sig = reader.readBytes();
+                break;
+            default:
+                reader.skip();
+                break;
+            }
+        });
+
+        if (fields < 5)
+            throw MessageError("Invalid response peers message");
+
+        peers.emplace_back(PeerInfo::of(peerId, {}, id, origin, port, alt, sig));
+    });
 }
 
 void FindPeerResponse::_toString(std::stringstream& ss) const {
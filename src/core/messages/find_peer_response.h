@@ -48,9 +48,14 @@ public:
 
     int estimateSize() const override;
 
+    void reset() override {
+        LookupResponse::reset();
+        peers.clear();
+    }
+
 protected:
-    void _serialize(nlohmann::json& json) const override;
-    void _parse(const std::string& fieldName, nlohmann::json& object) override;
+    void _serialize(CborWriter& writer) const override;
+    void _parse(std::string_view fieldName, CborReader& reader) override;
     void _toString(std::stringstream& ss) const override;
 
 private:
@@ -26,16 +26,18 @@
 
 namespace boson {
 
-void FindValueRequest::_serialize(nlohmann::json& object) const {
-    if (sequenceNumber >= 0)
-        object[KEY_RES_SEQ] = sequenceNumber;
+void FindValueRequest::_serialize(CborWriter& writer) const {
+    if (sequenceNumber >= 0) {
+        writer.key(KEY_RES_SEQ);
+        writer.writeInt(sequenceNumber);
+    }
 }
 
-void FindValueRequest::_parse(const std::string& fieldName, nlohmann::json& object) {
+void FindValueRequest::_parse(std::string_view fieldName, CborReader& reader) {
     if (fieldName != KEY_RES_SEQ)
-        throw MessageError(std::string("Unknown field: ") + fieldName);
+        throw MessageError("Unknown field: " + std::string(fieldName));
 
-    object.get_to(sequenceNumber);
+    sequenceNumber = reader.readInt();
 }
 
 void FindValueRequest::_toString(std::stringstream& ss) const {
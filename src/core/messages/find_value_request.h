@@ -49,9 +49,14 @@ public:
         return LookupRequest::estimateSize() + 9;
     }
 
+    void reset() override {
+        LookupRequest::reset();
+        sequenceNumber = -1;
+    }
+
 protected:
-    void _serialize(nlohmann::json& object) const override;
-    void _parse(const std::string& fieldName, nlohmann::json &object) override;
+    void _serialize(CborWriter& writer) const override;
+    void _parse(std::string_view fieldName, CborReader& reader) override;
     void _toString(std::stringstream& ss) const override;
 
 private:
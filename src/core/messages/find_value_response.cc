@@ -21,11 +21,8 @@
  * SOFTWARE.
  */
 
-#include <nlohmann/json.hpp>
-
 #include "crypto/hex.h"
 #include "message_error.h"
-#include "serializers.h"
 #include "find_value_response.h"
 
 namespace boson {
@@ -49,39 +46,50 @@ Value FindValueResponse::getValue() const {
         signature.has_value() ? signature.value(): Blob(), Blob(value));
 }
 
-void FindValueResponse::_serialize(nlohmann::json& object) const {
+void FindValueResponse::_serialize(CborWriter& writer) const {
     if (publicKey.has_value()) {
-        object[KEY_RES_PUBLICKEY] = publicKey.value();
-
-        if (recipient.has_value())
-            object[KEY_RES_RECIPIENT] = recipient.value();
-
-        object[KEY_RES_NONCE] = nlohmann::json::binary_t {{nonce.value().cbegin(), nonce.value().cend()}};
-        if (sequenceNumber >= 0)
-            object[KEY_RES_SEQ] = sequenceNumber;
-
-        object[KEY_RES_SIGNATURE] = nlohmann::json::binary_t {signature.value()};
+        writer.key(KEY_RES_PUBLICKEY);
+        writer.writeBytes(publicKey.value().blob());
+
+        if (recipient.has_value()) {
+            writer.key(KEY_RES_RECIPIENT);
+            writer.writeBytes(recipient.value().blob());
+        }
+
+        writer.key(KEY_RES_NONCE);
+        writer.writeBytes(nonce.value().blob());
+        if (sequenceNumber >= 0) {
+            writer.key(KEY_RES_SEQ);
+            writer.writeInt(sequenceNumber);
+        }
+
+        writer.key(KEY_RES_SIGNATURE);
+        writer.writeBytes(signature.value());
     }
 
-    if (!value.empty())
-        object[KEY_RES_VALUE] = nlohmann::json::binary_t {value};
+    if (!value.empty()) {
+        writer.key(KEY_RES_VALUE);
+        writer.writeBytes(value);
+    }
 }
 
-void FindValueResponse::_parse(const std::string& fieldName, nlohmann::json& object) {
+void FindValueResponse::_parse(std::string_view fieldName, CborReader& reader) {
     if (fieldName == KEY_RES_PUBLICKEY) {
-        publicKey = object.get<Id>();
+        publicKey = Id(reader.readBytes());
     } else if (fieldName == KEY_RES_RECIPIENT) {
-        recipient = object.get<Id>();
+        recipient = Id(reader.readBytes());
     } else if (fieldName == KEY_RES_NONCE) {
-        nonce = CryptoBox::Nonce(Blob(object.get_binary()));
+        nonce = CryptoBox::Nonce(reader.readBytes());
     } else if (fieldName == KEY_RES_SEQ) {
-        sequenceNumber = object.get<int>();
+        sequenceNumber = reader.readInt();
     } else if (fieldName == KEY_RES_SIGNATURE) {
-        signature = object.get_binary();
+        auto sig = reader.readBytes();
+        signature = std::vector<uint8_t>(sig.cbegin(), sig.cend());
     } else if (fieldName == KEY_RES_VALUE) {
-        value = object.get_binary();
+        auto data = reader.readBytes();
+        value.assign(data.cbegin(), data.cend());
     } else {
-        throw MessageError("Unknown field: " + fieldName);
+        throw MessageError("Unknown field: " + std::string(fieldName));
     }
 }
 
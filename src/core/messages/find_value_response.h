@@ -55,9 +55,19 @@ public:
         return LookupResponse::estimateSize() + 195 + value.size();
     }
 
+    void reset() override {
+        LookupResponse::reset();
+        publicKey.reset();
+        recipient.reset();
+        nonce.reset();
+        signature.reset();
+        sequenceNumber = -1;
+        value.clear();
+    }
+
 protected:
-    void _serialize(nlohmann::json& object) const override;
-    void _parse(const std::string& field, nlohmann::json& object) override;
+    void _serialize(CborWriter& writer) const override;
+    void _parse(std::string_view fieldName, CborReader& reader) override;
     void _toString(std::stringstream& ss) const override;
 
 private:
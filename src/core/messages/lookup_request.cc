@@ -24,7 +24,6 @@
 #include <sstream>
 
 #include "message_error.h"
-#include "serializers.h"
 #include "lookup_request.h"
 
 namespace boson {
@@ -39,30 +38,30 @@ void LookupRequest::setWant(int want) {
     wantToken = (want & 0x04);
 }
 
-void LookupRequest::serializeInternal(nlohmann::json& root) const {
-    nlohmann::json json = {
-        {KEY_REQ_TARGET, target},
-        {KEY_REQ_WANT, getWant()}
-    };
-    _serialize(json);
-
-    Message::serializeInternal(root);
-    root[getKeyString()] = json;
+void LookupRequest::serializeInternal(CborWriter& writer) const {
+    writer.key(getKeyString());
+    writer.beginMap();
+    _serialize(writer);
+    writer.key(KEY_REQ_TARGET);
+    writer.writeBytes(target.blob());
+    writer.key(KEY_REQ_WANT);
+    writer.writeInt(getWant());
+    writer.endMap();
 }
 
-void LookupRequest::parse(const std::string& fieldName, nlohmann::json& object) {
-    if (fieldName != KEY_REQUEST || !object.is_object())
+void LookupRequest::parse(std::string_view fieldName, CborReader& reader) {
+    if (fieldName != KEY_REQUEST || !reader.isMap())
         throw MessageError("Invalid request message");
 
-    for (const auto& [key, value]: object.items()) {
+    reader.readMap([&](std::string_view key) {
         if (key == KEY_REQ_TARGET) {
-            value.get_to(target);
+            target = Id(reader.readBytes());
         } else if(key == KEY_REQ_WANT) {
-            setWant(value.get<int>());
+            setWant(reader.readInt());
         } else {
-            _parse(key, value);
+            _parse(key, reader);
         }
-    }
+    });
 }
 
 void LookupRequest::toString(std::stringstream& ss) const {
@@ -58,6 +58,14 @@ public:
         return Message::estimateSize() + 43;
     }
 
+    void reset() override {
+        Message::reset();
+        target = {};
+        want4 = false;
+        want6 = false;
+        wantToken = false;
+    }
+
 protected:
     virtual void setWantToken(bool wantToken) {
         this->wantToken = wantToken;
@@ -70,10 +78,12 @@ protected:
     int getWant() const;
     void setWant(int want);
 
-    virtual void _serialize(nlohmann::json& root) const {}
-    void serializeInternal(nlohmann::json& root) const override;
-    virtual void _parse(const std::string& fieldName, nlohmann::json &object) {}
-    void parse(const std::string& fieldName, nlohmann::json &object) override;
+    virtual void _serialize(CborWriter& writer) const {}
+    void serializeInternal(CborWriter& writer) const override;
+    virtual void _parse(std::string_view fieldName, CborReader& reader) {
+        reader.skip();
+    }
+    void parse(std::string_view fieldName, CborReader& reader) override;
 
     virtual void _toString(std::stringstream& ss) const {}
     void toString(std::stringstream &ss) const override;
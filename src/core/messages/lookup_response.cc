@@ -24,10 +24,16 @@
 
 #include "message_error.h"
 #include "lookup_response.h"
-#include "serializers.h"
 
 namespace boson {
 
+// Storage of the decoded NodeInfo objects, object and control block in one block
+static BlockPool& nodeInfoBlocks() {
+    // never destroyed, the last nodes may be released during static destruction
+    static auto* pool = new BlockPool(Constants::MESSAGE_POOL_CAPACITY * Constants::MAX_ENTRIES_PER_BUCKET);
+    return *pool;
+}
+
 const std::list<Sp<NodeInfo>>& LookupResponse::getNodes(Network type) const {
     switch (type) {
     case Network::IPv4:
@@ -54,57 +60,78 @@ int LookupResponse::estimateSize() const {
     return size;
 }
 
-void LookupResponse::serializeInternal(nlohmann::json& root) const {
-    nlohmann::json object = nlohmann::json::object();
+void LookupResponse::serializeInternal(CborWriter& writer) const {
+    writer.key(getKeyString());
+    writer.beginMap();
     for (const auto& pair: {
         std::make_pair(std::ref(KEY_RES_NODES4), std::ref(nodes4)),
         std::make_pair(std::ref(KEY_RES_NODES6), std::ref(nodes6))
     }) {
         if (!pair.second.empty())
-            serializeNodes(object, pair.first, pair.second);
+            serializeNodes(writer, pair.first, pair.second);
     }
 
-    if (token != 0)
-        object[KEY_RES_TOKEN] = token;
+    _serialize(writer);
 
-    _serialize(object);
-    Message::serializeInternal(root);
-    root[getKeyString()] = object;
+    if (token != 0) {
+        writer.key(KEY_RES_TOKEN);
+        writer.writeInt(token);
+    }
+    writer.endMap();
 }
 
-void LookupResponse::parse(const std::string& fieldName, nlohmann::json& object) {
-    if (fieldName != KEY_RESPONSE || !object.is_object())
+void LookupResponse::parse(std::string_view fieldName, CborReader& reader) {
+    if (fieldName != KEY_RESPONSE || !reader.isMap())
         throw MessageError("Invalid lookup response message");
 
-    for (const auto& [key, value] : object.items()) {
+    reader.readMap([&](std::string_view key) {
         if (key == KEY_RES_NODES4) {
-            parseNodes(value, nodes4);
+            parseNodes(reader, nodes4);
         } else if (key == KEY_RES_NODES6) {
-            parseNodes(value, nodes6);
+            parseNodes(reader, nodes6);
         } else if (key == KEY_RES_TOKEN) {
-            value.get_to(token);
+            token = reader.readInt();
         } else {
-            _parse(key, value);
+            _parse(key, reader);
         }
-    }
+    });
 }
 
-void LookupResponse::serializeNodes(nlohmann::json& object, const std::string& fieldName, const std::list<Sp<NodeInfo>>& nodes) const {
-    nlohmann::json jsonNodes;
+void LookupResponse::serializeNodes(CborWriter& writer, const std::string& fieldName, const std::list<Sp<NodeInfo>>& nodes) const {
+    writer.key(fieldName);
+    writer.beginArray(nodes.size());
     for (const auto& node: nodes) {
-        jsonNodes.push_back(*node);
+        const auto& addr = node->getAddress();
+        writer.beginArray(3);
+        writer.writeBytes(node->getId().blob());
+        writer.writeBytes(addr.inaddr(), addr.inaddrLength());
+        writer.writeInt(addr.port());
     }
-
-    object[fieldName] = jsonNodes;
 }
 
-void LookupResponse::parseNodes(const nlohmann::json &object, std::list<Sp<NodeInfo>>& nodes) {
-    if (!object.is_array())
+void LookupResponse::parseNodes(CborReader& reader, std::list<Sp<NodeInfo>>& nodes) {
+    if (!reader.isArray())
         throw MessageError("Invalid response nodes message");
 
-    for (const auto& elem : object) {
-        nodes.emplace_back(std::make_shared<NodeInfo>(elem.get<NodeInfo>()));
-    }
+    reader.readArray([&]() {
+        Blob id {};
+        Blob ip {};
+        int port {0};
+        int fields {0};
+        reader.readArray([&]() {
+            switch (fields++) {
+            case 0: id = reader.readBytes(); break;
+            case 1: ip = reader.readBytes(); break;
+            case 2: port = reader.readInt(); break;
+            default: reader.skip(); break;
+            }
+        });
+
+        if (fields < 3)
+            throw MessageError("Invalid response nodes message");
+
+        appendNode(nodes, std::allocate_shared<NodeInfo>(PoolAllocator<NodeInfo>(nodeInfoBlocks()), id, ip, port));
+    });
 }
 
 void LookupResponse::toString(std::stringstream& ss) const {
@@ -33,16 +33,19 @@ class LookupResponse : public Message {
 public:
     LookupResponse(Method method, int txid) : Message(Message::Type::RESPONSE, method, txid) {}
 
-    void setNodes4(const std::list<Sp<NodeInfo>>& nodes4) {
-        this->nodes4 = nodes4;
+    // Any container of Sp<NodeInfo> or Sp of a NodeInfo subclass
+    template <typename Nodes>
+    void setNodes4(const Nodes& nodes4) {
+        assignNodes(this->nodes4, nodes4);
     }
 
     const std::list<Sp<NodeInfo>>& getNodes4() const {
         return nodes4;
     }
 
-    void setNodes6(const std::list<Sp<NodeInfo>>& nodes6) {
-        this->nodes6 = nodes6;
+    template <typename Nodes>
+    void setNodes6(const Nodes& nodes6) {
+        assignNodes(this->nodes6, nodes6);
     }
 
     const std::list<Sp<NodeInfo>>& getNodes6() const {
@@ -61,21 +64,54 @@ public:
 
     int estimateSize() const override;
 
+    void reset() override {
+        Message::reset();
+        recycleNodes(nodes4);
+        recycleNodes(nodes6);
+        token = 0;
+    }
+
 protected:
-    virtual void _serialize(nlohmann::json& json) const {}
-    virtual void _parse(const std::string& fieldName, nlohmann::json &object) {}
+    virtual void _serialize(CborWriter& writer) const {}
+    virtual void _parse(std::string_view fieldName, CborReader& reader) {
+        reader.skip();
+    }
     virtual void _toString(std::stringstream& str) const {}
 
-    void serializeInternal(nlohmann::json& root) const override;
-    void parse(const std::string& fieldName, nlohmann::json& object) override;
+    void serializeInternal(CborWriter& writer) const override;
+    void parse(std::string_view fieldName, CborReader& reader) override;
     void toString(std::stringstream& str) const override;
 
 private:
-    void serializeNodes(nlohmann::json &object, const std::string& fieldName, const std::list<Sp<NodeInfo>>& nodes) const;
-    void parseNodes(const nlohmann::json &object, std::list<Sp<NodeInfo>>& nodes);
+    void serializeNodes(CborWriter& writer, const std::string& fieldName, const std::list<Sp<NodeInfo>>& nodes) const;
+    void parseNodes(CborReader& reader, std::list<Sp<NodeInfo>>& nodes);
+
+    // The list nodes of a recycled response are kept in spareNodes and reused
+    template <typename Nodes>
+    void assignNodes(std::list<Sp<NodeInfo>>& nodes, const Nodes& source) {
+        recycleNodes(nodes);
+        for (const auto& node : source)
+            appendNode(nodes, node);
+    }
+
+    void appendNode(std::list<Sp<NodeInfo>>& nodes, Sp<NodeInfo> node) {
+        if (spareNodes.empty()) {
+            nodes.emplace_back(std::move(node));
+        } else {
+            nodes.splice(nodes.end(), spareNodes, spareNodes.begin());
+            nodes.back() = std::move(node);
+        }
+    }
+
+    void recycleNodes(std::list<Sp<NodeInfo>>& nodes) {
+        for (auto& node : nodes)
+            node.reset();
+        spareNodes.splice(spareNodes.end(), nodes);
+    }
 
     std::list<Sp<NodeInfo>> nodes4 {};
     std::list<Sp<NodeInfo>> nodes6 {};
+    std::list<Sp<NodeInfo>> spareNodes {};
     int token {0};
 };
 
@@ -21,6 +21,8 @@
  * SOFTWARE.
  */
 
+#include <optional>
+
 #include "message.h"
 #include "ping_request.h"
 #include "ping_response.h"
@@ -36,6 +38,7 @@
 #include "find_value_response.h"
 #include "store_value_response.h"
 #include "message_error.h"
+#include "packet_buffer.h"
 
 namespace boson {
 
@@ -45,17 +48,17 @@ const int Message::MSG_METHOD_MASK = 0x1F;
 Sp<Message> Message::Method::createRequest() const {
     switch(e) {
     case Method::PING:
-        return std::make_shared<PingRequest>();
+        return acquire<PingRequest>();
     case Method::FIND_NODE:
-        return std::make_shared<FindNodeRequest>();
+        return acquire<FindNodeRequest>();
     case Method::ANNOUNCE_PEER:
-        return std::make_shared<AnnouncePeerRequest>();
+        return acquire<AnnouncePeerRequest>();
     case Method::FIND_PEER:
-        return std::make_shared<FindPeerRequest>();
+        return acquire<FindPeerRequest>();
     case Method::STORE_VALUE:
-        return std::make_shared<StoreValueRequest>();
+        return acquire<StoreValueRequest>();
     case Method::FIND_VALUE:
-        return std::make_shared<FindValueRequest>();
+        return acquire<FindValueRequest>();
     case Method::UNKNOWN:
     default:
         throw MessageError("Invalid request method: " + std::to_string(e));
@@ -65,17 +68,17 @@ Sp<Message> Message::Method::createRequest() const {
 Sp<Message> Message::Method::createResponse() const {
     switch(e) {
     case Method::PING:
-        return std::make_shared<PingResponse>();
+        return acquire<PingResponse>();
     case Method::FIND_NODE:
-        return std::make_shared<FindNodeResponse>();
+        return acquire<FindNodeResponse>();
     case Method::ANNOUNCE_PEER:
-        return std::make_shared<AnnouncePeerResponse>();
+        return acquire<AnnouncePeerResponse>();
     case Method::FIND_PEER:
-        return std::make_shared<FindPeerResponse>();
+        return acquire<FindPeerResponse>();
     case Method::STORE_VALUE:
-        return std::make_shared<StoreValueResponse>();
+        return acquire<StoreValueResponse>();
     case Method::FIND_VALUE:
-        return std::make_shared<FindValueResponse>();
+        return acquire<FindValueResponse>();
     case Method::UNKNOWN:
     default:
         throw MessageError("Invalid response method: " + std::to_string(e));
@@ -83,25 +86,40 @@ Sp<Message> Message::Method::createResponse() const {
 }
 
 Sp<Message> Message::parse(const uint8_t* buf, size_t buflen) {
-    auto root = nlohmann::json::from_cbor(std::vector<uint8_t>{buf, buf + buflen});
-    if (!root.is_object())
+    CborReader reader(buf, buflen);
+    if (buflen == 0 || !reader.isMap())
         throw MessageError("Invalid message: not a CBOR object");
 
-    auto type = root.find(KEY_TYPE);
-    if (type == root.end()) {
+    // The type decides the message class, but canonical encoders put it last.
+    // Locate it first, skipping over the other entries without decoding them.
+    std::optional<int> type {};
+    reader.readMap([&](std::string_view key) {
+        if (key == KEY_TYPE)
+            type = reader.readInt();
+        else
+            reader.skip();
+    });
+
+    if (!reader.atEnd())
+        throw MessageError("Invalid message: unexpected trailing data");
+
+    if (!type.has_value())
         throw MessageError("Invalid message: missing type field");
-    }
 
-    auto message = Message::createMessage(type->get<uint8_t>());
-    for (const auto& [key, value]: root.items()) {
+    auto message = Message::createMessage(static_cast<uint8_t>(type.value()));
+
+    CborReader body(buf, buflen);
+    body.readMap([&](std::string_view key) {
         if (key == KEY_TXID) {
-            value.get_to(message->txid);
+            message->txid = body.readInt();
         } else if (key == KEY_VERSION) {
-            value.get_to(message->version);
+            message->version = body.readInt();
         } else if (key == KEY_REQUEST || key == KEY_RESPONSE || key == KEY_ERROR) {
-            message->parse(key, value);
+            message->parse(key, body);
+        } else {
+            body.skip();
         }
-    }
+    });
     return message;
 }
 
@@ -138,16 +156,29 @@ std::string Message::toString() const {
     return ss.str();
 }
 
-void Message::serializeInternal(nlohmann::json& root) const {
-    root[KEY_TYPE] = type;
-    root[KEY_TXID] = txid;
-    root[KEY_VERSION] = version;
+void Message::encode(std::vector<uint8_t>& out) const {
+    CborWriter writer(out);
+    writer.beginMap();
+    // The body key sorts before the header keys, keeping the map in canonical order
+    serializeInternal(writer);
+    writer.key(KEY_TXID);
+    writer.writeInt(txid);
+    writer.key(KEY_VERSION);
+    writer.writeInt(version);
+    writer.key(KEY_TYPE);
+    writer.writeInt(type);
+    writer.endMap();
 }
 
 std::vector<uint8_t> Message::serialize() const {
-    nlohmann::json root = nlohmann::json::object();
-    serializeInternal(root);
-    return nlohmann::json::to_cbor(root);
+    std::vector<uint8_t> data;
+    data.reserve(estimateSize());
+    encode(data);
+    return data;
+}
+
+void Message::serialize(PacketBuffer& buffer) const {
+    encode(buffer.writer());
 }
 
 } // namespace boson
@@ -27,28 +27,21 @@
 #include <vector>
 #include <memory>
 #include <sstream>
-
-#ifdef __GNUC__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-
-#include <nlohmann/json.hpp>
-
-#ifdef __GNUC__
-#pragma GCC diagnostic pop
-#endif
+#include <string_view>
 
 #include "constants.h"
+#include "utils/object_pool.h"
 #include "boson/socket_address.h"
 #include "boson/id.h"
 #include "boson/version.h"
 #include "message_key.h"
+#include "cbor.h"
 
 namespace boson {
 
 class RPCCall;
 class RPCServer;
+class PacketBuffer;
 
 #define METHOD_TOTAL 7
 #define TYPE_TOTAL 3
@@ -268,21 +261,47 @@ public:
 
     std::string toString() const;
     std::vector<uint8_t> serialize() const;
+    // Append the encoded message to the payload of the packet buffer
+    void serialize(PacketBuffer& buffer) const;
 
     virtual int estimateSize() const {
         return BASE_SIZE;
     }
 
+    // Restore the freshly constructed state, keeping any allocated storage
+    virtual void reset() {
+        origin = {};
+        remoteAddr = {};
+        id = {};
+        remoteId = {};
+        associatedCall = nullptr;
+        txid = 0;
+        version = 0;
+    }
+
+    // A default constructed T from the pool of its class, see ObjectPool
+    template <typename T>
+    static Sp<T> acquire() {
+        // never destroyed, the last messages may be released during static destruction
+        static auto* pool = new ObjectPool<T>(Constants::MESSAGE_POOL_CAPACITY);
+        return pool->acquire();
+    }
+
 protected:
     explicit Message(Type _type, Method _method, int _txid = 0)
         : type(static_cast<int>(_type) | static_cast<int>(_method)), txid(_txid), version(0) {}
 
-    virtual void parse(const std::string& fieldName, nlohmann::json& object) {}
+    // Decode the body entry of the root map; the reader is positioned at its value
+    virtual void parse(std::string_view fieldName, CborReader& reader) {
+        reader.skip();
+    }
     virtual void toString(std::stringstream& ss) const {}
-    virtual void serializeInternal(nlohmann::json& root) const;
+    // Encode the body entry of the root map, if the message has one
+    virtual void serializeInternal(CborWriter& writer) const {}
 
 private:
     static Sp<Message> createMessage(int type);
+    void encode(std::vector<uint8_t>& out) const;
 
     static const int MSG_TYPE_MASK;
     static const int MSG_METHOD_MASK;
@@ -24,7 +24,6 @@
 
 #include "crypto/hex.h"
 #include "message_error.h"
-#include "serializers.h"
 #include "store_value_request.h"
 
 namespace boson {
@@ -48,53 +47,65 @@ Value StoreValueRequest::getValue() const {
         signature.has_value() ? signature.value() : Blob(), value);
 }
 
-void StoreValueRequest::serializeInternal(nlohmann::json& root) const {
-    nlohmann::json object = nlohmann::json::object();
+void StoreValueRequest::serializeInternal(CborWriter& writer) const {
+    writer.key(getKeyString());
+    writer.beginMap();
 
-    object[KEY_REQ_TOKEN] = token;
     if (isMutable()) {
-        object[KEY_REQ_PUBLICKEY] = publicKey.value();
-        if (isEncrypted())
-            object[KEY_REQ_RECIPIENT] = recipient.value();
-        object[KEY_REQ_NONCE] = nlohmann::json::binary_t {{nonce.value().cbegin(), nonce.value().cend()}};
-        object[KEY_REQ_SIGNATURE] = nlohmann::json::binary_t {signature.value()};
-        if (sequenceNumber >= 0)
-            object[KEY_REQ_SEQ] = sequenceNumber;
-        if (expectedSequenceNumber >= 0)
-            object[KEY_REQ_CAS] = expectedSequenceNumber;
+        if (expectedSequenceNumber >= 0) {
+            writer.key(KEY_REQ_CAS);
+            writer.writeInt(expectedSequenceNumber);
+        }
+        writer.key(KEY_REQ_PUBLICKEY);
+        writer.writeBytes(publicKey.value().blob());
+        writer.key(KEY_REQ_NONCE);
+        writer.writeBytes(nonce.value().blob());
+        if (isEncrypted()) {
+            writer.key(KEY_REQ_RECIPIENT);
+            writer.writeBytes(recipient.value().blob());
+        }
+        if (sequenceNumber >= 0) {
+            writer.key(KEY_REQ_SEQ);
+            writer.writeInt(sequenceNumber);
+        }
+        writer.key(KEY_REQ_SIGNATURE);
+        writer.writeBytes(signature.value());
     }
 
-    object[KEY_REQ_VALUE] = nlohmann::json::binary_t {value};
-
-    Message::serializeInternal(root);
-    root[getKeyString()] = object;
+    writer.key(KEY_REQ_TOKEN);
+    writer.writeInt(token);
+    writer.key(KEY_REQ_VALUE);
+    writer.writeBytes(value);
+    writer.endMap();
 }
 
-void StoreValueRequest::parse(const std::string& fieldName, nlohmann::json& object) {
-    if (fieldName != KEY_REQUEST || !object.is_object())
+void StoreValueRequest::parse(std::string_view fieldName, CborReader& reader) {
+    if (fieldName != KEY_REQUEST || !reader.isMap())
         throw MessageError("Invalid request message");
 
-    for (const auto& [key, object] : object.items()) {
+    reader.readMap([&](std::string_view key) {
         if (key == KEY_REQ_PUBLICKEY) {
-            publicKey = object.get<Id>();
+            publicKey = Id(reader.readBytes());
         } else if (key == KEY_REQ_RECIPIENT) {
-            recipient = object.get<Id>();
+            recipient = Id(reader.readBytes());
         } else if (key == KEY_REQ_NONCE) {
-            nonce = CryptoBox::Nonce(Blob(object.get_binary()));
+            nonce = CryptoBox::Nonce(reader.readBytes());
         } else if (key == KEY_REQ_SIGNATURE) {
-           signature = object.get_binary();
+            auto sig = reader.readBytes();
+            signature = std::vector<uint8_t>(sig.cbegin(), sig.cend());
         } else if (key == KEY_REQ_SEQ) {
-            sequenceNumber = object.get<uint16_t>();
+            sequenceNumber = static_cast<uint16_t>(reader.readInt());
         } else if (key == KEY_REQ_CAS) {
-            object.get_to(expectedSequenceNumber);
+            expectedSequenceNumber = reader.readInt();
         } else if (key == KEY_REQ_TOKEN) {
-            object.get_to(token);
+            token = reader.readInt();
         } else if (key == KEY_RES_VALUE) {
-            value = object.get_binary();
+            auto data = reader.readBytes();
+            value.assign(data.cbegin(), data.cend());
         } else {
-            throw MessageError("Unknown field: " + key);
+            throw MessageError("Unknown field: " + std::string(key));
         }
-    }
+    });
 }
 
 void StoreValueRequest::toString(std::stringstream& ss) const {
@@ -79,9 +79,21 @@ public:
         return Message::estimateSize() + 208 + value.size();
     }
 
+    void reset() override {
+        Message::reset();
+        token = 0;
+        publicKey.reset();
+        recipient.reset();
+        nonce.reset();
+        signature.reset();
+        sequenceNumber = -1;
+        expectedSequenceNumber = -1;
+        value.clear();
+    }
+
 protected:
-    void serializeInternal(nlohmann::json& root) const override;
-    void parse(const std::string& fieldName, nlohmann::json& object) override;
+    void serializeInternal(CborWriter& writer) const override;
+    void parse(std::string_view fieldName, CborReader& reader) override;
     void toString(std::stringstream& str) const override;
 
 private:
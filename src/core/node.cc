@@ -32,7 +32,10 @@
 #include "boson/node.h"
 #include "boson/node_status.h"
 #include "exceptions/state_error.h"
+#include "caching_storage.h"
+#include "memory_storage.h"
 #include "sqlite_storage.h"
+#include "write_behind_storage.h"
 #include "crypto_cache.h"
 #include "dht.h"
 
@@ -208,10 +211,16 @@ void Node::bootstrap(const NodeInfo& ni) {
 }
 
 void Node::bootstrap(const std::vector<NodeInfo>& nis) {
-    if (dht4 != nullptr)
-        dht4->bootstrap(nis);
-    if (dht6 != nullptr)
-        dht6->bootstrap(nis);
+    if (server == nullptr)
+        return;
+
+    // on the rx thread, after the DHTs were started there
+    server->post([this, nis]() {
+        if (dht4 != nullptr)
+            dht4->bootstrap(nis);
+        if (dht6 != nullptr)
+            dht6->bootstrap(nis);
+    });
 }
 
 void Node::start() {
@@ -237,39 +246,59 @@ void Node::start() {
     server = std::make_shared<RPCServer>(*this, dht4, dht6);
     auto& scheduler = server->getScheduler();
 
-    std::string dbPath {};
-    dbPath.reserve(storagePath.size() + 10);
-    dbPath += storagePath;
-    dbPath += PATH_SEP;
-    dbPath += "node.db";
+    if (config->storageBackend() == "memory") {
+        log->info("Data storage in memory, values and peers will not be persisted");
+        storage = MemoryStorage::open(scheduler);
+    } else {
+        std::string dbPath {};
+        dbPath.reserve(storagePath.size() + 10);
+        dbPath += storagePath;
+        dbPath += PATH_SEP;
+        dbPath += "node.db";
+
+        SqliteStorage::Options storageOptions {};
+        storageOptions.journalMode = config->storageJournalMode();
+        storageOptions.synchronous = config->storageSynchronous();
+        storageOptions.mmapSize = config->storageMmapSize();
+        storageOptions.cacheSize = config->storageCacheSize();
+        // the rx thread only touches the in-memory overlay, the disk writes are group committed
+        auto writeBehind = std::make_shared<WriteBehindStorage>(SqliteStorage::open(dbPath, scheduler, storageOptions));
+        storage = std::make_shared<CachingStorage>(writeBehind);
+    }
 
-    storage = SqliteStorage::open(dbPath, scheduler);
+    // The scheduler is not thread-safe and belongs to the rx thread once the
+    // server runs: the jobs are added before, or posted to the rx thread after.
 
     //Start crypto context loading cache check expriration
     scheduler.add([&]() {
         cryptoContexts->handleExpiration();
     }, CryptoCache::EXPIRED_CHECK_INTERVAL, CryptoCache::EXPIRED_CHECK_INTERVAL);
 
-    server->start();
+    auto job = scheduler.add([&]() {
+        persistentAnnounce();
+    }, 60000, Constants::RE_ANNOUNCE_INTERVAL);
+    scheduledActions.emplace_back(job);
 
-    auto nodes = config->getBootstrapNodes();
     if (dht4 != nullptr) {
         dht4->setServer(server);
         dht4->setTokenManager(tokenManager);
-        dht4->start(nodes);
         numDHTs++;
     }
     if (dht6 != nullptr) {
         dht6->setServer(server);
         dht6->setTokenManager(tokenManager);
-        dht6->start(nodes);
         numDHTs++;
     }
 
-    auto job = scheduler.add([&]() {
-        persistentAnnounce();
-    }, 60000, Constants::RE_ANNOUNCE_INTERVAL);
-    scheduledActions.emplace_back(job);
+    server->start();
+
+    // DHT::start() schedules the maintenance jobs
+    server->post([this, nodes = config->getBootstrapNodes()]() mutable {
+        if (dht4 != nullptr)
+            dht4->start(nodes);
+        if (dht6 != nullptr)
+            dht6->start(nodes);
+    });
 }
 
 void Node::stop() {
@@ -278,16 +307,16 @@ void Node::stop() {
 
     log->info("Boson Kademlia node {} is stopping...", id.toString());
 
+    // after the rx thread is gone, the scheduler is not thread-safe
+    if (server != nullptr)
+        server->stop();
+
     for (auto any : scheduledActions) {
         auto job = std::any_cast<Sp<Scheduler::Job>>(any);
         job->cancel();
     }
     scheduledActions.clear();
-
-    if (server != nullptr) {
-        server->stop();
-        server.reset();
-    }
+    server.reset();
 
     if (dht4 != nullptr) {
         dht4->stop();
@@ -583,22 +612,22 @@ void Node::setupCryptoBoxesCache() {
 
 std::vector<uint8_t> Node::encrypt(const Id& recipient, const Blob& plain) const {
     auto ctx = cryptoContexts->get(recipient);
-    return ctx.encrypt(plain);
+    return ctx->encrypt(plain);
 }
 
 std::vector<uint8_t> Node::decrypt(const Id& sender, const Blob& cipher) const {
     auto ctx = cryptoContexts->get(sender);
-    return ctx.decrypt(cipher);
+    return ctx->decrypt(cipher);
 }
 
 void Node::encrypt(const Id& recipient, Blob& cipher, const Blob& plain) const {
     auto ctx = cryptoContexts->get(recipient);
-    ctx.encrypt(cipher, plain);
+    ctx->encrypt(cipher, plain);
 }
 
 void Node::decrypt(const Id& sender, Blob& plain, const Blob& cipher) const {
     auto ctx = cryptoContexts->get(sender);
-    ctx.decrypt(plain, cipher);
+    ctx->decrypt(plain, cipher);
 }
 
 std::vector<uint8_t> Node::sign(const Blob& data) const {
@@ -656,6 +685,9 @@ std::string Node::toString() const {
     if (dht6 != nullptr)
         str.append(dht6->toString());
 
+    if (storage != nullptr)
+        str.append(storage->toString());
+
     return str;
 }
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "boson/blob.h"
+#include "boson/id.h"
+#include "boson/crypto_box.h"
+
+namespace boson {
+
+/*
+ * Outbound datagram buffer:
+ *
+ *   | sender id (32) | MAC (16) | payload ... |
+ *
+ * The message encoder appends the plain payload after the headroom, then the
+ * payload is encrypted in place: the MAC goes into the reserved bytes in front
+ * of it and the sender id is written in the first bytes.
+ */
+class PacketBuffer {
+public:
+    static constexpr size_t HEADROOM = ID_BYTES + CryptoBox::MAC_BYTES;
+    static constexpr size_t INITIAL_CAPACITY = 2048;
+
+    PacketBuffer() {
+        data.reserve(INITIAL_CAPACITY);
+        reset();
+    }
+
+    PacketBuffer(const PacketBuffer&) = delete;
+    PacketBuffer(PacketBuffer&&) noexcept = default;
+    PacketBuffer& operator=(const PacketBuffer&) = delete;
+    PacketBuffer& operator=(PacketBuffer&&) noexcept = default;
+
+    // Drop the content but keep the storage
+    void reset() noexcept {
+        data.resize(HEADROOM);
+    }
+
+    // The encoder's output, appended after the headroom
+    std::vector<uint8_t>& writer() noexcept {
+        return data;
+    }
+
+    Blob plain() noexcept {
+        return {data.data() + HEADROOM, data.size() - HEADROOM};
+    }
+
+    // MAC + payload, the destination of the in-place encryption
+    Blob cipher() noexcept {
+        return {data.data() + ID_BYTES, data.size() - ID_BYTES};
+    }
+
+    void setSender(const Id& id) noexcept {
+        std::memcpy(data.data(), id.data(), ID_BYTES);
+    }
+
+    const uint8_t* bytes() const noexcept {
+        return data.data();
+    }
+
+    size_t size() const noexcept {
+        return data.size();
+    }
+
+    size_t capacity() const noexcept {
+        return data.capacity();
+    }
+
+private:
+    std::vector<uint8_t> data;
+};
+
+/*
+ * Free list of packet buffers, not thread-safe: owned by the RPC server's rx
+ * thread, which encodes and sends all the outbound datagrams.
+ */
+class PacketBufferPool {
+public:
+    PacketBufferPool(size_t _maxPooled, size_t _maxCapacity)
+            : maxPooled(_maxPooled), maxCapacity(_maxCapacity) {
+        buffers.reserve(maxPooled);
+    }
+
+    PacketBuffer acquire() {
+        if (buffers.empty())
+            return PacketBuffer();
+
+        auto buffer = std::move(buffers.back());
+        buffers.pop_back();
+        return buffer;
+    }
+
+    void release(PacketBuffer&& buffer) {
+        // don't keep the buffers of the occasional huge datagram around
+        if (buffers.size() >= maxPooled || buffer.capacity() > maxCapacity)
+            return;
+
+        buffer.reset();
+        buffers.emplace_back(std::move(buffer));
+    }
+
+    size_t size() const noexcept {
+        return buffers.size();
+    }
+
+private:
+    size_t maxPooled;
+    size_t maxCapacity;
+    std::vector<PacketBuffer> buffers;
+};
+
+} // namespace boson
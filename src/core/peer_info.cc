@@ -29,6 +29,7 @@
 
 #include "boson/peer_info.h"
 #include "utils/common.h"
+#include "verified_records.h"
 
 namespace boson {
 
@@ -131,7 +132,7 @@ bool PeerInfo::isValid() const {
             return false;
 
    auto pk = publicKey.toSignatureKey();
-   return Signature::verify(getSignData(), signature, pk);
+   return VerifiedRecords::global().verify(getSignData(), signature, pk);
 }
 
 } // namespace boson
@@ -44,27 +44,6 @@
 
 namespace boson {
 
-int RoutingTable::indexOf(const std::list<Sp<KBucket>>& bucketsRef, const Id& id) {
-    int low = 0;
-    int mid = 0;
-    int cmp = 0;
-    int high = bucketsRef.size() - 1;
-
-    while (low <= high) {
-        mid = (low + high) >> 1;
-        auto bucket = list_get(bucketsRef, mid);
-        cmp = id.compareTo(bucket->getPrefix());
-        if (cmp > 0)
-            low = mid + 1;
-        else if (cmp < 0)
-            high = mid - 1;
-        else  // match the current bucket
-            return mid;
-    }
-
-    return cmp < 0 ? mid - 1 : mid;
-}
-
 void RoutingTable::_put(const Sp<KBucketEntry>& entry) {
     auto& nodeId = entry->getId();
     auto bucket = getBucket(nodeId);
@@ -105,19 +84,22 @@ bool RoutingTable::_needsSplit(const Sp<KBucket>& bucket, const Sp<KBucketEntry>
 }
 
 void RoutingTable::_modify(const std::vector<Sp<KBucket>>& toRemove, const std::vector<Sp<KBucket>>& toAdd) {
-    std::list<Sp<KBucket>> newBuckets(getBuckets());
+    auto newBuckets = std::make_shared<Buckets>();
+    auto bucketsRef = getBuckets();
+    newBuckets->reserve(bucketsRef->size() + toAdd.size());
 
-    if (!toRemove.empty())
-        list_removeAll(newBuckets, toRemove);
-    if (!toAdd.empty())
-        list_addAll(newBuckets, toAdd);
+    for (const auto& bucket : *bucketsRef) {
+        if (!vector_contains(toRemove, bucket))
+            newBuckets->push_back(bucket);
+    }
+    newBuckets->insert(newBuckets->end(), toAdd.begin(), toAdd.end());
 
-    assert(newBuckets.size() != 0);
+    assert(newBuckets->size() != 0);
 
-    auto sortKBucket = [](Sp<KBucket> a, Sp<KBucket> b) -> bool {
+    auto sortKBucket = [](const Sp<KBucket>& a, const Sp<KBucket>& b) -> bool {
         return a->compareTo(b) < 0;
     };
-    newBuckets.sort(sortKBucket);
+    std::sort(newBuckets->begin(), newBuckets->end(), sortKBucket);
     setBuckets(newBuckets);
 }
 
@@ -152,12 +134,12 @@ void RoutingTable::_mergeBuckets() {
         if (i < 1)
             continue;
 
-        auto& bucketsRef = getBuckets();
-        if (i >= bucketsRef.size())
+        auto bucketsRef = getBuckets();
+        if (i >= bucketsRef->size())
             break;
 
-        Sp<KBucket> b1 = list_get(bucketsRef, i - 1);
-        Sp<KBucket> b2 = list_get(bucketsRef, i);
+        Sp<KBucket> b1 = (*bucketsRef)[i - 1];
+        Sp<KBucket> b2 = (*bucketsRef)[i];
 
         if (b1->getPrefix().isSiblingOf(b2->getPrefix())) {
             b1->getEntries();
@@ -217,8 +199,10 @@ void RoutingTable::_maintenance() {
     const Id& localId = dht.getNode().getId();
     auto bootstrapIds = dht.getBootstrapIds();
 
-    for (auto& bucket : getBuckets()) {
-        std::list<Sp<KBucketEntry>> entries = bucket->getEntries();
+    auto bucketsRef = getBuckets();
+    for (auto& bucket : *bucketsRef) {
+        // a copy, the loop below modifies the bucket
+        KBucket::Entries entries = bucket->getEntries();
         auto wasFull = entries.size() >= Constants::MAX_ENTRIES_PER_BUCKET;
         for (auto& entry : entries) {
             // remove really old entries, ourselves and bootstrap nodes if the bucket is full
@@ -264,7 +248,7 @@ void RoutingTable::pingBuckets(std::function<void()> completeHandler) {
     auto bucketsRef = getBuckets();
 
     int total = 0;
-    for (auto& bucket : bucketsRef) {
+    for (auto& bucket : *bucketsRef) {
         if (bucket->size() > 0)
             total++;
     }
@@ -275,7 +259,7 @@ void RoutingTable::pingBuckets(std::function<void()> completeHandler) {
     }
 
     auto completion = std::make_shared<std::atomic<int>>(0);
-    for (auto& bucket : bucketsRef) {
+    for (auto& bucket : *bucketsRef) {
         if (bucket->size() == 0)
             continue;
 
@@ -301,7 +285,7 @@ void RoutingTable::pingBuckets(std::function<void()> completeHandler) {
 void RoutingTable::fillBuckets(std::function<void()> completeHandler) {
     auto bucketsRef = getBuckets();
     int total = 0;
-    for (auto& bucket : bucketsRef) {
+    for (auto& bucket : *bucketsRef) {
         if (bucket->size() < Constants::MAX_ENTRIES_PER_BUCKET)
             total++;
     }
@@ -312,7 +296,7 @@ void RoutingTable::fillBuckets(std::function<void()> completeHandler) {
     }
 
     auto completion = std::make_shared<std::atomic<int>>(0);
-    for (auto& bucket : bucketsRef) {
+    for (auto& bucket : *bucketsRef) {
         int num = bucket->size();
         // just try to fill partially populated buckets
         // not empty ones, they may arise as artifacts from deep splitting
@@ -327,6 +311,7 @@ void RoutingTable::fillBuckets(std::function<void()> completeHandler) {
             });
             auto task = dht.findNode(bucket->getPrefix().createRandomId(), handler);
             task->setName("Filling Bucket - " + bucket->getPrefix().toString());
+            task->setPriority(RPCCall::Priority::MAINTENANCE);
 
         }
     }
@@ -384,7 +369,8 @@ void RoutingTable::save(const std::string& path) {
     }
 
     nlohmann::json entries = nlohmann::json::array();
-    for (auto& bucket : getBuckets()) {
+    auto bucketsRef = getBuckets();
+    for (auto& bucket : *bucketsRef) {
         for (auto& entry : bucket->getEntries()) {
             entries.push_back(entry->toJson());
         }
@@ -407,7 +393,7 @@ std::vector<Sp<NodeInfo>> RoutingTable::getRandomEntries(int expect) {
     auto bucketsRef = getBuckets();
 
     int total = 0;
-    for (auto& bucket: bucketsRef) {
+    for (auto& bucket: *bucketsRef) {
         auto entries = bucket->getEntries();
         total += entries.size();
     }
@@ -415,7 +401,7 @@ std::vector<Sp<NodeInfo>> RoutingTable::getRandomEntries(int expect) {
     if (total <= expect) {
         std::vector<Sp<NodeInfo>> result;
         result.reserve(total);
-        for (auto& bucket: bucketsRef) {
+        for (auto& bucket: *bucketsRef) {
             auto entries = bucket->getEntries();
             result.insert(result.end(), entries.begin(), entries.end());
         }
@@ -448,13 +434,13 @@ std::vector<Sp<NodeInfo>> RoutingTable::getRandomEntries(int expect) {
 
     int index = 0;
     int entriesCount = 0;
-    for (auto& bucket: bucketsRef) {
+    for (auto& bucket: *bucketsRef) {
         auto entries = bucket->getEntries();
         auto entriesLenght = entries.size() + entriesCount;
 
         while (index < expect && randoms[index] < entriesLenght) {
             int pos = randoms[index] - entriesCount;
-            result[index] = list_get(entries, pos);
+            result[index] = entries[pos];
             index++;
         }
 
@@ -469,14 +455,14 @@ std::vector<Sp<NodeInfo>> RoutingTable::getRandomEntries(int expect) {
 std::string RoutingTable::toString() const {
     std::string str {};
 
-    auto buckets = getBuckets();
+    auto bucketsRef = getBuckets();
     str.append("buckets: ")
-        .append(std::to_string(buckets.size()))
+        .append(std::to_string(bucketsRef->size()))
         .append(" / entries: ")
         .append(std::to_string(getNumBucketEntries()))
         .append(1, '\n');
 
-    for (auto& bucket : buckets) {
+    for (auto& bucket : *bucketsRef) {
         str.append(bucket->toString()).append(1, '\n');
     }
     return str;
@@ -23,7 +23,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <list>
+#include <vector>
 #include <atomic>
 #include <functional>
 #include <memory>
@@ -47,19 +49,26 @@ class KBucket;
 class Task;
 class Operation;
 
+/*
+ * The buckets are kept in a vector sorted by prefix and are never modified in place.
+ * Splits and merges, which only happen on the DHT thread, publish a new vector, so a
+ * reader works on a consistent snapshot taken by getBuckets() without any locking.
+ */
 class RoutingTable {
 public:
+    using Buckets = std::vector<Sp<KBucket>>;
+
     RoutingTable(DHT& dht): dht(dht) {
-        buckets.emplace_back(std::make_shared<KBucket>(Prefix {}, true));
+        buckets = std::make_shared<const Buckets>(Buckets {std::make_shared<KBucket>(Prefix {}, true)});
         log = Logger::get("RoutingTable");
     }
 
-    const std::list<Sp<KBucket>>& getBuckets() const noexcept {
-        return buckets;
+    Sp<const Buckets> getBuckets() const noexcept {
+        return std::atomic_load(&buckets);
     }
 
-    void setBuckets(const std::list<Sp<KBucket>>& buckets) noexcept {
-        this->buckets = buckets;
+    void setBuckets(Sp<const Buckets> buckets) noexcept {
+        std::atomic_store(&this->buckets, std::move(buckets));
     }
 
     const DHT& getDHT() const noexcept {
@@ -67,34 +76,41 @@ public:
     }
 
     int size() const noexcept {
-        return getBuckets().size();
+        return getBuckets()->size();
     }
 
     const Sp<KBucket> getBucket(int index) const noexcept {
-        return list_get(getBuckets(), index);
+        return (*getBuckets())[index];
     }
     const Sp<KBucket> getBucket(const Id& id) const noexcept {
-        return list_get(getBuckets(), indexOf(getBuckets(), id));
+        auto bucketsRef = getBuckets();
+        return (*bucketsRef)[indexOf(*bucketsRef, id)];
     }
 
     const Sp<KBucketEntry> getEntry(const Id& id) const noexcept {
         return getBucket(id)->get(id);
     }
 
-    static int indexOf(const std::list<Sp<KBucket>>& bucketsRef, const Id& id);
+    // Index of the bucket covering the id, the last one with a prefix not above it
+    static int indexOf(const Buckets& bucketsRef, const Id& id) {
+        auto it = std::upper_bound(bucketsRef.begin(), bucketsRef.end(), id, [](const Id& id, const Sp<KBucket>& bucket) {
+            return id.compareTo(bucket->getPrefix()) < 0;
+        });
+        return it == bucketsRef.begin() ? 0 : int(it - bucketsRef.begin()) - 1;
+    }
 
     int getNumBucketEntries() const noexcept {
         int num {0};
-        for (const auto& bucket: getBuckets()) {
+        auto bucketsRef = getBuckets();
+        for (const auto& bucket: *bucketsRef) {
             num += bucket->size();
         }
         return num;
     }
 
     Sp<KBucketEntry> getRandomEntry() const {
-        const auto& bucketsRef = getBuckets();
-        auto it = std::next(bucketsRef.begin(), RandomGenerator<int>(0, bucketsRef.size() - 1)());
-        return (it != bucketsRef.end()) ? (*it)->random(): nullptr;
+        auto bucketsRef = getBuckets();
+        return (*bucketsRef)[RandomGenerator<int>(0, bucketsRef->size() - 1)()]->random();
     }
 
     std::vector<Sp<NodeInfo>> getRandomEntries(int expect);
@@ -151,7 +167,7 @@ private:
     void _maintenance();
 
     DHT& dht;
-    std::list<Sp<KBucket>> buckets {};
+    Sp<const Buckets> buckets {};
 
     long timeOfLastPingCheck {0};
 
@@ -21,6 +21,7 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -31,6 +32,7 @@
 #include "rpcserver.h"
 #include "constants.h"
 #include "kbucket_entry.h"
+#include "rtt_estimator.h"
 #include "task/candidate_node.h"
 
 namespace boson {
@@ -46,8 +48,10 @@ RPCCall::RPCCall(DHT& _dht, Sp<NodeInfo> _target, Sp<Message> _request)
 
     if (auto kbEntry = std::dynamic_pointer_cast<KBucketEntry>(_target)) {
         sourceWasKnownReachable = kbEntry->isReachable();
+        rtt = &kbEntry->getRTTEstimator();
     } else if (auto candidateNode = std::dynamic_pointer_cast<CandidateNode>(_target)) {
         sourceWasKnownReachable = candidateNode->isReachable();
+        rtt = &candidateNode->getRTTEstimator();
     } else {
         sourceWasKnownReachable = false;
     }
@@ -62,6 +66,13 @@ void RPCCall::updateState(State currentState) {
     switch (currentState) {
     case State::TIMEOUT:
         timeoutHandler(this);
+        // last: this may drop the final reference to the call
+        if (server != nullptr)
+            server->onTimeout(this);
+        break;
+    case State::CANCELED:
+        if (server != nullptr)
+            server->onCanceled(this);
         break;
     case State::STALLED:
         stallHandler(this);
@@ -74,17 +85,49 @@ void RPCCall::updateState(State currentState) {
     }
 }
 
+void RPCCall::updateDeadlines(const RTTHistogram& global) noexcept {
+    bool warm = global.count() >= static_cast<uint32_t>(Constants::RPC_CALL_RTT_MIN_SAMPLES);
+
+    // stall once the node is late by its own estimate, or by the network's when we never
+    // heard from it; a stalled call frees its slot so lookups move on to the next candidate
+    int stall = Constants::RPC_CALL_STALL_TIMEOUT_DEFAULT;
+    if (rtt != nullptr && rtt->hasSamples())
+        stall = static_cast<int>(rtt->getRTO());
+    else if (warm)
+        stall = static_cast<int>(global.percentile(0.9));
+
+    stallTimeout = std::clamp(stall, Constants::RPC_CALL_TIMEOUT_BASELINE_MIN, Constants::RPC_CALL_TIMEOUT_MAX);
+
+    // keep listening well past the stall, late responses still feed the routing table
+    if (warm) {
+        int timeout = std::max(stallTimeout * 4, static_cast<int>(global.percentile(0.99)) * 2);
+        callTimeout = std::clamp(timeout, stallTimeout, Constants::RPC_CALL_TIMEOUT_MAX);
+    } else {
+        callTimeout = Constants::RPC_CALL_TIMEOUT_MAX;
+    }
+}
+
 void RPCCall::sent(RPCServer* server) {
     sentTime = currentTimeMillis();
+    updateDeadlines(server->getStatistics().getRTTHistogram());
     updateState(State::SENT);
 
-    scheduler = std::ref(server->getScheduler());
-    // spread out the stalls by +- 1ms to reduce lock contention
-    // TODO:: Improve the time
-    // int smear = ThreadLocalRandom.current().nextInt(-1000, 1000);
-    // timeoutTimer = scheduler.schedule(this::checkTimeout,
-    //         expectedRTT * 1000 + smear, TimeUnit.MICROSECONDS);
-    timeoutTimer = scheduler->get().add(std::bind(&RPCCall::checkTimeout, this), 2000);
+    this->server = server;
+    timeoutTimer = server->getScheduler().add(std::bind(&RPCCall::checkTimeout, this), stallTimeout);
+}
+
+void RPCCall::failed() {
+    if (timeoutTimer != nullptr)
+        timeoutTimer->cancel();
+
+    updateState(State::TIMEOUT);
+}
+
+void RPCCall::cancel() {
+    if (timeoutTimer != nullptr)
+        timeoutTimer->cancel();
+
+    updateState(State::CANCELED);
 }
 
 void RPCCall::responsed(Sp<Message> response) {
@@ -98,6 +141,10 @@ void RPCCall::responsed(Sp<Message> response) {
     this->response = response;
     this->responseTime = currentTimeMillis();
 
+    // the routing table entry is refreshed by the DHT, candidates only live in their task
+    if (auto candidateNode = dynamic_cast<CandidateNode*>(target.get()))
+        candidateNode->signalRTT(getRTT());
+
     switch(response->getType()) {
     case Message::Type::RESPONSE:
         updateState(State::RESPONDED);
@@ -116,14 +163,13 @@ void RPCCall::checkTimeout() {
         return;
 
     int elapsed = currentTimeMillis() - sentTime;
-    int remaining = Constants::RPC_CALL_TIMEOUT_MAX - elapsed;
+    int remaining = callTimeout - elapsed;
 
     if (remaining > 0) {
-        updateState(State::STALLED);
-        // re-schedule for failed
-        //TODO:: need check the time is right
-        if (scheduler != std::nullopt)
-            timeoutTimer = scheduler->get().add(std::bind(&RPCCall::checkTimeout, this), remaining);
+        stall();
+        // re-arm the same timer for the final timeout
+        if (server != nullptr)
+            server->getScheduler().edit(timeoutTimer, remaining);
     } else {
         updateState(State::TIMEOUT);
     }
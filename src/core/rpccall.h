@@ -28,11 +28,14 @@
 #include "boson/node_info.h"
 #include "messages/message.h"
 #include "scheduler.h"
+#include "constants.h"
 
 namespace boson {
 
 class RPCServer;
 class DHT;
+class RTTEstimator;
+class RTTHistogram;
 
 class RPCCall {
 public:
@@ -46,6 +49,12 @@ public:
         RESPONDED
     };
 
+    // Admission order when the server is at its in-flight limit
+    enum class Priority {
+        USER = 0,       // lookups and announcements requested by the application
+        MAINTENANCE     // routing table pings and refreshes
+    };
+
     using StateChangeHandler = std::function<void(RPCCall*, State, State)>;
     using ResponseHandler = std::function<void(RPCCall*, Sp<Message>&)>;
     using StallHandler = std::function<void(RPCCall*)>;
@@ -90,10 +99,33 @@ public:
         return responseTime;
     }
 
+    // round-trip time in milliseconds, only meaningful once a response arrived
+    uint32_t getRTT() const noexcept {
+        return static_cast<uint32_t>(responseTime - sentTime);
+    }
+
+    // deadline after which the call no longer counts as in flight
+    int getStallTimeout() const noexcept {
+        return stallTimeout;
+    }
+
+    // deadline after which the call fails
+    int getCallTimeout() const noexcept {
+        return callTimeout;
+    }
+
     State getState() const noexcept {
         return state;
     }
 
+    Priority getPriority() const noexcept {
+        return priority;
+    }
+
+    void setPriority(Priority priority) noexcept {
+        this->priority = priority;
+    }
+
     bool isPending() const noexcept {
         // TODO: return state.ordinal() < State::TIMEOUT.ordinal();
         return false;
@@ -123,16 +155,8 @@ public:
         // TODO: responseSocketMismatch = true;
     }
 
-    void failed() {
-        updateState(State::TIMEOUT);
-    }
-
-    void cancel() {
-        if (timeoutTimer != nullptr)
-            timeoutTimer->cancel();
-
-        updateState(State::CANCELED);
-    }
+    void failed();
+    void cancel();
 
     void stall() {
         if (state == State::SENT)
@@ -149,6 +173,8 @@ public:
     }
 
 private:
+    void updateDeadlines(const RTTHistogram& global) noexcept;
+
     DHT& dht;
     Sp<NodeInfo> target;
 
@@ -156,18 +182,23 @@ private:
     Sp<Message> response {};
 
     bool sourceWasKnownReachable {false};
+    const RTTEstimator* rtt {nullptr};     // owned by the target
 
     uint64_t sentTime = std::numeric_limits<uint64_t>::max();
     uint64_t responseTime = std::numeric_limits<uint64_t>::max();
 
+    int stallTimeout {Constants::RPC_CALL_STALL_TIMEOUT_DEFAULT};
+    int callTimeout {Constants::RPC_CALL_TIMEOUT_MAX};
+
     State state {State::UNSENT};
+    Priority priority {Priority::MAINTENANCE};
 
     StateChangeHandler stateChangeHandler;
     ResponseHandler responseHandler;
     StallHandler stallHandler;
     TimeoutHandler timeoutHandler;
 
-    std::optional<std::reference_wrapper<Scheduler>> scheduler {std::nullopt};
+    RPCServer* server {nullptr};
     Sp<Scheduler::Job> timeoutTimer {};
 
     size_t hashValue {0};
@@ -29,8 +29,16 @@
 #include <winsock2.h>
 #endif
 
+#ifdef HAVE_EPOLL
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
 #include "boson/node.h"
 #include "utils/time.h"
+#include "utils/log_formatters.h"
 #include "utils/random_generator.h"
 #include "exceptions/dht_error.h"
 #include "messages/message.h"
@@ -43,6 +51,49 @@
 
 namespace boson {
 
+/*
+ * Receive/send scratch space for the batched datagram I/O, owned by a single
+ * thread: recvmmsg() fills the datagram slots, sendmmsg() reuses the message
+ * headers to point at the queued outbound datagrams.
+ */
+struct DatagramBatch {
+    DatagramBatch(size_t _capacity, size_t _datagramSize)
+        : capacity(_capacity), datagramSize(_datagramSize),
+          buffer(_capacity * _datagramSize), addrs(_capacity), lengths(_capacity)
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+        , iovecs(_capacity), headers(_capacity)
+#endif
+    {}
+
+    uint8_t* datagram(size_t index) noexcept {
+        return buffer.data() + index * datagramSize;
+    }
+
+    void setHeader(size_t index, void* data, size_t length, void* addr, socklen_t addrlen) noexcept {
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+        iovecs[index].iov_base = data;
+        iovecs[index].iov_len = length;
+
+        std::memset(&headers[index], 0, sizeof(mmsghdr));
+        headers[index].msg_hdr.msg_name = addr;
+        headers[index].msg_hdr.msg_namelen = addrlen;
+        headers[index].msg_hdr.msg_iov = &iovecs[index];
+        headers[index].msg_hdr.msg_iovlen = 1;
+#endif
+    }
+
+    const size_t capacity;
+    const size_t datagramSize;
+
+    std::vector<uint8_t> buffer;
+    std::vector<sockaddr_storage> addrs;
+    std::vector<size_t> lengths;
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+    std::vector<iovec> iovecs;
+    std::vector<mmsghdr> headers;
+#endif
+};
+
 RPCServer::RPCServer(Node& _node, const Sp<DHT> _dht4, const Sp<DHT> _dht6): node(_node),
     dht4(_dht4 ? std::optional<std::reference_wrapper<DHT>>(*_dht4) : std::nullopt),
     dht6(_dht6 ? std::optional<std::reference_wrapper<DHT>>(*_dht6) : std::nullopt) {
@@ -51,6 +102,30 @@ RPCServer::RPCServer(Node& _node, const Sp<DHT> _dht4, const Sp<DHT> _dht6): nod
 
     log = Logger::get("RpcServer");
 
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+    size_t batchSize = Constants::RPC_SERVER_IO_BATCH_SIZE;
+#else
+    size_t batchSize = 1;
+#endif
+    batch = std::make_unique<DatagramBatch>(batchSize, Constants::RPC_SERVER_MAX_DATAGRAM_SIZE);
+
+    auto config = node.getConfig();
+    rxWorkers = config ? config->receiveWorkers() : 0;
+    packetWorkers = config ? config->packetWorkers() : 0;
+    verifyWorkers = config ? config->verifyWorkers() : 0;
+#if !defined(HAVE_EPOLL) || !defined(SO_REUSEPORT)
+    if (rxWorkers > 0) {
+        log->warn("SO_REUSEPORT receive workers are not supported on this platform, use the single receive thread");
+        rxWorkers = 0;
+    }
+#endif
+#ifndef HAVE_EPOLL
+    if (packetWorkers > 0) {
+        log->warn("Packet workers are not supported on this platform, decode the packets on the receive thread");
+        packetWorkers = 0;
+    }
+#endif
+
     SocketAddress bind4, bind6;
     if (_dht4 != nullptr)
         bind4 = _dht4->getOrigin();
@@ -64,6 +139,13 @@ RPCServer::~RPCServer() {
     stop();
     if (rcv_thread.joinable())
         rcv_thread.join();
+
+#ifdef HAVE_EPOLL
+    if (epollFd >= 0)
+        close(epollFd);
+    if (wakeupFd >= 0)
+        close(wakeupFd);
+#endif
 }
 
 static bool setNonblocking(int fd, bool nonblocking = true)
@@ -86,7 +168,7 @@ static bool setNonblocking(int fd, bool nonblocking = true)
 #endif
 }
 
-static int bindSocket(const SocketAddress& addr, SocketAddress& bound)
+static int bindSocket(const SocketAddress& addr, SocketAddress& bound, bool reusePort = false)
 {
     int sock = socket(addr.family(), SOCK_DGRAM, 0);
     if (sock < 0)
@@ -98,6 +180,10 @@ static int bindSocket(const SocketAddress& addr, SocketAddress& bound)
 #endif
     if (addr.family() == AF_INET6)
         setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&set, sizeof(set));
+#ifdef SO_REUSEPORT
+    if (reusePort)
+        setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char*)&set, sizeof(set));
+#endif
 
     setNonblocking(sock);
     int rc = bind(sock, addr.addr(), addr.length());
@@ -127,12 +213,15 @@ int RPCServer::sendData(Sp<Message>& msg) {
     }
 
     int sockfd = -1;
+    std::vector<Datagram>* queue = nullptr;
     switch (remoteAddr.family()) {
         case AF_INET:
             sockfd = sock4;
+            queue = &outbound4;
             break;
         case AF_INET6:
             sockfd = sock6;
+            queue = &outbound6;
             break;
         default:
             throw std::runtime_error("Unsupported address family!");
@@ -141,35 +230,349 @@ int RPCServer::sendData(Sp<Message>& msg) {
     if (sockfd < 0)
         throw std::runtime_error("Socket fd is error!!!");
 
+    // encode right behind the headroom and encrypt in place, no extra copies
+    auto packet = packetPool.acquire();
+    try {
+        msg->serialize(packet);
+        auto plain = packet.plain();
+        auto cipher = packet.cipher();
+        node.encrypt(msg->getRemoteId(), cipher, plain);
+        packet.setSender(msg->getId());
+    } catch (...) {
+        packetPool.release(std::move(packet));
+        throw;
+    }
+
+    // Queued datagrams go out at the end of the current event loop round,
+    // or as soon as a full batch is ready.
+    queue->push_back({msg, std::move(packet)});
+    if (queue->size() >= batch->capacity)
+        flushOutbound(sockfd, *queue);
+
+    // The socket buffer stays full, don't let the backlog pin the pooled
+    // buffers and messages without bound: the oldest ones are the stalest.
+    size_t capacity = Constants::RPC_SERVER_OUTBOUND_QUEUE_CAPACITY;
+    if (queue->size() > capacity) {
+        size_t excess = queue->size() - capacity;
+        for (size_t i = 0; i < excess; i++) {
+            auto& dropped = (*queue)[i];
+            log->debug("Send queue is full, dropped {}/{} to {}", dropped.message->getMethodString(),
+                    dropped.message->getTypeString(), dropped.message->getRemoteAddress());
+            stats.onDroppedOutbound(dropped.packet.size());
+            packetPool.release(std::move(dropped.packet));
+        }
+        queue->erase(queue->begin(), queue->begin() + excess);
+    }
+
+    return 0;
+}
+
+void RPCServer::flushOutbound() {
+    if (!outbound4.empty())
+        flushOutbound(sock4, outbound4);
+    if (!outbound6.empty())
+        flushOutbound(sock6, outbound6);
+}
+
+void RPCServer::flushOutbound(int sockfd, std::vector<Datagram>& queue) {
+    if (sockfd < 0) {
+        for (auto& dgram : queue)
+            packetPool.release(std::move(dgram.packet));
+        queue.clear();
+        return;
+    }
+
     int flags = 0;
     #ifdef MSG_NOSIGNAL
         flags |= MSG_NOSIGNAL;
     #endif
-    #ifdef MSG_CONFIRM
-        //if (replied)
-            //flags |= MSG_CONFIRM;
-    #endif
 
-    auto buffer = msg->serialize();
-    auto encrypted = node.encrypt(msg->getRemoteId(), {buffer});
-    buffer.resize(ID_BYTES + encrypted.size());
-    std::memcpy(buffer.data(), msg->getId().data(), ID_BYTES);
-    std::memcpy(buffer.data() + ID_BYTES, encrypted.data(), encrypted.size());
-
-    int ret = sendto(sockfd, (char*)buffer.data(), buffer.size(), flags, remoteAddr.addr(), remoteAddr.length());
-    if (ret == 0 || (ret == -1 && errno == EAGAIN)) {
-        messageQueue.push(msg);
-        return EAGAIN;
-    } else if (ret == -1) {
-        log->debug("Failed to send message to {}: {}", remoteAddr.toString(), std::strerror(errno));
-        return errno;
-    } else {
-        stats.onSentBytes(buffer.size());
-        stats.onSentMessage(*msg);
+    size_t next = 0;
+    while (next < queue.size()) {
+#ifdef HAVE_SENDMMSG
+        size_t n = std::min(queue.size() - next, batch->capacity);
+        for (size_t i = 0; i < n; i++) {
+            auto& dgram = queue[next + i];
+            const auto& remoteAddr = dgram.message->getRemoteAddress();
+            batch->setHeader(i, const_cast<uint8_t*>(dgram.packet.bytes()), dgram.packet.size(),
+                    const_cast<sockaddr*>(remoteAddr.addr()), remoteAddr.length());
+        }
 
-        log->debug("Sent {}/{} to {}: [{}] {}", msg->getMethodString(), msg->getTypeString(),
-                msg->getRemoteAddress().toString(), buffer.size(), msg->toString());
-        return 0;
+        int rc = sendmmsg(sockfd, batch->headers.data(), n, flags);
+#else
+        auto& dgram = queue[next];
+        const auto& remoteAddr = dgram.message->getRemoteAddress();
+        int rc = sendto(sockfd, (char*)dgram.packet.bytes(), dgram.packet.size(), flags, remoteAddr.addr(), remoteAddr.length());
+        if (rc > 0)
+            rc = 1;
+#endif
+        if (rc == 0 || (rc == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+            // socket buffer is full, keep the rest for the next round
+            break;
+        } else if (rc == -1) {
+            // the first pending datagram was rejected, drop it and go on with the others
+            log->debug("Failed to send message to {}: {}",
+                    queue[next].message->getRemoteAddress(), std::strerror(errno));
+            packetPool.release(std::move(queue[next].packet));
+            next++;
+            continue;
+        }
+
+        stats.onSentBatch(rc);
+        for (int i = 0; i < rc; i++, next++) {
+            auto& sent = queue[next];
+            stats.onSentBytes(sent.packet.size());
+            stats.onSentMessage(*sent.message);
+
+            log->debug("Sent {}/{} to {}: [{}] {}", sent.message->getMethodString(), sent.message->getTypeString(),
+                    sent.message->getRemoteAddress(), sent.packet.size(), *sent.message);
+            packetPool.release(std::move(sent.packet));
+        }
+    }
+
+    // the vector keeps its capacity, steady state sending doesn't allocate
+    queue.erase(queue.begin(), queue.begin() + next);
+}
+
+int RPCServer::receiveBatch(int sockfd, DatagramBatch& batch) {
+#ifdef HAVE_RECVMMSG
+    for (size_t i = 0; i < batch.capacity; i++)
+        batch.setHeader(i, batch.datagram(i), batch.datagramSize, &batch.addrs[i], sizeof(sockaddr_storage));
+
+    int rc = recvmmsg(sockfd, batch.headers.data(), batch.capacity, MSG_DONTWAIT, nullptr);
+    if (rc <= 0)
+        return rc;
+
+    for (int i = 0; i < rc; i++)
+        batch.lengths[i] = batch.headers[i].msg_len;
+#else
+    socklen_t from_len = sizeof(sockaddr_storage);
+    int rc = recvfrom(sockfd, (char*)batch.datagram(0), batch.datagramSize, 0, (sockaddr*)&batch.addrs[0], &from_len);
+    if (rc <= 0)
+        return rc;
+
+    batch.lengths[0] = rc;
+    rc = 1;
+#endif
+
+    stats.onReceivedBatch(rc);
+    return rc;
+}
+
+int RPCServer::receivePackets(int sockfd) {
+    int rc = receiveBatch(sockfd, *batch);
+    if (rc > 0 && decodeQueue) {
+        enqueuePackets(*batch, rc);
+        return rc;
+    }
+
+    for (int i = 0; i < rc; i++) {
+        SocketAddress from = {batch->addrs[i]};
+        handlePacket(batch->datagram(i), batch->lengths[i], from);
+    }
+    return rc;
+}
+
+#if defined(HAVE_EPOLL) && defined(SO_REUSEPORT)
+void RPCServer::receiveWorker(int sockfd) {
+    DatagramBatch workerBatch(batch->capacity, batch->datagramSize);
+    pollfd fds[2] = {
+        { sockfd, POLLIN, 0 },
+        { stopFd, POLLIN, 0 }
+    };
+
+    try {
+        while (running) {
+            int rc = poll(fds, 2, -1);
+            if (rc < 0) {
+                if (errno != EINTR) {
+                    log->error("Poll error in receive worker: {}", strerror(errno));
+                    std::this_thread::sleep_for(std::chrono::seconds(1));
+                }
+                continue;
+            }
+
+            // the stop event is never consumed, so it wakes up all the workers
+            if (!running || (fds[1].revents & POLLIN))
+                break;
+
+            if (!(fds[0].revents & POLLIN))
+                continue;
+
+            rc = receiveBatch(sockfd, workerBatch);
+            if (rc < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                    log->error("Error receiving packet: {}", strerror(errno));
+                continue;
+            }
+
+            if (decodeQueue) {
+                enqueuePackets(workerBatch, rc);
+                continue;
+            }
+
+            // decrypt and parse here, hand the messages over to the rx thread in arrival order
+            for (int i = 0; i < rc; i++) {
+                SocketAddress from = {workerBatch.addrs[i]};
+                auto started = steadyTimeMicros();
+                auto msg = decodePacket(workerBatch.datagram(i), workerBatch.lengths[i], from);
+                auto now = steadyTimeMicros();
+                stats.onStageProcessed(RPCStatistics::Stage::DECODE, 0, now - started);
+                if (msg)
+                    enqueueMessage(std::move(msg), workerBatch.lengths[i], now);
+            }
+        }
+    } catch (const std::exception& e) {
+        log->error("Error in RPCServer receive worker: {}", e.what());
+    }
+}
+
+void RPCServer::startReceiveWorkers() {
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd < 0)
+        throw std::runtime_error("Failed to create eventfd: " + std::string(std::strerror(errno)));
+
+    auto start = [this](int primary, SocketAddress& bound) {
+        if (primary < 0)
+            return;
+
+        workers.emplace_back(&RPCServer::receiveWorker, this, primary);
+        for (int i = 1; i < rxWorkers; i++) {
+            SocketAddress addr;
+            int sockfd = bindSocket(bound, addr, true);
+            workerSockets.push_back(sockfd);
+            workers.emplace_back(&RPCServer::receiveWorker, this, sockfd);
+        }
+    };
+
+    start(sock4, bound4);
+    start(sock6, bound6);
+
+    log->info("Started {} receive workers per address family", rxWorkers);
+}
+
+void RPCServer::stopReceiveWorkers() {
+    if (stopFd >= 0) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto n = write(stopFd, &one, sizeof(one));
+    }
+
+    for (auto& worker : workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+
+    for (auto sockfd : workerSockets)
+        close(sockfd);
+    workerSockets.clear();
+
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+}
+#endif
+
+#ifdef HAVE_EPOLL
+void RPCServer::decodeWorker() {
+    RawPacket packet;
+
+    while (running) {
+        if (!decodeQueue->pop(packet)) {
+            std::unique_lock<std::mutex> lk(decodeLock);
+            decodeReady.wait(lk, [this]() {
+                return !running || !decodeQueue->empty();
+            });
+            continue;
+        }
+
+        try {
+            auto msg = decodePacket(packet.data.data(), packet.data.size(), packet.from);
+            auto now = steadyTimeMicros();
+            stats.onStageProcessed(RPCStatistics::Stage::DECODE, decodeQueue->size(), now - packet.received);
+            if (msg)
+                enqueueMessage(std::move(msg), packet.data.size(), now);
+        } catch (const std::exception& e) {
+            log->error("Error in RPCServer packet worker: {}", e.what());
+        }
+    }
+}
+
+void RPCServer::startDecodeWorkers() {
+    decodeQueue = std::make_unique<BoundedQueue<RawPacket>>(Constants::RPC_SERVER_DECODE_QUEUE_CAPACITY);
+    for (int i = 0; i < packetWorkers; i++)
+        decoders.emplace_back(&RPCServer::decodeWorker, this);
+
+    log->info("Started {} packet workers", packetWorkers);
+}
+
+void RPCServer::stopDecodeWorkers() {
+    {
+        std::lock_guard<std::mutex> lk(decodeLock);
+    }
+    decodeReady.notify_all();
+
+    for (auto& decoder : decoders) {
+        if (decoder.joinable())
+            decoder.join();
+    }
+    decoders.clear();
+}
+#endif
+
+void RPCServer::enqueuePackets(DatagramBatch& received, int count) {
+    auto now = steadyTimeMicros();
+    bool queued = false;
+
+    for (int i = 0; i < count; i++) {
+        const uint8_t* data = received.datagram(i);
+        RawPacket packet { {data, data + received.lengths[i]}, {received.addrs[i]}, now };
+        if (decodeQueue->push(std::move(packet))) {
+            queued = true;
+        } else {
+            stats.onDroppedPacket(received.lengths[i]);
+            log->debug("Packet decode queue is full, dropped packet from {}", SocketAddress(received.addrs[i]));
+        }
+    }
+
+    if (queued) {
+        stats.onStageEnqueued(RPCStatistics::Stage::DECODE, decodeQueue->size());
+        // pairs with the predicate check in decodeWorker(), no lost wakeups
+        {
+            std::lock_guard<std::mutex> lk(decodeLock);
+        }
+        if (count == 1)
+            decodeReady.notify_one();
+        else
+            decodeReady.notify_all();
+    }
+}
+
+bool RPCServer::enqueueMessage(Sp<Message>&& msg, size_t packetSize, uint64_t now) {
+    if (!inbound->push({std::move(msg), now})) {
+        stats.onDroppedPacket(packetSize);
+        log->debug("Inbound message queue is full, dropped message");
+        return false;
+    }
+
+    stats.onStageEnqueued(RPCStatistics::Stage::DISPATCH, inbound->size());
+    // one wakeup per drain: the rx thread clears the flag before it pops,
+    // so a message pushed after that raises it, and signals, again
+    if (!inboundSignaled.exchange(true))
+        wakeup();
+
+    return true;
+}
+
+void RPCServer::dispatchInbound() {
+    inboundSignaled = false;
+
+    // bounded per round, so the timers still run under a flood of packets
+    InboundMessage item;
+    for (size_t i = 0; i < inbound->capacity() && inbound->pop(item); i++) {
+        stats.onStageProcessed(RPCStatistics::Stage::DISPATCH, inbound->size(), steadyTimeMicros() - item.enqueued);
+        dispatchMessage(item.message);
     }
 }
 
@@ -182,7 +585,7 @@ RPCServer::bindSockets(const SocketAddress& bind4, const SocketAddress& bind6)
     bound4 = {};
     if (bind4) {
         try {
-            sock4 = bindSocket(bind4, bound4);
+            sock4 = bindSocket(bind4, bound4, rxWorkers > 0);
         } catch (const DhtError& e) {
             if (log)
                 log->error("Can't bind inet socket: {}", e.what());
@@ -196,7 +599,7 @@ RPCServer::bindSockets(const SocketAddress& bind4, const SocketAddress& bind6)
             if (auto p4 = bound4.port()) {
                 auto b6 = SocketAddress({bind6.inaddr(), bind6.inaddrLength()}, p4);
                 try {
-                    sock6 = bindSocket(b6, bound6);
+                    sock6 = bindSocket(b6, bound6, rxWorkers > 0);
                 } catch (const DhtError& e) {
                     if (log)
                         log->error("Can't bind inet6 socket: {}", e.what());
@@ -205,7 +608,7 @@ RPCServer::bindSockets(const SocketAddress& bind4, const SocketAddress& bind6)
         }
         if (sock6 == -1) {
             try {
-                sock6 = bindSocket(bind6, bound6);
+                sock6 = bindSocket(bind6, bound6, rxWorkers > 0);
             } catch (const DhtError& e) {
                 if (log)
                     log->error("Can't bind inet6 socket: {}", e.what());
@@ -218,40 +621,178 @@ RPCServer::bindSockets(const SocketAddress& bind4, const SocketAddress& bind6)
     }
 }
 
+#ifdef HAVE_EPOLL
+void RPCServer::watchSocket(int sockfd) {
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = sockfd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, sockfd, &ev) < 0)
+        log->error("Can't watch socket {}: {}", sockfd, strerror(errno));
+}
+#endif
+
+int RPCServer::waitTimeout() {
+    // messages left over from the last round
+    if (inbound && !inbound->empty())
+        return 0;
+
+    // datagrams held back by a full socket buffer, retry soon
+    if (!outbound4.empty() || !outbound6.empty())
+        return Constants::RPC_SERVER_SEND_RETRY_INTERVAL;
+
+    // calls held back by the destination pacing, check again once a token is refilled
+    int limit = hasAdmissibleCalls() ? 1000 / Constants::RPC_CALL_DESTINATION_RATE : -1;
+
+    uint64_t next = scheduler.getNextJobTime();
+    if (next == std::numeric_limits<uint64_t>::max())
+        return limit;
+
+    uint64_t now = currentTimeMillis();
+    if (next <= now)
+        return 0;
+
+    int timeout = static_cast<int>(std::min<uint64_t>(next - now, std::numeric_limits<int>::max()));
+    return limit < 0 ? timeout : std::min(timeout, limit);
+}
+
+int RPCServer::waitForEvents(int ls4, int ls6, bool& readable4, bool& readable6) {
+    readable4 = false;
+    readable6 = false;
+
+#ifdef HAVE_EPOLL
+    std::array<epoll_event, 4> events;
+    int rc = epoll_wait(epollFd, events.data(), events.size(), waitTimeout());
+    for (int i = 0; i < rc; i++) {
+        int fd = events[i].data.fd;
+        if (fd == wakeupFd) {
+            uint64_t count;
+            [[maybe_unused]] auto n = read(wakeupFd, &count, sizeof(count));
+        } else if (fd == ls4) {
+            readable4 = true;
+        } else if (fd == ls6) {
+            readable6 = true;
+        }
+    }
+    return rc;
+#else
+    fd_set readfds;
+    FD_ZERO(&readfds);
+
+    if (ls4 >= 0)
+        FD_SET(ls4, &readfds);
+    if (ls6 >= 0)
+        FD_SET(ls6, &readfds);
+
+    // without a wakeup fd, poll at least every 100ms for work posted by other threads
+    int timeout = waitTimeout();
+    if (timeout < 0 || timeout > 100)
+        timeout = 100;
+
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+
+    int rc = select(std::max({ls4, ls6}) + 1, &readfds, NULL, NULL, &tv);
+    if (rc > 0) {
+        readable4 = ls4 >= 0 && FD_ISSET(ls4, &readfds);
+        readable6 = ls6 >= 0 && FD_ISSET(ls6, &readfds);
+    }
+    return rc;
+#endif
+}
+
+void RPCServer::wakeup() {
+#ifdef HAVE_EPOLL
+    if (wakeupFd >= 0) {
+        uint64_t one = 1;
+        [[maybe_unused]] auto n = write(wakeupFd, &one, sizeof(one));
+    }
+#endif
+}
+
+void RPCServer::post(std::function<void()>&& job) {
+    {
+        std::lock_guard<std::mutex> lk(postLock);
+        posted.emplace_back(std::move(job));
+    }
+    wakeup();
+}
+
+void RPCServer::runPosted() {
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard<std::mutex> lk(postLock);
+        if (posted.empty())
+            return;
+        jobs.swap(posted);
+    }
+
+    // one failing job must not drop the rest, nor stop the rx thread
+    for (auto& job : jobs) {
+        try {
+            job();
+        } catch (const std::exception& e) {
+            log->error("Error in a posted job, ignored: {}", e.what());
+        }
+    }
+}
+
 void
 RPCServer::openSockets()
 {
+#ifdef HAVE_EPOLL
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd < 0)
+        throw std::runtime_error("Failed to create eventfd: " + std::string(std::strerror(errno)));
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0)
+        throw std::runtime_error("Failed to create epoll instance: " + std::string(std::strerror(errno)));
+
+    watchSocket(wakeupFd);
+    // with receive workers the rx thread only waits for the wakeup events
+    if (sock4 >= 0 && rxWorkers == 0)
+        watchSocket(sock4);
+    if (sock6 >= 0 && rxWorkers == 0)
+        watchSocket(sock6);
+#endif
+
+    // The rx thread computes its wait timeout from the next job right before
+    // sleeping, so only jobs added by other threads need to interrupt the wait.
+    scheduler.setWakeupHandler([this]() {
+        if (std::this_thread::get_id() != rcv_thread.get_id())
+            wakeup();
+    });
+
     running = true;
-    rcv_thread = std::thread([this, ls4=sock4, ls6=sock6]() mutable {
-        int selectFd = std::max({ls4, ls6}) + 1;
-        struct timeval timeout;
 
-// TODO:: will be remove
-        // //--------------------For Debug-----------------------
-        // char name[16];
-        // snprintf(name, 16, "Tread%d", num++);
-        // pthread_setname_np(name);
+    if (rxWorkers > 0 || packetWorkers > 0)
+        inbound = std::make_unique<BoundedQueue<InboundMessage>>(Constants::RPC_SERVER_INBOUND_QUEUE_CAPACITY);
 
-        try {
-            while (running) {
-                fd_set readfds;
-                FD_ZERO(&readfds);
+#ifdef HAVE_EPOLL
+    if (packetWorkers > 0)
+        startDecodeWorkers();
+#endif
 
-                if (ls4 >= 0) {
-                    FD_SET(ls4, &readfds);
-                }
-                if (ls6 >= 0) {
-                    FD_SET(ls6, &readfds);
-                }
+#if defined(HAVE_EPOLL) && defined(SO_REUSEPORT)
+    if (rxWorkers > 0)
+        startReceiveWorkers();
+#endif
 
-                timeout.tv_sec = 0;
-                timeout.tv_usec = 100000;
+    if (verifyWorkers > 0) {
+        verifier.start(verifyWorkers);
+        log->info("Started {} signature verify workers", verifyWorkers);
+    }
 
-                int rc = select(selectFd, &readfds, NULL, NULL, &timeout);
+    rcv_thread = std::thread([this, ls4=sock4, ls6=sock6]() mutable {
+        try {
+            while (running) {
+                bool readable4, readable6;
+                int rc = waitForEvents(ls4, ls6, readable4, readable6);
                 if (rc < 0) {
                     if (errno != EINTR) {
                         if (log)
-                            log->error("Select error: {}", strerror(errno));
+                            log->error("Poll error: {}", strerror(errno));
                         std::this_thread::sleep_for(std::chrono::seconds(1));
                     }
                 }
@@ -259,25 +800,17 @@ RPCServer::openSockets()
                 if (not running)
                     break;
 
-                if (rc > 0) {
-                    std::array<uint8_t, 1024 * 64> buf;
-                    sockaddr_storage from;
-                    socklen_t from_len = sizeof(from);
-
-                    if (ls4 >= 0 && FD_ISSET(ls4, &readfds))
-                        rc = recvfrom(ls4, (char*)buf.data(), (size_t)buf.size(), 0, (sockaddr*)&from, &from_len);
-                    else if (ls6 >= 0 && FD_ISSET(ls6, &readfds))
-                        rc = recvfrom(ls6, (char*)buf.data(), (size_t)buf.size(), 0, (sockaddr*)&from, &from_len);
-                    else
-                        continue;
-
-                    if (rc > 0) {
-                        SocketAddress addr = {from};
-                        handlePacket((uint8_t*)buf.data(), rc, addr);
-                    } else if (rc == -1) {
+                if (readable4 || readable6) {
+                    // drain both sockets, up to one batch of datagrams each per wakeup
+                    int err = 0;
+                    if (readable4 && receivePackets(ls4) < 0)
+                        err = errno;
+                    if (readable6 && receivePackets(ls6) < 0)
+                        err = errno;
+
+                    if (err != 0 && err != EAGAIN && err != EWOULDBLOCK) {
                         if (log)
-                            log->error("Error receiving packet: {}", strerror(errno));
-                        int err = errno;
+                            log->error("Error receiving packet: {}", strerror(err));
                         if (err == EPIPE || err == ENOTCONN || err == ECONNRESET) {
                             if (not running) break;
                             std::unique_lock<std::mutex> lk(lock, std::try_to_lock);
@@ -313,7 +846,13 @@ RPCServer::openSockets()
                                     break;
                                 sock4 = ls4;
                                 sock6 = ls6;
-                                selectFd = std::max({ls4, ls6}) + 1;
+#ifdef HAVE_EPOLL
+                                // closed sockets already left the epoll set
+                                if (ls4 >= 0)
+                                    watchSocket(ls4);
+                                if (ls6 >= 0)
+                                    watchSocket(ls6);
+#endif
                             } else {
                                 break;
                             }
@@ -321,6 +860,10 @@ RPCServer::openSockets()
                     }
                 }
 
+                if (inbound)
+                    dispatchInbound();
+
+                runPosted();
                 periodic();
             }
         } catch (const std::exception& e) {
@@ -328,6 +871,17 @@ RPCServer::openSockets()
                 log->error("Error in RPCServer rx thread: {}", e.what());
         }
 
+#if defined(HAVE_EPOLL) && defined(SO_REUSEPORT)
+        // the workers share the primary sockets, stop them before closing
+        if (rxWorkers > 0)
+            stopReceiveWorkers();
+#endif
+#ifdef HAVE_EPOLL
+        if (packetWorkers > 0)
+            stopDecodeWorkers();
+#endif
+        verifier.stop();
+
         if (ls4 >= 0) {
 #if defined(_WIN32) || defined(_WIN64)
             closesocket(ls4);
@@ -379,6 +933,8 @@ void RPCServer::stop() {
     if (!running.exchange(false))
         return;
 
+    wakeup();
+
     if (rcv_thread.joinable())
         rcv_thread.join();
 
@@ -403,40 +959,140 @@ void RPCServer::updateReachability(uint64_t now) {
 }
 
 void RPCServer::sendCall(Sp<RPCCall>& call) {
-    int txid = nextTxid++;
-    if (txid == 0) // 0 is invalid txid, skip
-        txid = nextTxid++;
+    uint64_t now = currentTimeMillis();
+
+    // fast path: nobody is waiting ahead of this call
+    if (queuedCalls == 0 && !transactions.full() &&
+            acquireToken(call->getRequest()->getRemoteAddress(), now)) {
+        dispatchCall(call);
+        return;
+    }
 
-    if (calls.find(txid) != calls.end())
-        throw std::runtime_error("Transaction ID already exists");
+    callQueue[static_cast<int>(call->getPriority())].push_back({call, now});
+    stats.onCallQueued(++queuedCalls);
 
-    call->getRequest()->setTxid(txid);
-    calls[txid] = call;
-    dispatchCall(call);
+    processCallQueue();
 }
 
-void RPCServer::dispatchCall(Sp<RPCCall>& call) {
-    auto request = call->getRequest();
-    assert(request != nullptr);
+bool RPCServer::acquireToken(const SocketAddress& dest, uint64_t now) {
+    auto [it, created] = destinations.try_emplace(dest,
+            DestinationBucket{static_cast<double>(Constants::RPC_CALL_DESTINATION_BURST), now});
+
+    auto& bucket = it->second;
+    if (!created && now > bucket.updated) {
+        double refill = (now - bucket.updated) * Constants::RPC_CALL_DESTINATION_RATE / 1000.0;
+        bucket.tokens = std::min<double>(bucket.tokens + refill, Constants::RPC_CALL_DESTINATION_BURST);
+    }
+    bucket.updated = now;
+
+    if (bucket.tokens < 1.0)
+        return false;
 
-    auto responseHandler = [](RPCCall*, Sp<Message>&) {};
-    auto timeoutHandler = [=](RPCCall* _call) {
-        stats.onTimeoutMessage(*_call->getRequest());
-        auto it = calls.find(_call->getRequest()->getTxid());
-        if (it != calls.end()) {
-            it->second->getDHT().onTimeout(_call);
-            calls.erase(it);
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+void RPCServer::sweepDestinations(uint64_t now) {
+    // a bucket that refilled completely carries no state, forget it
+    uint64_t idle = 1000ull * Constants::RPC_CALL_DESTINATION_BURST / Constants::RPC_CALL_DESTINATION_RATE;
+    for (auto it = destinations.begin(); it != destinations.end();) {
+        if (now - it->second.updated >= idle)
+            it = destinations.erase(it);
+        else
+            ++it;
+    }
+
+    lastDestinationSweep = now;
+}
+
+bool RPCServer::hasAdmissibleCalls() const {
+    return queuedCalls > 0 && !transactions.full();
+}
+
+void RPCServer::processCallQueue() {
+    // calls dispatched below may queue new calls from their state handlers
+    if (processingCalls || !hasAdmissibleCalls())
+        return;
+
+    processingCalls = true;
+    uint64_t now = currentTimeMillis();
+
+    for (auto& queue : callQueue) {
+        auto it = queue.begin();
+        while (it != queue.end() && !transactions.full()) {
+            // canceled while waiting
+            if (it->call->getState() != RPCCall::State::UNSENT) {
+                stats.onCallDequeued(--queuedCalls, now - it->enqueued);
+                it = queue.erase(it);
+                continue;
+            }
+
+            // destination is paced, let the calls to other nodes pass
+            if (!acquireToken(it->call->getRequest()->getRemoteAddress(), now)) {
+                ++it;
+                continue;
+            }
+
+            auto call = std::move(it->call);
+            stats.onCallDequeued(--queuedCalls, now - it->enqueued);
+            it = queue.erase(it);
+            dispatchCall(call);
         }
-    };
+    }
 
+    processingCalls = false;
+}
 
-    call->addTimeoutHandler(timeoutHandler);
-    call->addResponseHandler(responseHandler);
+void RPCServer::dispatchCall(Sp<RPCCall>& call) {
+    // skip 0 (invalid) and txids still held by calls from before the counter wrapped around
+    int txid;
+    do {
+        txid = nextTxid;
+        nextTxid = txid == std::numeric_limits<int>::max() ? 1 : txid + 1;
+    } while (txid == 0 || transactions.contains(txid));
+
+    // calls are admitted only while the table has room, the hard deadline
+    // only catches calls that never reached a final state
+    uint64_t deadline = currentTimeMillis() + 2 * Constants::RPC_CALL_TIMEOUT_MAX;
+    [[maybe_unused]] bool inserted = transactions.insert(txid, call, deadline);
+    assert(inserted);
 
+    auto request = call->getRequest();
+    assert(request != nullptr);
+    request->setTxid(txid);
     request->setAssociatedCall(call.get());
     sendMessage(request);
 }
 
+void RPCServer::onTimeout(RPCCall* call) {
+    stats.onTimeoutMessage(*call->getRequest());
+    call->getDHT().onTimeout(call);
+
+    // the caller may be the call itself, keep it alive until it returned
+    auto removed = transactions.remove(call->getRequest()->getTxid());
+    if (removed)
+        retired.push_back(std::move(removed));
+}
+
+void RPCServer::onCanceled(RPCCall* call) {
+    auto removed = transactions.remove(call->getRequest()->getTxid());
+    if (removed)
+        retired.push_back(std::move(removed));
+}
+
+void RPCServer::expireCalls(uint64_t now) {
+    while (auto call = transactions.popExpired(now)) {
+        auto state = call->getState();
+        if (state == RPCCall::State::SENT || state == RPCCall::State::STALLED) {
+            log->warn("Call {} to {} outlived its deadline", call->getRequest()->getTxid(),
+                    call->getRequest()->getRemoteAddress().toString());
+            call->failed();
+        }
+    }
+
+    retired.clear();
+}
+
 void RPCServer::sendMessage(Sp<Message> msg) {
     msg->setId(node.getId());
     auto short_name = Constants::NODE_SHORT_NAME;
@@ -458,17 +1114,32 @@ void RPCServer::sendError(Sp<Message> msg, int code, const std::string& err) {
 }
 
 void RPCServer::handlePacket(const uint8_t *buf, size_t buflen, const SocketAddress& from) {
+    auto msg = decodePacket(buf, buflen, from);
+    if (msg)
+        dispatchMessage(msg);
+}
+
+Sp<Message> RPCServer::decodePacket(const uint8_t *buf, size_t buflen, const SocketAddress& from) {
     Sp<Message> msg = nullptr;
-    std::vector<uint8_t> buffer;
+    // per decoding thread, the decoded message doesn't refer to the plain text
+    thread_local std::vector<uint8_t> buffer;
+
+    if (buflen <= ID_BYTES + CryptoBox::MAC_BYTES) {
+        stats.onDroppedPacket(buflen);
+        log->warn("Got a truncated packet from {}, ignored: len {}", from.toString(), buflen);
+        return nullptr;
+    }
 
     Id sender({buf, ID_BYTES});
 
     try {
-        buffer = node.decrypt(sender, {buf + ID_BYTES, buflen - ID_BYTES});
+        buffer.resize(buflen - ID_BYTES - CryptoBox::MAC_BYTES);
+        Blob plain {buffer};
+        node.decrypt(sender, plain, {buf + ID_BYTES, buflen - ID_BYTES});
     } catch(std::exception &e) {
         stats.onDroppedPacket(buflen);
         log->warn("Decrypt packet error from {}, ignored: len {}, {}", from.toString(), buflen, e.what());
-        return;
+        return nullptr;
     }
 
     try {
@@ -476,7 +1147,7 @@ void RPCServer::handlePacket(const uint8_t *buf, size_t buflen, const SocketAddr
     } catch(std::exception& e) {
         stats.onDroppedPacket(buflen);
         log->warn("Got a wrong packet from {}, ignored.", from.toString());
-        return;
+        return nullptr;
     }
 
     receivedMessages++;
@@ -486,8 +1157,12 @@ void RPCServer::handlePacket(const uint8_t *buf, size_t buflen, const SocketAddr
     msg->setOrigin(from);
 
     log->debug("Received {}/{} from {}: [{}] {}", msg->getMethodString(), msg->getTypeString(),
-            from.toString(), buflen, msg->toString());
+            from, buflen, *msg);
 
+    return msg;
+}
+
+void RPCServer::dispatchMessage(Sp<Message> msg) {
     // transaction id should be a non-zero integer
     if (msg->getType() != Message::Type::ERR && msg->getTxid() == 0) {
         log->warn("Received a message with invalid transaction id.");
@@ -503,16 +1178,17 @@ void RPCServer::handlePacket(const uint8_t *buf, size_t buflen, const SocketAddr
     }
 
     // check if this is a response to an outstanding request
-    auto it = calls.find(msg->getTxid());
-    if (it != calls.end()) {
-        Sp<RPCCall> call = it->second;
+    auto pending = transactions.find(msg->getTxid());
+    if (pending != nullptr) {
+        Sp<RPCCall> call = *pending;
         // message matches transaction ID and origin == destination
         // we only check the IP address here. the routing table applies more strict checks to also verify a stable port
         if (call->getRequest()->getRemoteAddress() == msg->getOrigin()) {
             // remove call first in case of exception
-            calls.erase(it);
+            transactions.remove(msg->getTxid());
             msg->setAssociatedCall(call.get());
             call->responsed(msg);
+            stats.onCallResponsed(call->getRTT());
 
             // processCallQueue();
             // apply after checking for a proper response
@@ -565,7 +1241,7 @@ void RPCServer::handlePacket(const uint8_t *buf, size_t buflen, const SocketAddr
         return;
     }
 
-    log->debug("Ignored message: {}", msg->toString());
+    log->debug("Ignored message: {}", *msg);
 }
 
 void RPCServer::handleMessage(Sp<Message> msg) {
@@ -576,14 +1252,20 @@ void RPCServer::handleMessage(Sp<Message> msg) {
 }
 
 void RPCServer::periodic() {
-    while(!messageQueue.empty()) {
-        auto msg = messageQueue.front();
-        messageQueue.pop();
-        sendData(msg);
-    }
-
     scheduler.syncTime();
     scheduler.run();
+
+    uint64_t now = currentTimeMillis();
+    expireCalls(now);
+
+    // slots freed by responses and timeouts, tokens refilled since the last round
+    processCallQueue();
+
+    if (now - lastDestinationSweep >= 1000)
+        sweepDestinations(now);
+
+    // responses to this round's packets and messages from the jobs just run
+    flushOutbound();
 }
 
 } // namespace boson
@@ -23,20 +23,28 @@
 
 #pragma once
 
+#include <array>
+#include <map>
 #include <list>
-#include <queue>
+#include <condition_variable>
 #include <random>
 #include <optional>
 
 #include "utils/log.h"
+#include "utils/bounded_queue.h"
+#include "utils/transaction_table.h"
 #include "messages/message.h"
 #include "rpccall.h"
 #include "scheduler.h"
 #include "rpcstatistics.h"
+#include "packet_buffer.h"
+#include "signature_verifier.h"
+#include "constants.h"
 
 namespace boson {
 
 class Node;
+struct DatagramBatch;
 
 class RPCServer {
 public:
@@ -52,6 +60,11 @@ public:
     void start();
     void stop();
 
+    // Run the job on the rx thread as soon as possible, thread-safe.
+    void post(std::function<void()>&& job);
+    // Interrupt the rx thread's wait for socket events, thread-safe.
+    void wakeup();
+
     void sendCall(Sp<RPCCall>& call);
     void dispatchCall(Sp<RPCCall>& call);
     void sendMessage(Sp<Message> msg);
@@ -78,7 +91,11 @@ public:
     }
 
     int getNumberOfActiveRPCCalls() {
-        return calls.size();
+        return transactions.size();
+    }
+
+    int getNumberOfQueuedRPCCalls() {
+        return queuedCalls;
     }
 
     SocketAddress& getAddress(sa_family_t af) {
@@ -87,15 +104,82 @@ public:
 
     void sendError(Sp<Message> msg, int code, const std::string& err);
 
+    // RPCCall notifications, the call is dropped from the transaction table
+    void onTimeout(RPCCall* call);
+    void onCanceled(RPCCall* call);
+
     RPCStatistics& getStatistics() {
         return stats;
     }
 
+    // completions of the signature checks run on the rx thread
+    SignatureVerifier& getVerifier() {
+        return verifier;
+    }
+
 private:
+    struct Datagram {
+        Sp<Message> message;
+        PacketBuffer packet;
+    };
+
+    // received packet waiting for a packet worker
+    struct RawPacket {
+        std::vector<uint8_t> data;
+        SocketAddress from;
+        uint64_t received {0};
+    };
+
+    // decoded message waiting for the rx thread
+    struct InboundMessage {
+        Sp<Message> message;
+        uint64_t enqueued {0};
+    };
+
+    // call waiting for an in-flight slot or for its destination's pacing
+    struct QueuedCall {
+        Sp<RPCCall> call;
+        uint64_t enqueued {0};
+    };
+
+    // token bucket of a remote node
+    struct DestinationBucket {
+        double tokens {0};
+        uint64_t updated {0};
+    };
+
     void bindSockets(const SocketAddress& bind4, const SocketAddress& bind6);
     void openSockets();
     int sendData(Sp<Message>& msg);
+    int receiveBatch(int sockfd, DatagramBatch& batch);
+    int receivePackets(int sockfd);
+    void receiveWorker(int sockfd);
+    void startReceiveWorkers();
+    void stopReceiveWorkers();
+    void decodeWorker();
+    void startDecodeWorkers();
+    void stopDecodeWorkers();
+    void enqueuePackets(DatagramBatch& received, int count);
+    bool enqueueMessage(Sp<Message>&& msg, size_t packetSize, uint64_t now);
+    void dispatchInbound();
+    void flushOutbound();
+    void flushOutbound(int sockfd, std::vector<Datagram>& queue);
     void handlePacket(const uint8_t *buf, size_t buflen, const SocketAddress& from);
+    // thread-safe: decrypt and parse a packet, nullptr if it was dropped
+    Sp<Message> decodePacket(const uint8_t *buf, size_t buflen, const SocketAddress& from);
+    // rx thread only: match responses to calls and hand the message to the DHT
+    void dispatchMessage(Sp<Message> msg);
+    int waitTimeout();
+    int waitForEvents(int ls4, int ls6, bool& readable4, bool& readable6);
+#ifdef HAVE_EPOLL
+    void watchSocket(int sockfd);
+#endif
+    bool acquireToken(const SocketAddress& dest, uint64_t now);
+    void sweepDestinations(uint64_t now);
+    bool hasAdmissibleCalls() const;
+    void processCallQueue();
+    void expireCalls(uint64_t now);
+    void runPosted();
     void periodic();
 
     Sp<Logger> log;
@@ -113,11 +197,46 @@ private:
     std::thread rcv_thread {};
     std::atomic_bool running {false};
 
-    std::list<Sp<RPCCall>> callQueue {};
-    std::map<int, Sp<RPCCall>> calls {};
+#ifdef HAVE_EPOLL
+    int epollFd {-1};
+    int wakeupFd {-1};
+#endif
+
+    std::vector<std::function<void()>> posted {};
+    std::mutex postLock {};
+
+    // SO_REUSEPORT receive workers, decoded messages are handed to the rx thread
+    int rxWorkers {0};
+    int stopFd {-1};
+    std::vector<std::thread> workers {};
+    std::vector<int> workerSockets {};
+    std::unique_ptr<BoundedQueue<InboundMessage>> inbound {};
+    // a wakeup for the inbound messages is on its way to the rx thread
+    std::atomic_bool inboundSignaled {false};
+
+    // packet workers: the decrypt/parse stage in front of the rx thread
+    int packetWorkers {0};
+    std::vector<std::thread> decoders {};
+    std::unique_ptr<BoundedQueue<RawPacket>> decodeQueue {};
+    std::mutex decodeLock {};
+    std::condition_variable decodeReady {};
+
+    // signature verification workers, the results are posted back to the rx thread
+    int verifyWorkers {0};
+    SignatureVerifier verifier {[this](std::function<void()>&& job) { post(std::move(job)); }};
+
+    // admission control: at most MAX_ACTIVE_CALLS in flight, queued by priority
+    std::array<std::list<QueuedCall>, 2> callQueue {};
+    size_t queuedCalls {0};
+    bool processingCalls {false};
+    std::map<SocketAddress, DestinationBucket> destinations {};
+    uint64_t lastDestinationSweep {0};
+    TransactionTable<Sp<RPCCall>> transactions {static_cast<size_t>(Constants::MAX_ACTIVE_CALLS)};
+    // calls removed while running their own handlers, released on the next round
+    std::vector<Sp<RPCCall>> retired {};
 
     State state {State::INITIAL};
-    volatile int nextTxid {0};
+    int nextTxid {0};
     volatile bool _isReachable {false};
     uint64_t messagesAtLastReachableCheck {0};
     uint64_t lastReachableCheck {0};
@@ -128,7 +247,15 @@ private:
 
     mutable std::mutex lock {};
 
-    std::queue<Sp<Message>> messageQueue {};
+    // encrypted datagrams waiting for the next (batched) flush, per address family
+    std::vector<Datagram> outbound4 {};
+    std::vector<Datagram> outbound6 {};
+    PacketBufferPool packetPool {
+        static_cast<size_t>(Constants::RPC_SERVER_IO_BATCH_SIZE) * 4,
+        static_cast<size_t>(Constants::RPC_SERVER_MAX_DATAGRAM_SIZE)
+    };
+    std::unique_ptr<DatagramBatch> batch;
+
     Scheduler scheduler {};
 };
 
@@ -22,7 +22,9 @@
  */
 
 #include <algorithm>
+#include <iomanip>
 #include "rpcstatistics.h"
+#include "verified_records.h"
 #include "utils/time.h"
 
 namespace boson {
@@ -105,6 +107,27 @@ void RPCStatistics::onTimeoutMessage(const Message& msg) noexcept {
     timeoutMessages[msg.getMethod().ordinal()]++;
 }
 
+double RPCStatistics::getAverageReceivedBatch() const noexcept {
+    auto batches = receivedBatches.load();
+    return batches == 0 ? 0.0 : static_cast<double>(receivedBatchDatagrams.load()) / batches;
+}
+
+double RPCStatistics::getAverageSentBatch() const noexcept {
+    auto batches = sentBatches.load();
+    return batches == 0 ? 0.0 : static_cast<double>(sentBatchDatagrams.load()) / batches;
+}
+
+uint64_t RPCStatistics::getStageAverageLatency(Stage stage) const noexcept {
+    const auto& s = stages[static_cast<int>(stage)];
+    auto processed = s.processed.load();
+    return processed == 0 ? 0 : s.totalLatency.load() / processed;
+}
+
+uint64_t RPCStatistics::getAverageCallQueueDelay() const noexcept {
+    auto dequeued = dequeuedCalls.load();
+    return dequeued == 0 ? 0 : totalCallQueueDelay.load() / dequeued;
+}
+
 std::string RPCStatistics::toString() const {
     std::stringstream ss;
     ss << "### local RPCs" << std::endl;
@@ -165,6 +188,37 @@ std::string RPCStatistics::toString() const {
         << ", dropped " << droppedPackets.load() << "/" << droppedBytes.load()
         << std::endl;
 
+    ss << std::endl << "### Batched I/O[batches/datagrams/avg/max]" << std::endl;
+    ss << "    received " << receivedBatches.load() << "/" << receivedBatchDatagrams.load()
+        << "/" << std::fixed << std::setprecision(2) << getAverageReceivedBatch() << "/" << maxReceivedBatch.load()
+        << ", sent " << sentBatches.load() << "/" << sentBatchDatagrams.load()
+        << "/" << getAverageSentBatch() << "/" << maxSentBatch.load()
+        << ", send queue dropped " << droppedOutbound.load() << "/" << droppedOutboundBytes.load()
+        << std::endl;
+
+    ss << std::endl << "### Pipeline[depth/max depth/avg latency us/max latency us]" << std::endl;
+    ss << "    decode " << getStageQueueDepth(Stage::DECODE) << "/" << getStageMaxQueueDepth(Stage::DECODE)
+        << "/" << getStageAverageLatency(Stage::DECODE) << "/" << getStageMaxLatency(Stage::DECODE)
+        << ", dispatch " << getStageQueueDepth(Stage::DISPATCH) << "/" << getStageMaxQueueDepth(Stage::DISPATCH)
+        << "/" << getStageAverageLatency(Stage::DISPATCH) << "/" << getStageMaxLatency(Stage::DISPATCH)
+        << std::endl;
+
+    ss << std::endl << "### Call admission[queued/depth/max depth/avg delay ms/max delay ms]" << std::endl;
+    ss << "    " << getQueuedCalls() << "/" << getCallQueueDepth() << "/" << getMaxCallQueueDepth()
+        << "/" << getAverageCallQueueDelay() << "/" << getMaxCallQueueDelay()
+        << std::endl;
+
+    ss << std::endl << "### Round-trip time[samples/p50/p90/p99 ms]" << std::endl;
+    ss << "    " << rttHistogram.count() << "/" << rttHistogram.percentile(0.5)
+        << "/" << rttHistogram.percentile(0.9) << "/" << rttHistogram.percentile(0.99)
+        << std::endl;
+
+    auto& verified = VerifiedRecords::global();
+    ss << std::endl << "### Verified records[hits/misses/hit rate]" << std::endl;
+    ss << "    " << verified.getHits() << "/" << verified.getMisses()
+        << "/" << std::setprecision(2) << verified.getHitRate()
+        << std::endl;
+
     return ss.str();
 }
 
@@ -23,14 +23,25 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <vector>
 #include "messages/message.h"
+#include "rtt_estimator.h"
 
 namespace boson {
 
 class RPCStatistics {
 public:
+    // Stages of the threaded packet pipeline, each one fed by a bounded queue
+    enum class Stage {
+        DECODE = 0,     // received -> decrypted and parsed by a worker
+        DISPATCH,       // decoded -> handed to the DHT on the rx thread
+        STAGE_TOTAL
+    };
+
     RPCStatistics() {};
 
     uint32_t getReceivedBytes() const noexcept{
@@ -80,9 +91,130 @@ public:
         droppedBytes.fetch_add(bytes);
     }
 
+    // outbound datagrams discarded because the send queue was full
+    void onDroppedOutbound(int bytes) noexcept {
+        droppedOutbound++;
+        droppedOutboundBytes.fetch_add(bytes);
+    }
+
+    uint32_t getDroppedOutbound() const noexcept {
+        return droppedOutbound.load();
+    }
+
+    uint32_t getDroppedOutboundBytes() const noexcept {
+        return droppedOutboundBytes.load();
+    }
+
+    // Batched datagram I/O, one call per recvmmsg/sendmmsg(or recvfrom/sendto) round
+    void onReceivedBatch(uint32_t datagrams) noexcept {
+        receivedBatches++;
+        receivedBatchDatagrams.fetch_add(datagrams);
+        updateMax(maxReceivedBatch, datagrams);
+    }
+
+    void onSentBatch(uint32_t datagrams) noexcept {
+        sentBatches++;
+        sentBatchDatagrams.fetch_add(datagrams);
+        updateMax(maxSentBatch, datagrams);
+    }
+
+    uint32_t getReceivedBatches() const noexcept {
+        return receivedBatches.load();
+    }
+
+    uint32_t getMaxReceivedBatch() const noexcept {
+        return maxReceivedBatch.load();
+    }
+
+    uint32_t getSentBatches() const noexcept {
+        return sentBatches.load();
+    }
+
+    uint32_t getMaxSentBatch() const noexcept {
+        return maxSentBatch.load();
+    }
+
+    double getAverageReceivedBatch() const noexcept;
+    double getAverageSentBatch() const noexcept;
+
+    void onStageEnqueued(Stage stage, size_t depth) noexcept {
+        auto& s = stages[static_cast<int>(stage)];
+        s.depth.store(static_cast<uint32_t>(depth));
+        updateMax(s.maxDepth, static_cast<uint32_t>(depth));
+    }
+
+    void onStageProcessed(Stage stage, size_t depth, uint64_t latencyMicros) noexcept {
+        auto& s = stages[static_cast<int>(stage)];
+        s.depth.store(static_cast<uint32_t>(depth));
+        s.processed++;
+        s.totalLatency.fetch_add(latencyMicros);
+        updateMax(s.maxLatency, static_cast<uint32_t>(std::min<uint64_t>(latencyMicros, UINT32_MAX)));
+    }
+
+    uint32_t getStageQueueDepth(Stage stage) const noexcept {
+        return stages[static_cast<int>(stage)].depth.load();
+    }
+
+    uint32_t getStageMaxQueueDepth(Stage stage) const noexcept {
+        return stages[static_cast<int>(stage)].maxDepth.load();
+    }
+
+    // in microseconds
+    uint64_t getStageAverageLatency(Stage stage) const noexcept;
+
+    uint32_t getStageMaxLatency(Stage stage) const noexcept {
+        return stages[static_cast<int>(stage)].maxLatency.load();
+    }
+
+    void onCallQueued(size_t depth) noexcept {
+        queuedCalls++;
+        callQueueDepth.store(static_cast<uint32_t>(depth));
+        updateMax(maxCallQueueDepth, static_cast<uint32_t>(depth));
+    }
+
+    void onCallDequeued(size_t depth, uint64_t delayMillis) noexcept {
+        dequeuedCalls++;
+        callQueueDepth.store(static_cast<uint32_t>(depth));
+        totalCallQueueDelay.fetch_add(delayMillis);
+        updateMax(maxCallQueueDelay, static_cast<uint32_t>(std::min<uint64_t>(delayMillis, UINT32_MAX)));
+    }
+
+    // calls that had to wait for an in-flight slot or their destination's pacing
+    uint32_t getQueuedCalls() const noexcept {
+        return queuedCalls.load();
+    }
+
+    uint32_t getCallQueueDepth() const noexcept {
+        return callQueueDepth.load();
+    }
+
+    uint32_t getMaxCallQueueDepth() const noexcept {
+        return maxCallQueueDepth.load();
+    }
+
+    // in milliseconds
+    uint64_t getAverageCallQueueDelay() const noexcept;
+
+    uint32_t getMaxCallQueueDelay() const noexcept {
+        return maxCallQueueDelay.load();
+    }
+
+    void onCallResponsed(uint32_t rtt) noexcept {
+        rttHistogram.record(rtt);
+    }
+
+    const RTTHistogram& getRTTHistogram() const noexcept {
+        return rttHistogram;
+    }
+
     std::string toString() const;
 
 private:
+    static void updateMax(std::atomic_uint32_t& max, uint32_t value) noexcept {
+        uint32_t current = max.load();
+        while (value > current && !max.compare_exchange_weak(current, value));
+    }
+
     std::atomic_uint32_t receivedBytes {0};
     std::atomic_uint32_t sentBytes {0};
 
@@ -101,6 +233,34 @@ private:
 
     std::atomic_uint32_t droppedPackets {0};
     std::atomic_uint32_t droppedBytes {0};
+    std::atomic_uint32_t droppedOutbound {0};
+    std::atomic_uint32_t droppedOutboundBytes {0};
+
+    std::atomic_uint32_t receivedBatches {0};
+    std::atomic_uint32_t receivedBatchDatagrams {0};
+    std::atomic_uint32_t maxReceivedBatch {0};
+    std::atomic_uint32_t sentBatches {0};
+    std::atomic_uint32_t sentBatchDatagrams {0};
+    std::atomic_uint32_t maxSentBatch {0};
+
+    struct StageStatistics {
+        std::atomic_uint32_t depth {0};
+        std::atomic_uint32_t maxDepth {0};
+        std::atomic_uint32_t processed {0};
+        std::atomic_uint64_t totalLatency {0};
+        std::atomic_uint32_t maxLatency {0};
+    };
+
+    std::array<StageStatistics, static_cast<int>(Stage::STAGE_TOTAL)> stages {};
+
+    std::atomic_uint32_t queuedCalls {0};
+    std::atomic_uint32_t dequeuedCalls {0};
+    std::atomic_uint32_t callQueueDepth {0};
+    std::atomic_uint32_t maxCallQueueDepth {0};
+    std::atomic_uint64_t totalCallQueueDelay {0};
+    std::atomic_uint32_t maxCallQueueDelay {0};
+
+    RTTHistogram rttHistogram {};
 };
 
 } // namespace boson
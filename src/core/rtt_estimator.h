@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "constants.h"
+
+namespace boson {
+
+/*
+ * Round-trip time estimator for a single remote node, see RFC 6298.
+ *
+ * The smoothed RTT and the RTT variance are kept scaled by 8 and 4, so the
+ * gains of 1/8 and 1/4 become shifts and integer milliseconds lose nothing.
+ */
+class RTTEstimator {
+public:
+    bool hasSamples() const noexcept {
+        return samples != 0;
+    }
+
+    uint32_t getSamples() const noexcept {
+        return samples;
+    }
+
+    // smoothed round-trip time in milliseconds
+    uint32_t getSRTT() const noexcept {
+        return srtt >> 3;
+    }
+
+    // round-trip time variance in milliseconds
+    uint32_t getRTTVar() const noexcept {
+        return rttvar >> 2;
+    }
+
+    // retransmission timeout in milliseconds, 0 without any sample
+    uint32_t getRTO() const noexcept {
+        return rto;
+    }
+
+    void sample(uint32_t rtt) noexcept {
+        if (samples == 0) {
+            // SRTT <- R, RTTVAR <- R/2
+            srtt = rtt << 3;
+            rttvar = rtt << 1;
+        } else {
+            // RTTVAR <- 3/4 * RTTVAR + 1/4 * |SRTT - R|, SRTT <- 7/8 * SRTT + 1/8 * R
+            int32_t delta = static_cast<int32_t>(rtt) - static_cast<int32_t>(srtt >> 3);
+            srtt = static_cast<uint32_t>(static_cast<int32_t>(srtt) + delta);
+            if (delta < 0)
+                delta = -delta;
+            rttvar = static_cast<uint32_t>(static_cast<int32_t>(rttvar) + delta - static_cast<int32_t>(rttvar >> 2));
+        }
+
+        if (samples < UINT32_MAX)
+            samples++;
+
+        // RTO <- SRTT + max(G, 4 * RTTVAR), the clock granularity G is 1ms
+        rto = clamp((srtt >> 3) + std::max<uint32_t>(1, rttvar));
+    }
+
+    // Double the timeout after a lost request, until the next sample arrives
+    void backoff() noexcept {
+        if (samples != 0)
+            rto = clamp(rto * 2);
+    }
+
+private:
+    static uint32_t clamp(uint32_t value) noexcept {
+        return std::clamp<uint32_t>(value, Constants::RPC_CALL_TIMEOUT_BASELINE_MIN,
+                Constants::RPC_CALL_TIMEOUT_MAX);
+    }
+
+    uint32_t srtt {0};      // scaled by 8
+    uint32_t rttvar {0};    // scaled by 4
+    uint32_t rto {0};
+    uint32_t samples {0};
+};
+
+/*
+ * Log-linear histogram of the round-trip times to all nodes: four buckets per
+ * power of two, so a percentile is never off by more than 25%.
+ *
+ * Only the DHT thread records samples, readers may see a slightly stale view.
+ * The counts are halved once the window is full so the distribution follows
+ * the current network conditions.
+ */
+class RTTHistogram {
+public:
+    static constexpr int BUCKETS = 64;
+    static constexpr uint32_t WINDOW = 4096;
+
+    void record(uint32_t rtt) noexcept {
+        buckets[bucketOf(rtt)].fetch_add(1, std::memory_order_relaxed);
+
+        if (total.fetch_add(1, std::memory_order_relaxed) + 1 >= WINDOW) {
+            uint32_t sum = 0;
+            for (auto& bucket : buckets) {
+                auto halved = bucket.load(std::memory_order_relaxed) >> 1;
+                bucket.store(halved, std::memory_order_relaxed);
+                sum += halved;
+            }
+            total.store(sum, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t count() const noexcept {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    // Upper bound of the bucket that holds the given quantile, 0 when empty
+    uint32_t percentile(double quantile) const noexcept {
+        uint32_t n = count();
+        if (n == 0)
+            return 0;
+
+        uint32_t rank = static_cast<uint32_t>(quantile * n);
+        rank = std::clamp<uint32_t>(rank, 1, n);
+
+        uint32_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return upperBoundOf(i);
+        }
+
+        return upperBoundOf(BUCKETS - 1);
+    }
+
+    static int bucketOf(uint32_t rtt) noexcept {
+        if (rtt < 4)
+            return rtt;
+
+        int octave = 2;
+        while ((rtt >> (octave + 1)) != 0)
+            octave++;
+
+        int index = (octave - 1) * 4 + ((rtt >> (octave - 2)) & 3);
+        return std::min(index, BUCKETS - 1);
+    }
+
+    static uint32_t upperBoundOf(int index) noexcept {
+        if (index < 4)
+            return index;
+
+        int octave = index / 4 + 1;
+        uint32_t lower = static_cast<uint32_t>(4 + index % 4) << (octave - 2);
+        return lower + (1u << (octave - 2)) - 1;
+    }
+
+private:
+    std::array<std::atomic_uint32_t, BUCKETS> buckets {};
+    std::atomic_uint32_t total {0};
+};
+
+} // namespace boson
@@ -24,31 +24,78 @@
 #pragma once
 
 #include <functional>
-#include <map>
 #include <chrono>
 #include <cstdint>
+#include <limits>
+#include <memory>
 
 #include "utils/time.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace boson {
 
 #undef max
 
 using clock = std::chrono::steady_clock;
 
+/*
+ * Hierarchical timing wheel with 1ms ticks, in the style of the classic BSD/Linux
+ * kernel timers: the first wheel has a slot per tick for the next 256ms, each of
+ * the four outer wheels covers 64 times the span of the inner one. Jobs in an
+ * outer slot are cascaded to the inner wheels when the time reaches their slot.
+ *
+ * Jobs are linked into their slot intrusively, so scheduling, rescheduling and
+ * canceling are O(1) and the only allocation is the Job itself, which recurring
+ * jobs reuse. While a job is scheduled the wheel holds a reference to it.
+ *
+ * Not thread-safe: the jobs are added and run on the rx thread.
+ */
 class Scheduler {
+private:
+    struct Link {
+        Link* prev {this};
+        Link* next {this};
+
+        bool linked() const {
+            return next != this;
+        }
+
+        void unlink() {
+            prev->next = next;
+            next->prev = prev;
+            prev = next = this;
+        }
+
+        void append(Link* node) {
+            node->prev = prev;
+            node->next = this;
+            prev->next = node;
+            prev = node;
+        }
+    };
+
 public:
-    class Job {
+    class Job : private Link {
     public:
         Job(std::function<void()>&& f) : do_(std::move(f)) {}
 
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
         void setFixedDelay(long _fixedDelay) {
             fixedDelay = _fixedDelay;
         }
 
         void cancel() {
+            if (owner != nullptr)
+                owner->unlink(this);
+
             do_ = {};
             fixedDelay = 0;
+            canceled = true;
         }
 
         explicit operator bool() const {
@@ -62,9 +109,34 @@ public:
     private:
         std::function<void()> do_;
         long fixedDelay = 0;
+        bool canceled = false;
+
+        uint64_t expires {0};
+        Scheduler* owner {nullptr};     // set while scheduled
+        Sp<Job> self {};                // keeps the job alive while scheduled
+        uint8_t level {0};
+        uint8_t slot {0};
         friend class Scheduler;
     };
 
+    Scheduler() = default;
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    ~Scheduler() {
+        for (int level = 0; level < LEVELS; level++) {
+            for (int slot = 0; slot < slots(level); slot++) {
+                Link& head = wheel(level, slot);
+                while (head.linked()) {
+                    auto job = static_cast<Job*>(head.next);
+                    job->unlink();
+                    job->owner = nullptr;
+                    job->self.reset();
+                }
+            }
+        }
+    }
+
     Sp<Scheduler::Job> add(std::function<void()>&& job_func, long delay, long fixedDelay = 0) {
         auto job = std::make_shared<Job>(std::move(job_func));
         add(job, delay, fixedDelay);
@@ -72,49 +144,143 @@ public:
     }
 
     void add(const Sp<Scheduler::Job>& job, long delay, long fixedDelay = 0) {
+        // already scheduled, linking it again would corrupt its slot
+        if (job->owner != nullptr)
+            job->owner->unlink(job.get());
+
         job->setFixedDelay(fixedDelay);
-        uint64_t time = currentTimeMillis() + delay;
-        if (time != std::numeric_limits<uint64_t>::max())
-            timers.emplace(time, job);
+        job->canceled = false;
+        schedule(job, currentTimeMillis() + std::max<long>(delay, 0));
     }
 
+    // Reschedule the job in place, it keeps its function
     void edit(Sp<Scheduler::Job>& job, long delay, long fixedDelay = 0) {
         if (not job) {
             return;
         }
-        // std::function move doesn't garantee to leave the object empty.
-        // Force clearing old value.
-        auto task = std::move(job->do_);
-        job->cancel();
-        job = add(std::move(task), delay, fixedDelay);
+
+        if (job->owner != nullptr)
+            job->owner->unlink(job.get());
+
+        job->setFixedDelay(fixedDelay);
+        job->canceled = false;
+        schedule(job, currentTimeMillis() + std::max<long>(delay, 0));
     }
 
     uint64_t run() {
-        while (not timers.empty()) {
-            auto timer = timers.begin();
-            /*
-             * Running jobs scheduled before "now" prevents run+rescheduling
-             * loops before this method ends. It is garanteed by the fact that a
-             * job will at least be scheduled for "now" and not before.
-             */
-            if (timer->first > now)
-                break;
+        /*
+         * Running jobs scheduled before "now" prevents run+rescheduling
+         * loops before this method ends. It is garanteed by the fact that a
+         * job will at least be scheduled for the next tick and not before.
+         */
+        while (base <= now) {
+            int index = base & ROOT_MASK;
+            if (index == 0 && cascadedAt != base)
+                cascade();
 
-            auto job = std::move(timer->second);
-            if (*job)
-                (*job)();
+            // skip the empty slots, up to the end of the round or now
+            int next = nextSlot(bitmap0, ROOT_SLOTS / 64, index);
+            uint64_t roundEnd = (base | ROOT_MASK) + 1;
+            uint64_t tick = next < 0 ? roundEnd : base + (next - index);
+            if (tick > now) {
+                base = std::min<uint64_t>(roundEnd, now + 1);
+                break;
+            }
 
-            if (job->fixedDelay > 0) {
-                edit(job, job->fixedDelay, job->fixedDelay);
+            if (tick == roundEnd) {
+                base = tick;
+                continue;
             }
 
-            timers.erase(timer);
+            // detach the slot so jobs added while running go to the next ticks
+            Link due;
+            Link& head = wheel(0, next);
+            due.next = head.next;
+            due.prev = head.prev;
+            due.next->prev = &due;
+            due.prev->next = &due;
+            head.prev = head.next = &head;
+            clearBit(bitmap0, next);
+
+            base = tick + 1;
+
+            while (due.linked()) {
+                auto job = static_cast<Job*>(due.next);
+                Sp<Job> ref = std::move(job->self);
+                job->unlink();
+                job->owner = nullptr;
+                count--;
+
+                // the job may cancel itself, keep its function alive while it runs
+                auto func = std::move(job->do_);
+                job->do_ = {};
+                if (func)
+                    func();
+
+                if (job->canceled)
+                    continue;
+
+                job->do_ = std::move(func);
+                if (job->fixedDelay > 0 && job->owner == nullptr)
+                    schedule(ref, currentTimeMillis() + job->fixedDelay);
+            }
         }
+
         return getNextJobTime();
     }
 
+    /*
+     * The time of the next job, or a lower bound for it when the next job still
+     * sits in an outer wheel: the time its slot is cascaded.
+     */
     inline uint64_t getNextJobTime() const {
-        return timers.empty() ? std::numeric_limits<uint64_t>::max() : timers.begin()->first;
+        if (count == 0)
+            return std::numeric_limits<uint64_t>::max();
+
+        // the outer slots of this round still have to be cascaded
+        int index = base & ROOT_MASK;
+        if (index == 0 && cascadedAt != base)
+            return base;
+
+        int next = nextSlot(bitmap0, ROOT_SLOTS / 64, index);
+        if (next >= 0)
+            return base + (next - index);
+
+        // first slot of the next round, or the earliest cascade of an outer wheel
+        uint64_t earliest = std::numeric_limits<uint64_t>::max();
+        if (bitmap0[0] | bitmap0[1] | bitmap0[2] | bitmap0[3])
+            earliest = (base | ROOT_MASK) + 1;
+
+        for (int level = 1; level < LEVELS; level++) {
+            int shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+            int current = (base >> shift) & LEVEL_MASK;
+            int next = nextSlot(&bitmaps[level - 1], 1, current);
+            if (next < 0)
+                next = nextSlot(&bitmaps[level - 1], 1, 0);
+            if (next < 0)
+                continue;
+
+            // the current slot was cascaded already, anything in it is a full turn ahead
+            uint64_t offset = (next - current) & LEVEL_MASK;
+            if (offset == 0)
+                offset = LEVEL_SLOTS;
+            uint64_t time = ((base >> shift) + offset) << shift;
+            earliest = std::min(earliest, std::max(time, base));
+        }
+
+        return earliest;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    /*
+     * Called when a job is added ahead of all the pending jobs, so an event
+     * loop sleeping until getNextJobTime() can re-arm its wait.
+     */
+    void setWakeupHandler(std::function<void()>&& handler) {
+        wakeupHandler = std::move(handler);
     }
 
     inline const uint64_t& time() const { return now; }
@@ -122,8 +288,151 @@ public:
     inline void syncTime(const uint64_t& n) { now = n; }
 
 private:
+    static constexpr int ROOT_BITS = 8;
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int ROOT_SLOTS = 1 << ROOT_BITS;
+    static constexpr int LEVEL_SLOTS = 1 << LEVEL_BITS;
+    static constexpr uint64_t ROOT_MASK = ROOT_SLOTS - 1;
+    static constexpr uint64_t LEVEL_MASK = LEVEL_SLOTS - 1;
+    static constexpr int LEVELS = 5;
+    static constexpr uint64_t MAX_SPAN = (1ull << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS)) - 1;
+
+    static int slots(int level) {
+        return level == 0 ? ROOT_SLOTS : LEVEL_SLOTS;
+    }
+
+    Link& wheel(int level, int slot) {
+        return level == 0 ? root[slot] : outer[level - 1][slot];
+    }
+
+    static int lowestBit(uint64_t word) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(word);
+#endif
+    }
+
+    // First set bit at or after the position, -1 if none up to the end of the bitmap
+    static int nextSlot(const uint64_t* bitmap, int words, int from) {
+        int word = from / 64;
+        if (word >= words)
+            return -1;
+
+        uint64_t bits = bitmap[word] & (~0ull << (from % 64));
+        while (true) {
+            if (bits != 0)
+                return word * 64 + lowestBit(bits);
+            if (++word >= words)
+                return -1;
+            bits = bitmap[word];
+        }
+    }
+
+    static void setBit(uint64_t* bitmap, int bit) {
+        bitmap[bit / 64] |= 1ull << (bit % 64);
+    }
+
+    static void clearBit(uint64_t* bitmap, int bit) {
+        bitmap[bit / 64] &= ~(1ull << (bit % 64));
+    }
+
+    void schedule(const Sp<Job>& job, uint64_t time) {
+        bool earliest = time < getNextJobTime();
+
+        job->expires = time;
+        job->owner = this;
+        job->self = job;
+        place(job.get());
+        count++;
+
+        if (earliest && wakeupHandler)
+            wakeupHandler();
+    }
+
+    void place(Job* job) {
+        // overdue jobs run on the next tick
+        uint64_t expires = std::max(job->expires, base);
+        uint64_t delta = std::min(expires - base, MAX_SPAN);
+        expires = base + delta;
+
+        int level = 0;
+        int slot = expires & ROOT_MASK;
+        if (delta >= ROOT_SLOTS) {
+            level = 1;
+            while (level < LEVELS - 1 && delta >= (1ull << (ROOT_BITS + level * LEVEL_BITS)))
+                level++;
+            slot = (expires >> (ROOT_BITS + (level - 1) * LEVEL_BITS)) & LEVEL_MASK;
+        }
+
+        job->level = static_cast<uint8_t>(level);
+        job->slot = static_cast<uint8_t>(slot);
+        wheel(level, slot).append(job);
+        if (level == 0)
+            setBit(bitmap0, slot);
+        else
+            setBit(&bitmaps[level - 1], slot);
+    }
+
+    void unlink(Job* job) {
+        job->unlink();
+        Link& head = wheel(job->level, job->slot);
+        if (!head.linked()) {
+            if (job->level == 0)
+                clearBit(bitmap0, job->slot);
+            else
+                clearBit(&bitmaps[job->level - 1], job->slot);
+        }
+
+        job->owner = nullptr;
+        count--;
+        // last: this may release the job
+        job->self.reset();
+    }
+
+    // Move the jobs of the outer slots reached by the new round to the inner wheels
+    void cascade() {
+        cascadedAt = base;
+
+        for (int level = 1; level < LEVELS; level++) {
+            int slot = (base >> (ROOT_BITS + (level - 1) * LEVEL_BITS)) & LEVEL_MASK;
+
+            Link& head = wheel(level, slot);
+            Link jobs;
+            if (head.linked()) {
+                jobs.next = head.next;
+                jobs.prev = head.prev;
+                jobs.next->prev = &jobs;
+                jobs.prev->next = &jobs;
+                head.prev = head.next = &head;
+            }
+            clearBit(&bitmaps[level - 1], slot);
+
+            while (jobs.linked()) {
+                auto job = static_cast<Job*>(jobs.next);
+                job->unlink();
+                place(job);
+            }
+
+            // the outer wheel only moves on when this one wrapped around
+            if (slot != 0)
+                break;
+        }
+    }
+
     uint64_t now {currentTimeMillis()};
-    std::multimap<uint64_t, Sp<Job>> timers {}; /* the jobs ordered by time */
+    uint64_t base {now};                            // next tick to run
+    uint64_t cascadedAt {std::numeric_limits<uint64_t>::max()};
+    size_t count {0};
+
+    Link root[ROOT_SLOTS] {};
+    Link outer[LEVELS - 1][LEVEL_SLOTS] {};
+    uint64_t bitmap0[ROOT_SLOTS / 64] {};
+    uint64_t bitmaps[LEVELS - 1] {};
+
+    std::function<void()> wakeupHandler {};
 };
 
 } // namespace boson
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <utility>
+
+#include "constants.h"
+#include "signature_verifier.h"
+
+namespace boson {
+
+void SignatureVerifier::start(int count) {
+    if (count <= 0 || running)
+        return;
+
+    queue = std::make_unique<BoundedQueue<Job>>(Constants::SIGNATURE_VERIFY_QUEUE_CAPACITY);
+    running = true;
+    for (int i = 0; i < count; i++)
+        workers.emplace_back(&SignatureVerifier::worker, this);
+}
+
+void SignatureVerifier::stop() {
+    if (!running.exchange(false))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(lock);
+    }
+    ready.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+    // the completions of the dropped jobs never run, as the executor stopped as well
+    queue.reset();
+}
+
+void SignatureVerifier::verify(const Value& value, Completion&& done) {
+    // nothing to verify for the immutable values, don't pay a round trip
+    if (!value.isMutable()) {
+        done(value.isValid());
+        return;
+    }
+
+    submit([value]() { return value.isValid(); }, std::move(done));
+}
+
+void SignatureVerifier::verify(const std::vector<PeerInfo>& peers, Completion&& done) {
+    if (peers.empty()) {
+        done(true);
+        return;
+    }
+
+    submit([peers]() {
+        for (const auto& peer : peers) {
+            if (!peer.isValid())
+                return false;
+        }
+        return true;
+    }, std::move(done));
+}
+
+void SignatureVerifier::submit(std::function<bool()>&& check, Completion&& done) {
+    if (running) {
+        Job job { std::move(check), std::move(done) };
+        if (queue->push(std::move(job))) {
+            // pairs with the predicate check in worker(), no lost wakeups
+            {
+                std::lock_guard<std::mutex> lk(lock);
+            }
+            ready.notify_one();
+            return;
+        }
+
+        // the workers can't keep up, push back on the rx thread instead
+        check = std::move(job.check);
+        done = std::move(job.done);
+    }
+
+    done(check());
+}
+
+void SignatureVerifier::worker() {
+    std::vector<Job> batch;
+    batch.reserve(Constants::SIGNATURE_VERIFY_BATCH_SIZE);
+
+    while (running) {
+        Job job;
+        while (batch.size() < (size_t)Constants::SIGNATURE_VERIFY_BATCH_SIZE && queue->pop(job))
+            batch.emplace_back(std::move(job));
+
+        if (batch.empty()) {
+            std::unique_lock<std::mutex> lk(lock);
+            ready.wait(lk, [this]() {
+                return !running || !queue->empty();
+            });
+            continue;
+        }
+
+        auto results = std::make_shared<std::vector<std::pair<Completion, bool>>>();
+        results->reserve(batch.size());
+        for (auto& job : batch) {
+            bool valid = false;
+            try {
+                valid = job.check();
+            } catch (...) {
+                valid = false;
+            }
+            results->emplace_back(std::move(job.done), valid);
+        }
+        batch.clear();
+
+        executor([results]() {
+            for (auto& [done, valid] : *results)
+                done(valid);
+        });
+    }
+}
+
+} // namespace boson
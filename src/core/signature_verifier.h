@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "boson/value.h"
+#include "boson/peer_info.h"
+#include "utils/bounded_queue.h"
+
+namespace boson {
+
+/*
+ * Verifies the signatures of the values and peers received from the network
+ * on a pool of worker threads, off the rx thread.
+ *
+ * Each worker drains the queue in batches of up to VERIFY_BATCH_SIZE records
+ * and hands the whole batch of results back through a single executor job,
+ * so the completions run on the rx thread with one wakeup per batch. Without
+ * workers, or when the queue is full, the record is verified inline and the
+ * completion runs before verify() returns.
+ */
+class SignatureVerifier {
+public:
+    using Executor = std::function<void(std::function<void()>&&)>;
+    using Completion = std::function<void(bool)>;
+
+    explicit SignatureVerifier(Executor _executor) : executor(std::move(_executor)) {}
+    ~SignatureVerifier() {
+        stop();
+    }
+
+    SignatureVerifier(const SignatureVerifier&) = delete;
+    SignatureVerifier& operator=(const SignatureVerifier&) = delete;
+
+    void start(int workers);
+    void stop();
+
+    bool isAsync() const {
+        return running;
+    }
+
+    // The value is valid, mutable values are checked against their signature
+    void verify(const Value& value, Completion&& done);
+    // All the peers carry a valid signature
+    void verify(const std::vector<PeerInfo>& peers, Completion&& done);
+
+    size_t getPending() const {
+        return queue ? queue->size() : 0;
+    }
+
+private:
+    struct Job {
+        std::function<bool()> check;
+        Completion done;
+    };
+
+    void submit(std::function<bool()>&& check, Completion&& done);
+    void worker();
+
+    Executor executor;
+    std::unique_ptr<BoundedQueue<Job>> queue {};
+    std::vector<std::thread> workers {};
+    std::mutex lock {};
+    std::condition_variable ready {};
+    std::atomic_bool running {false};
+};
+
+} // namespace boson
@@ -21,6 +21,9 @@
  * SOFTWARE.
  */
 
+#include <chrono>
+#include <sstream>
+
 #include "boson/id.h"
 #include "boson/peer_info.h"
 #include "crypto/hex.h"
@@ -33,6 +36,7 @@ namespace boson {
 static int VERSION = 4;
 static std::string SET_USER_VERSION = "PRAGMA user_version = " + std::to_string(VERSION);
 static std::string GET_USER_VERSION = "PRAGMA user_version";
+static std::string GET_JOURNAL_MODE = "PRAGMA journal_mode";
 
 static std::string CREATE_VALUES_TABLE = "CREATE TABLE IF NOT EXISTS valores(\
         id BLOB NOT NULL PRIMARY KEY, \
@@ -51,6 +55,10 @@ static std::string CREATE_VALUES_TABLE = "CREATE TABLE IF NOT EXISTS valores(\
 static std::string CREATE_VALUES_INDEX =
     "CREATE INDEX IF NOT EXISTS idx_valores_timpstamp ON valores(timestamp)";
 
+// Partial: only the rows expire() may delete, so a sweep seeks straight to them
+static std::string CREATE_VALUES_EXPIRE_INDEX =
+    "CREATE INDEX IF NOT EXISTS idx_valores_expire ON valores(timestamp) WHERE persistent != TRUE";
+
 static std::string CREATE_PEERS_TABLE = "CREATE TABLE IF NOT EXISTS peers( \
         id BLOB NOT NULL, \
         nodeId BLOB NOT NULL, \
@@ -72,6 +80,9 @@ static std::string CREATE_PEERS_INDEX =
 static std::string CREATE_PEERS_ID_INDEX =
     "CREATE INDEX IF NOT EXISTS idx_peers_id ON peers(id)";
 
+static std::string CREATE_PEERS_EXPIRE_INDEX =
+    "CREATE INDEX IF NOT EXISTS idx_peers_expire ON peers(timestamp) WHERE persistent != TRUE";
+
 static std::string UPSERT_VALUE = "INSERT INTO valores(\
         id, persistent, publicKey, privateKey, recipient, nonce, signature, sequenceNumber, data, timestamp, announced) \
         VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) ON CONFLICT(id) DO UPDATE SET \
@@ -116,37 +127,97 @@ static std::string GET_PERSISTENT_PEERS = "SELECT * FROM peers WHERE persistent
 
 static std::string REMOVE_PEER = "DELETE FROM peers WHERE id = ? and origin = ?";
 
+// DELETE ... LIMIT needs a non-default SQLite build, bound the chunk in a subquery instead
+static std::string EXPIRE_VALUES = "DELETE FROM valores WHERE id IN \
+        (SELECT id FROM valores WHERE persistent != TRUE and timestamp < ? LIMIT ?)";
+
+static std::string EXPIRE_PEERS = "DELETE FROM peers WHERE (id, nodeId, origin) IN \
+        (SELECT id, nodeId, origin FROM peers WHERE persistent != TRUE and timestamp < ? LIMIT ?)";
+
 SqliteStorage::~SqliteStorage() {
-    if (sqlite_store) {
-        sqlite3_close(sqlite_store);
-        sqlite_store = NULL;
-    }
+    close();
+}
+
+void SqliteStorage::expire(uint64_t now) {
+    // the previous sweep is still behind, it will catch up with these rows next time
+    if (expiring.exchange(true))
+        return;
+
+    expireBefore[0] = now - Constants::MAX_VALUE_AGE;
+    expireBefore[1] = now - Constants::MAX_PEER_AGE;
+    sweep = {};
+    expireChunk();
 }
 
-void SqliteStorage::expire() {
-    const char *sqls[2] = { "DELETE FROM valores WHERE persistent != TRUE and timestamp < ?",  "DELETE FROM peers WHERE persistent != TRUE and timestamp < ?"};
-    uint64_t ts[2];
-    ts[0] = currentTimeMillis() - Constants::MAX_VALUE_AGE;
-    ts[1] = currentTimeMillis() - Constants::MAX_PEER_AGE;
+void SqliteStorage::expireChunk() {
+    const std::string* sqls[2] = { &EXPIRE_VALUES, &EXPIRE_PEERS };
+    uint64_t* deleted[2] = { &sweep.values, &sweep.peers };
+    bool more = false;
 
-    for (int i = 0; i < 2; i++) {
-        sqlite3_stmt *pStmt;
-        if (sqlite3_prepare_v2(sqlite_store, sqls[i], strlen(sqls[i]), &pStmt, 0) != SQLITE_OK) {
-            sqlite3_finalize(pStmt);
-            throw std::runtime_error("Prepare sqlite failed.");
+    {
+        std::lock_guard<std::recursive_mutex> lk(lock);
+        if (!sqlite_store) {
+            expiring = false;
+            return;
         }
 
-        sqlite3_bind_int64(pStmt, 1, ts[i]);
-        sqlite3_step(pStmt);
-        sqlite3_finalize(pStmt);
+        auto started = std::chrono::steady_clock::now();
+        for (int i = 0; i < 2; i++) {
+            if (expireBefore[i] == 0)
+                continue;
+
+            auto pStmt = prepare(*sqls[i]);
+            sqlite3_bind_int64(pStmt, 1, expireBefore[i]);
+            sqlite3_bind_int(pStmt, 2, Constants::STORAGE_EXPIRE_CHUNK_SIZE);
+
+            int changes = sqlite3_step(pStmt) == SQLITE_DONE ? sqlite3_changes(sqlite_store) : 0;
+            *deleted[i] += changes;
+            // a short chunk means the table is done
+            if (changes < Constants::STORAGE_EXPIRE_CHUNK_SIZE)
+                expireBefore[i] = 0;
+            else
+                more = true;
+        }
+
+        sweep.time += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count();
+        sweep.chunks++;
+
+        if (!more)
+            lastExpire = sweep;
+    }
+
+    if (more) {
+        chunkJob = scheduler->add([=]() {
+            expireChunk();
+        }, Constants::STORAGE_EXPIRE_CHUNK_INTERVAL);
+        return;
     }
+
+    expiring = false;
+    log->log(sweep.values + sweep.peers > 0 ? Level::Info : Level::Debug,
+            "Expired {} values and {} peers in {} chunks, {}us", sweep.values, sweep.peers, sweep.chunks, sweep.time);
 }
 
-void SqliteStorage::init(const std::string& path, Scheduler& scheduler) {
+void SqliteStorage::init(const std::string& path, Scheduler& scheduler, const Options& options) {
+    log = Logger::get("Storage");
+    this->scheduler = &scheduler;
+
     int rc = sqlite3_open(path.c_str(), &sqlite_store);
     if (rc)
         throw std::runtime_error("Failed to open the SQLite storage.");
 
+    // With synchronous NORMAL a WAL commit only appends to the log, the fsync
+    // is left to checkpoints.
+    std::string tuning = "PRAGMA mmap_size = " + std::to_string(options.mmapSize) + ";";
+    if (options.cacheSize != 0)
+        tuning += "PRAGMA cache_size = " + std::to_string(options.cacheSize) + ";";
+    std::string pragmas = "PRAGMA journal_mode = " + options.journalMode + ";" +
+            "PRAGMA synchronous = " + options.synchronous + ";" + tuning;
+
+    if (sqlite3_exec(sqlite_store, pragmas.c_str(), 0, 0, 0) != 0)
+        throw std::runtime_error("Failed to configure the SQLite storage.");
+
     // if we change the schema,
     // we should check the user version, do the schema update,
     // then increase the user_version;
@@ -165,51 +236,159 @@ void SqliteStorage::init(const std::string& path, Scheduler& scheduler) {
     if (sqlite3_exec(sqlite_store, SET_USER_VERSION.c_str(), 0, 0, 0) != 0 ||
         sqlite3_exec(sqlite_store, CREATE_VALUES_TABLE.c_str(), 0, 0, 0) != 0 ||
         sqlite3_exec(sqlite_store, CREATE_VALUES_INDEX.c_str(), 0, 0, 0) != 0 ||
+        sqlite3_exec(sqlite_store, CREATE_VALUES_EXPIRE_INDEX.c_str(), 0, 0, 0) != 0 ||
         sqlite3_exec(sqlite_store, CREATE_PEERS_TABLE.c_str(), 0, 0, 0) != 0 ||
         sqlite3_exec(sqlite_store, CREATE_PEERS_INDEX.c_str(), 0, 0, 0) != 0 ||
-        sqlite3_exec(sqlite_store, CREATE_PEERS_ID_INDEX.c_str(), 0, 0, 0) != 0) {
+        sqlite3_exec(sqlite_store, CREATE_PEERS_ID_INDEX.c_str(), 0, 0, 0) != 0 ||
+        sqlite3_exec(sqlite_store, CREATE_PEERS_EXPIRE_INDEX.c_str(), 0, 0, 0) != 0) {
         throw std::runtime_error("Failed to update SQLite text.");
     }
 
-    scheduler.add([=]() {
-        expire();
+    // With WAL a reader sees the last commit without waiting for the writer, so
+    // the reads get their own connection and don't queue behind transaction().
+    // Other journal modes (and in-memory databases) keep them on the writer's.
+    if (getJournalMode() == "wal") {
+        if (sqlite3_open_v2(path.c_str(), &sqlite_reader, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK ||
+                sqlite3_exec(sqlite_reader, tuning.c_str(), 0, 0, 0) != 0) {
+            sqlite3_close(sqlite_reader);
+            sqlite_reader = nullptr;
+            throw std::runtime_error("Failed to open the SQLite reader connection.");
+        }
+        sqlite3_busy_timeout(sqlite_reader, Constants::STORAGE_READ_BUSY_TIMEOUT);
+        separateReader = true;
+    }
+
+    expireJob = scheduler.add([=]() {
+        expire(currentTimeMillis());
     }, 0, Constants::STORAGE_EXPIRE_INTERVAL);
 }
 
 Sp<DataStorage> SqliteStorage::open(const std::string& path, Scheduler& scheduler) {
+    return open(path, scheduler, Options {});
+}
+
+Sp<DataStorage> SqliteStorage::open(const std::string& path, Scheduler& scheduler, const Options& options) {
     Sp<SqliteStorage> storage = std::make_shared<SqliteStorage>();
-    storage->init(path, scheduler);
+    storage->init(path, scheduler, options);
     return std::static_pointer_cast<DataStorage>(storage);
 }
 
 void SqliteStorage::close() {
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    std::lock_guard<std::recursive_mutex> rlk(readLock);
+    // the scheduler outlives the storage, don't leave it jobs pointing here
+    if (expireJob) {
+        expireJob->cancel();
+        expireJob.reset();
+    }
+    if (chunkJob) {
+        chunkJob->cancel();
+        chunkJob.reset();
+    }
+
+    if (sqlite_reader) {
+        finalizeStatements(readStatements);
+        sqlite3_close(sqlite_reader);
+        sqlite_reader = NULL;
+    }
+
     if (sqlite_store) {
+        finalizeStatements(statements);
         sqlite3_close(sqlite_store);
         sqlite_store = NULL;
     }
 }
 
-int SqliteStorage::getUserVersion() {
-    int userVersion = 0;
+void SqliteStorage::transaction(const std::function<void()>& writes) {
+    // Held until the end, a statement from another thread in between would
+    // otherwise join the transaction and share its fate
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    if (!sqlite_store || sqlite3_exec(sqlite_store, "BEGIN", 0, 0, 0) != 0)
+        throw std::runtime_error("Begin sqlite transaction failed.");
+
+    try {
+        writes();
+    } catch (...) {
+        sqlite3_exec(sqlite_store, "ROLLBACK", 0, 0, 0);
+        throw;
+    }
+
+    if (sqlite3_exec(sqlite_store, "COMMIT", 0, 0, 0) != 0) {
+        sqlite3_exec(sqlite_store, "ROLLBACK", 0, 0, 0);
+        throw std::runtime_error("Commit sqlite transaction failed.");
+    }
+}
+
+std::string SqliteStorage::toString() const {
+    auto stats = getLastExpire();
+    std::stringstream ss;
+    ss << "### storage expiry" << std::endl;
+    ss << "last sweep: " << stats.values << " values, " << stats.peers << " peers, "
+        << stats.chunks << " chunks, " << stats.time << " us" << std::endl;
+    return ss.str();
+}
+
+SqliteStorage::Statement SqliteStorage::prepare(sqlite3* db, Statements& cache, const std::string& sql) {
+    auto it = cache.find(&sql);
+    if (it != cache.end())
+        return Statement(it->second);
+
     sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, GET_USER_VERSION.c_str(), strlen(GET_USER_VERSION.c_str()), &pStmt, 0) != SQLITE_OK) {
+    if (sqlite3_prepare_v3(db, sql.c_str(), sql.size(), SQLITE_PREPARE_PERSISTENT, &pStmt, 0) != SQLITE_OK) {
         sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
+        throw std::runtime_error("Prepare sqlite failed.");
     }
 
+    cache.emplace(&sql, pStmt);
+    return Statement(pStmt);
+}
+
+SqliteStorage::Statement SqliteStorage::prepare(const std::string& sql) {
+    return prepare(sqlite_store, statements, sql);
+}
+
+SqliteStorage::Statement SqliteStorage::prepareRead(const std::string& sql) {
+    return separateReader ? prepare(sqlite_reader, readStatements, sql) : prepare(sqlite_store, statements, sql);
+}
+
+void SqliteStorage::finalizeStatements(Statements& cache) {
+    for (const auto& [sql, pStmt] : cache)
+        sqlite3_finalize(pStmt);
+    cache.clear();
+}
+
+std::string SqliteStorage::getJournalMode() {
+    std::string mode {};
+    auto pStmt = prepare(GET_JOURNAL_MODE);
+
+    if (sqlite3_step(pStmt) == SQLITE_ROW) {
+        auto c = (const char*)sqlite3_column_text(pStmt, 0);
+        mode = c ? c : "";
+    }
+    return mode;
+}
+
+int SqliteStorage::getUserVersion() {
+    int userVersion = 0;
+    auto pStmt = prepare(GET_USER_VERSION);
+
     if (sqlite3_step(pStmt) == SQLITE_ROW)
         userVersion = sqlite3_column_int(pStmt, 0);
-
-    sqlite3_finalize(pStmt);
     return userVersion;
 }
 
 Sp<Value> SqliteStorage::getValue(const Id& valueId) {
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, SELECT_VALUE.c_str(), strlen(SELECT_VALUE.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
+    return _getValue(prepareRead(SELECT_VALUE), valueId);
+}
+
+Sp<Value> SqliteStorage::loadValue(const Id& valueId, uint64_t& expiration) {
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
+    expiration = 0;
+    return _getValue(prepareRead(SELECT_VALUE), valueId, &expiration);
+}
+
+Sp<Value> SqliteStorage::_getValue(const Statement& pStmt, const Id& valueId, uint64_t* expiration) {
 
     const uint64_t when = currentTimeMillis() - Constants::MAX_VALUE_AGE;
     sqlite3_bind_blob(pStmt, 1, valueId.data(), valueId.size(), SQLITE_STATIC);
@@ -250,41 +429,30 @@ Sp<Value> SqliteStorage::getValue(const Id& valueId) {
                 sequenceNumber = sqlite3_column_int(pStmt, i);
             } else if (strcmp(name, "data") == 0 && len > 0) {
                 data = Blob(ptr, len);
+            } else if (strcmp(name, "timestamp") == 0 && expiration) {
+                *expiration = sqlite3_column_int64(pStmt, i) + Constants::MAX_VALUE_AGE;
             }
         }
 
         auto value = Value::of(publicKey, privateKey, recipient, nonce, sequenceNumber, signature, data);
-        sqlite3_finalize(pStmt);
         return std::make_shared<Value>(value);
     }
 
-    sqlite3_finalize(pStmt);
     return nullptr;
 }
 
 Sp<Value> SqliteStorage::putValue(const Value& value, int expectedSeq, bool persistent, bool updateLastAnnounce) {
-    sqlite3_stmt *pStmt;
-
+    // normally a cache hit, the DHT and the node verified it before storing
     if (value.isMutable() && !value.isValid())
         throw std::invalid_argument("Value signature validation failed");
 
+    std::lock_guard<std::recursive_mutex> lk(lock);
     auto id = value.getId();
-    auto old = getValue(id);
-    if (old != nullptr && old->isMutable()) {
-        if(!value.isMutable())
-            throw std::invalid_argument("Can not replace mutable value with immutable is not supported");
-        if (old->hasPrivateKey() && !value.hasPrivateKey())
-            throw std::invalid_argument("Not the owner of value");
-        if(value.getSequenceNumber() < old->getSequenceNumber())
-            throw std::invalid_argument("Sequence number less than current");
-        if(expectedSeq >= 0 && old->getSequenceNumber() >= 0 && old->getSequenceNumber() != expectedSeq)
-            throw std::invalid_argument("CAS failure");
-    }
+    // on the writer's connection, it has to see the open transaction
+    auto old = _getValue(prepare(SELECT_VALUE), id);
+    checkReplace(old, value, expectedSeq);
 
-    if (sqlite3_prepare_v2(sqlite_store, UPSERT_VALUE.c_str(), strlen(UPSERT_VALUE.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    auto pStmt = prepare(UPSERT_VALUE);
 
     sqlite3_bind_blob(pStmt, 1, id.data(), id.size(), SQLITE_STATIC);
     sqlite3_bind_int(pStmt, 2, persistent);
@@ -334,18 +502,14 @@ Sp<Value> SqliteStorage::putValue(const Value& value, int expectedSeq, bool pers
     sqlite3_bind_int64(pStmt, 11, updateLastAnnounce ? now : 0);
 
     sqlite3_step(pStmt);
-    sqlite3_finalize(pStmt);
     return old;
 }
 
 std::vector<Id> SqliteStorage::getAllValues() {
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
     std::vector<Id> ids {};
 
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, GET_VALUES.c_str(), strlen(GET_VALUES.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    auto pStmt = prepareRead(GET_VALUES);
 
     const uint64_t when = currentTimeMillis() - Constants::MAX_VALUE_AGE;
     sqlite3_bind_int64(pStmt, 1, when);
@@ -366,16 +530,12 @@ std::vector<Id> SqliteStorage::getAllValues() {
         }
     }
 
-    sqlite3_finalize(pStmt);
     return ids;
 }
 
 void SqliteStorage::updateValueLastAnnounce(const Id& valueId) {
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, UPDATE_VALUE_LAST_ANNOUNCE.c_str(), strlen(UPDATE_VALUE_LAST_ANNOUNCE.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    auto pStmt = prepare(UPDATE_VALUE_LAST_ANNOUNCE);
 
     auto now = currentTimeMillis();
     sqlite3_bind_int64(pStmt, 1, now);
@@ -383,16 +543,12 @@ void SqliteStorage::updateValueLastAnnounce(const Id& valueId) {
     sqlite3_bind_blob(pStmt, 3, valueId.data(), valueId.size(), SQLITE_STATIC);
 
     sqlite3_step(pStmt);
-    sqlite3_finalize(pStmt);
 }
 
 std::vector<Value> SqliteStorage::getPersistentValues(uint64_t lastAnnounceBefore) {
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
     std::vector<Value> values {};
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, GET_PERSISTENT_VALUES.c_str(), strlen(GET_PERSISTENT_VALUES.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    auto pStmt = prepareRead(GET_PERSISTENT_VALUES);
 
     sqlite3_bind_int64(pStmt, 1, lastAnnounceBefore);
 
@@ -438,16 +594,12 @@ std::vector<Value> SqliteStorage::getPersistentValues(uint64_t lastAnnounceBefor
         values.emplace_back(value);
     }
 
-    sqlite3_finalize(pStmt);
     return values;
 }
 
 bool SqliteStorage::removeValue(const Id& valueId) {
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, REMOVE_VALUE.c_str(), strlen(REMOVE_VALUE.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    auto pStmt = prepare(REMOVE_VALUE);
 
     sqlite3_bind_blob(pStmt, 1, valueId.data(), valueId.size(), SQLITE_STATIC);
 
@@ -457,20 +609,26 @@ bool SqliteStorage::removeValue(const Id& valueId) {
             ret = true;
     }
 
-    sqlite3_finalize(pStmt);
     return ret;
 }
 
 std::vector<PeerInfo> SqliteStorage::getPeer(const Id& peerId, int maxPeers) {
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
+    return _getPeer(peerId, maxPeers);
+}
+
+std::vector<PeerInfo> SqliteStorage::loadPeers(const Id& peerId, int maxPeers, uint64_t& expiration) {
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
+    expiration = 0;
+    return _getPeer(peerId, maxPeers, &expiration);
+}
+
+std::vector<PeerInfo> SqliteStorage::_getPeer(const Id& peerId, int maxPeers, uint64_t* expiration) {
     if (maxPeers <=0)
         maxPeers = 0x7fffffff;
 
     std::vector<PeerInfo> peers {};
-    sqlite3_stmt *pStmt;
-    if(sqlite3_prepare_v2(sqlite_store, SELECT_PEER.c_str(), strlen(SELECT_PEER.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");
-    }
+    auto pStmt = prepareRead(SELECT_PEER);
 
     uint64_t when = currentTimeMillis() - Constants::MAX_PEER_AGE;
     sqlite3_bind_blob(pStmt, 1, peerId.data(), peerId.size(), SQLITE_STATIC);
@@ -510,23 +668,23 @@ std::vector<PeerInfo> SqliteStorage::getPeer(const Id& peerId, int maxPeers) {
                 alt = c ? c : "";
             } else if (std::strcmp(name, "signature") == 0) {
                 signature = Blob(ptr, len);
+            } else if (std::strcmp(name, "timestamp") == 0 && expiration) {
+                uint64_t expires = sqlite3_column_int64(pStmt, i) + Constants::MAX_PEER_AGE;
+                if (*expiration == 0 || expires < *expiration)
+                    *expiration = expires;
             }
         }
 
         auto peer = PeerInfo::of(peerId.blob(), privateKey, nodeId, origin, port, alt, signature);
         peers.emplace_back(peer);
     }
-    sqlite3_finalize(pStmt);
 
     return peers;
 }
 
 Sp<PeerInfo> SqliteStorage::getPeer(const Id& peerId, const Id& origin) {
-    sqlite3_stmt *pStmt {nullptr};
-    if(sqlite3_prepare_v2(sqlite_store, SELECT_PEER_WITH_SRC.c_str(), strlen(SELECT_PEER_WITH_SRC.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");
-    }
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
+    auto pStmt = prepareRead(SELECT_PEER_WITH_SRC);
 
     const uint64_t when = currentTimeMillis() - Constants::MAX_PEER_AGE;
     sqlite3_bind_blob(pStmt, 1, peerId.data(), peerId.size(), SQLITE_STATIC);
@@ -570,23 +728,20 @@ Sp<PeerInfo> SqliteStorage::getPeer(const Id& peerId, const Id& origin) {
         }
 
         auto peer = PeerInfo::of(peerId.blob(), privateKey, nodeId, origin, port, alt, signature);
-        sqlite3_finalize(pStmt);
         return std::make_shared<PeerInfo>(peer);
     }
 
-    sqlite3_finalize(pStmt);
     return nullptr;
 }
 
 void SqliteStorage::putPeer(const std::vector<PeerInfo>& peers) {
-    if (sqlite3_exec(sqlite_store, "BEGIN", 0, 0, 0) != 0)
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    // Inside transaction() the peers simply join the open transaction
+    const bool autocommit = sqlite3_get_autocommit(sqlite_store);
+    if (autocommit && sqlite3_exec(sqlite_store, "BEGIN", 0, 0, 0) != 0)
         throw std::runtime_error("Open auto commit mode failed.");
 
-    sqlite3_stmt *pStmt {nullptr};
-    if(sqlite3_prepare_v2(sqlite_store, UPSERT_PEER.c_str(), strlen(UPSERT_PEER.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");
-    }
+    auto pStmt = prepare(UPSERT_PEER);
 
     uint64_t now = currentTimeMillis();
     for (const auto& peer : peers) {
@@ -610,23 +765,21 @@ void SqliteStorage::putPeer(const std::vector<PeerInfo>& peers) {
         sqlite3_bind_int64(pStmt, 10, 0);
 
         if (sqlite3_step(pStmt) != SQLITE_DONE) {
-            sqlite3_finalize(pStmt);
+            if (autocommit)
+                sqlite3_exec(sqlite_store, "ROLLBACK", 0, 0, 0);
             throw std::runtime_error("Step sqlite failed.");
         }
 
         sqlite3_reset(pStmt);
     }
 
-    sqlite3_finalize(pStmt);
-    sqlite3_exec(sqlite_store, "COMMIT", 0, 0, 0);
+    if (autocommit)
+        sqlite3_exec(sqlite_store, "COMMIT", 0, 0, 0);
 }
 
 void SqliteStorage::putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) {
-    sqlite3_stmt *pStmt {nullptr};
-    if(sqlite3_prepare_v2(sqlite_store, UPSERT_PEER.c_str(), strlen(UPSERT_PEER.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");
-    }
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    auto pStmt = prepare(UPSERT_PEER);
 
     sqlite3_bind_blob(pStmt, 1, peer.getId().data(), peer.getId().size(), SQLITE_STATIC);
     sqlite3_bind_blob(pStmt, 2, peer.getNodeId().data(), peer.getNodeId().size(), SQLITE_STATIC);
@@ -649,17 +802,13 @@ void SqliteStorage::putPeer(const PeerInfo& peer, bool persistent, bool updateLa
     sqlite3_bind_int64(pStmt, 10, updateLastAnnounce ? now : 0);
 
     sqlite3_step(pStmt);
-    sqlite3_finalize(pStmt);
 }
 
 std::vector<Id> SqliteStorage::getAllPeers() {
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
     std::vector<Id> ids {};
 
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, GET_PEERS.c_str(), strlen(GET_PEERS.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    auto pStmt = prepareRead(GET_PEERS);
 
     uint64_t when = currentTimeMillis() - Constants::MAX_PEER_AGE;
     sqlite3_bind_int64(pStmt, 1, when);
@@ -680,16 +829,12 @@ std::vector<Id> SqliteStorage::getAllPeers() {
         }
     }
 
-    sqlite3_finalize(pStmt);
     return ids;
 }
 
 void SqliteStorage::updatePeerLastAnnounce(const Id& peerId, const Id& origin) {
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, UPDATE_PEER_LAST_ANNOUNCE.c_str(), strlen(UPDATE_PEER_LAST_ANNOUNCE.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    auto pStmt = prepare(UPDATE_PEER_LAST_ANNOUNCE);
 
     auto now = currentTimeMillis();
     sqlite3_bind_int64(pStmt, 1, now);
@@ -698,16 +843,12 @@ void SqliteStorage::updatePeerLastAnnounce(const Id& peerId, const Id& origin) {
     sqlite3_bind_blob(pStmt, 4, origin.data(), origin.size(), SQLITE_STATIC);
 
     sqlite3_step(pStmt);
-    sqlite3_finalize(pStmt);
 }
 
 std::vector<PeerInfo> SqliteStorage::getPersistentPeers(uint64_t lastAnnounceBefore) {
+    std::lock_guard<std::recursive_mutex> lk(readerLock());
     std::vector<PeerInfo> peers {};
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, GET_PERSISTENT_PEERS.c_str(), strlen(GET_PERSISTENT_PEERS.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    auto pStmt = prepareRead(GET_PERSISTENT_PEERS);
 
     sqlite3_bind_int64(pStmt, 1, lastAnnounceBefore);
 
@@ -738,6 +879,8 @@ std::vector<PeerInfo> SqliteStorage::getPersistentPeers(uint64_t lastAnnounceBef
                 privateKey = Blob(ptr, len);
             } else if (std::strcmp(name, "nodeId") == 0 && len > 0) {
                 nodeId = Blob(ptr, len);
+            } else if (std::strcmp(name, "origin") == 0 && len > 0) {
+                origin = Blob(ptr, len);
             } else if (std::strcmp(name, "port") == 0) {
                 port = sqlite3_column_int(pStmt, i);
             } else if (std::strcmp(name, "alternativeURL") == 0) {
@@ -752,16 +895,12 @@ std::vector<PeerInfo> SqliteStorage::getPersistentPeers(uint64_t lastAnnounceBef
         peers.emplace_back(peer);
     }
 
-    sqlite3_finalize(pStmt);
     return peers;
 }
 
 bool SqliteStorage::removePeer(const Id& peerId, const Id& origin) {
-    sqlite3_stmt* pStmt {nullptr};
-    if (sqlite3_prepare_v2(sqlite_store, REMOVE_PEER.c_str(), strlen(REMOVE_PEER.c_str()), &pStmt, 0) != SQLITE_OK) {
-        sqlite3_finalize(pStmt);
-        throw std::runtime_error("Prepare sqlite failed.");;
-    }
+    std::lock_guard<std::recursive_mutex> lk(lock);
+    auto pStmt = prepare(REMOVE_PEER);
 
     sqlite3_bind_blob(pStmt, 1, peerId.data(), peerId.size(), SQLITE_STATIC);
     sqlite3_bind_blob(pStmt, 2, origin.data(), origin.size(), SQLITE_STATIC);
@@ -772,7 +911,6 @@ bool SqliteStorage::removePeer(const Id& peerId, const Id& origin) {
             ret = true;
     }
 
-    sqlite3_finalize(pStmt);
     return ret;
 }
 
@@ -23,7 +23,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
+#include <mutex>
+#include <unordered_map>
 #include <sqlite3.h>
 
 #include "boson/types.h"
@@ -31,15 +34,31 @@
 #include "boson/value.h"
 #include "data_storage.h"
 #include "scheduler.h"
+#include "utils/log.h"
 
 namespace boson {
 
 class SqliteStorage final : public DataStorage {
 public:
+    struct Options {
+        std::string journalMode {"WAL"};
+        std::string synchronous {"NORMAL"};
+        int64_t mmapSize {0};   // bytes, 0 disables memory-mapped I/O
+        int cacheSize {0};      // pages if positive, KiB if negative, 0 keeps the SQLite default
+    };
+
+    struct ExpireStats {
+        uint64_t values {0};    // rows deleted
+        uint64_t peers {0};
+        uint64_t time {0};      // microseconds spent deleting, the pauses between the chunks excluded
+        int chunks {0};
+    };
+
     SqliteStorage() {}
     ~SqliteStorage();
 
     static Sp<DataStorage> open(const std::string& path, Scheduler& scheduler);
+    static Sp<DataStorage> open(const std::string& path, Scheduler& scheduler, const Options& options);
     void close() override;
 
     Sp<Value> getValue(const Id& valueId) override;
@@ -58,12 +77,89 @@ public:
     std::vector<PeerInfo> getPersistentPeers(uint64_t lastAnnounceBefore) override;
     std::vector<Id> getAllPeers() override;
 
+    Sp<Value> loadValue(const Id& valueId, uint64_t& expiration) override;
+    std::vector<PeerInfo> loadPeers(const Id& peerId, int maxPeers, uint64_t& expiration) override;
+
+    void transaction(const std::function<void()>& writes) override;
+
+    // Starts a sweep of the records expired at now. The rows are deleted in
+    // chunks of STORAGE_EXPIRE_CHUNK_SIZE, one chunk per scheduler run every
+    // STORAGE_EXPIRE_CHUNK_INTERVAL, so the rx thread is never held for long.
+    void expire(uint64_t now);
+
+    bool isExpiring() const {
+        return expiring;
+    }
+
+    ExpireStats getLastExpire() const {
+        std::lock_guard<std::recursive_mutex> lk(lock);
+        return lastExpire;
+    }
+
+    std::string toString() const override;
+
 private:
-    void init(const std::string& path, Scheduler& scheduler);
-    void expire();
+    // A cached prepared statement, reset for the next use when it goes out of scope
+    class Statement {
+    public:
+        Statement(sqlite3_stmt* _stmt) noexcept : stmt(_stmt) {}
+        Statement(const Statement&) = delete;
+        ~Statement() {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        operator sqlite3_stmt*() const noexcept {
+            return stmt;
+        }
+
+    private:
+        sqlite3_stmt* stmt;
+    };
+
+    using Statements = std::unordered_map<const std::string*, sqlite3_stmt*>;
+
+    void init(const std::string& path, Scheduler& scheduler, const Options& options);
+    void expireChunk();
     int getUserVersion();
+    std::string getJournalMode();
+    // Require the lock of the statement's connection, the expiration is only
+    // filled in when asked for
+    Sp<Value> _getValue(const Statement& pStmt, const Id& valueId, uint64_t* expiration = nullptr);
+    std::vector<PeerInfo> _getPeer(const Id& peerId, int maxPeers, uint64_t* expiration = nullptr);
+
+    static Statement prepare(sqlite3* db, Statements& cache, const std::string& sql);
+    // On the writer's connection, requires lock
+    Statement prepare(const std::string& sql);
+    // On the reader's connection if there is one, requires readerLock()
+    Statement prepareRead(const std::string& sql);
+    static void finalizeStatements(Statements& cache);
+
+    // Guards the reads: readLock with a reader connection, lock otherwise
+    std::recursive_mutex& readerLock() const {
+        return separateReader ? readLock : lock;
+    }
 
     sqlite3* sqlite_store {nullptr};
+    Statements statements {};
+    // recursive: transaction() keeps it while the writes it runs take it again
+    mutable std::recursive_mutex lock {};
+
+    // read-only, only opened in WAL mode
+    sqlite3* sqlite_reader {nullptr};
+    Statements readStatements {};
+    // recursive only to share readerLock() with lock
+    mutable std::recursive_mutex readLock {};
+    bool separateReader {false};
+
+    Scheduler* scheduler {nullptr};
+    Sp<Scheduler::Job> expireJob {};
+    Sp<Scheduler::Job> chunkJob {};
+    std::atomic_bool expiring {false};
+    uint64_t expireBefore[2] {0, 0};    // values, peers
+    ExpireStats sweep {};
+    ExpireStats lastExpire {};
+    Sp<Logger> log;
 };
 
 } // namespace boson
@@ -34,6 +34,7 @@ public:
     CandidateNode(const NodeInfo& ni): NodeInfo(ni) {
         if (const auto entry = dynamic_cast<const KBucketEntry*>(&ni)) {
             reachable = entry->isReachable();
+            rtt = entry->getRTTEstimator();
         }
     }
 
@@ -54,6 +55,14 @@ public:
         this->lastReply = currentTimeMillis();
     }
 
+    const RTTEstimator& getRTTEstimator() const {
+        return rtt;
+    }
+
+    void signalRTT(uint32_t sample) {
+        rtt.sample(sample);
+    }
+
     void setToken(int token) {
         this->token = token;
     }
@@ -88,6 +97,8 @@ private:
     int  pinged {0};
 
     int token {0};
+
+    RTTEstimator rtt {};    /* seeded from the routing table entry */
 };
 
 } // namespace boson
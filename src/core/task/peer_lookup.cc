@@ -70,14 +70,14 @@ void PeerLookup::callResponsed(RPCCall* call, Sp<Message> message) {
     auto response = std::static_pointer_cast<FindPeerResponse>(message);
     if (response->hasPeers()) {
         auto peers = response->getPeers();
-        for (const auto& peer: peers) {
-            if (!peer.isValid()) {
+        verify(peers, [this, peers](bool valid) mutable {
+            if (!valid) {
                 log->error("Response include invalid peer, signature mismatch");
                 return; // Ignore
             }
-        }
 
-        resultHandler(peers, this);
+            resultHandler(peers, this);
+        });
 
     }
     else {
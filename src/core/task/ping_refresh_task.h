@@ -46,6 +46,7 @@ public:
         checkAll = vector_contains(options, Options::checkAll);
         removeOnTimeout = vector_contains(options, Options::removeOnTimeout);
         probeCache = vector_contains(options, Options::probeCache);
+        setPriority(RPCCall::Priority::MAINTENANCE);
 
         addBucket(bucket);
     }
@@ -25,6 +25,7 @@
 
 #include "utils/time.h"
 #include "utils/list.h"
+#include "utils/log_formatters.h"
 #include "task/peer_lookup.h"
 #include "task/peer_announce.h"
 #include "task/value_announce.h"
@@ -32,6 +33,7 @@
 #include "task/candidate_node.h"
 
 #include "messages/message.h"
+#include "rpcserver.h"
 #include "dht.h"
 
 namespace boson {
@@ -116,6 +118,16 @@ void Task::clearInFlight() {
     inFlight.clear();
 }
 
+bool Task::canDoRequest() const {
+    // counted from the calls themselves, a separate counter could drift and underflow
+    size_t active = 0;
+    for (const auto& [key, call] : inFlight) {
+        if (call->getState() != RPCCall::State::STALLED)
+            active++;
+    }
+    return active < Constants::MAX_CONCURRENT_TASK_REQUESTS;
+}
+
 // TODO: CHECK ME!!!
 void Task::serializedUpdate() {
     int current = ++lock;
@@ -124,7 +136,8 @@ void Task::serializedUpdate() {
     if(current > 1)
         return;
 
-    log->trace("Task update: {}", toString());
+    if (log->shouldLog(Level::Trace))
+        log->trace("Task update: {}", toString());
     do {
         if(isDone())
             finish();
@@ -158,7 +171,8 @@ bool Task::sendCall(Sp<NodeInfo> node, Sp<Message> request, std::function<void(S
     };
 
     auto call = std::make_shared<RPCCall>(dht, node, request);
-    call->addStateChangeHandler([&](RPCCall* c, RPCCall::State previous, RPCCall::State current) {
+    call->setPriority(priority);
+    call->addStateChangeHandler([this, removeCall](RPCCall* c, RPCCall::State previous, RPCCall::State current) {
         switch (current) {
         case RPCCall::State::SENT:
             callSent(c);
@@ -194,12 +208,42 @@ bool Task::sendCall(Sp<NodeInfo> node, Sp<Message> request, std::function<void(S
     modifyCallBeforeSubmit(call);
     inFlight[call->hash()] = call;
 
-    log->debug("Task#{} sending call to {}", getTaskId(), node->toString(), request->getRemoteAddress().toString());
+    log->debug("Task#{} sending call to {}", getTaskId(), *node);
     // asyncify since we're under a lock here
     dht.getServer().sendCall(call);
     return true;
 }
 
+void Task::verify(const Value& value, std::function<void(bool)>&& done) {
+    pendingVerifications++;
+    verifying = true;
+    dht.getServer().getVerifier().verify(value, verified(std::move(done)));
+    verifying = false;
+}
+
+void Task::verify(const std::vector<PeerInfo>& peers, std::function<void(bool)>&& done) {
+    pendingVerifications++;
+    verifying = true;
+    dht.getServer().getVerifier().verify(peers, verified(std::move(done)));
+    verifying = false;
+}
+
+std::function<void(bool)> Task::verified(std::function<void(bool)>&& done) {
+    return [self = weak_from_this(), done = std::move(done)](bool valid) {
+        auto task = self.lock();
+        if (!task)
+            return;
+
+        task->pendingVerifications--;
+        if (!task->isFinished())
+            done(valid);
+
+        // completed inline: the caller is already inside an update round
+        if (!task->verifying)
+            task->serializedUpdate();
+    };
+}
+
 std::string Task::toString() const {
     std::stringstream ss;
     ss.str().reserve(1024);
@@ -24,7 +24,10 @@
 #pragma once
 
 #include <list>
+#include <memory>
 
+#include "boson/value.h"
+#include "boson/peer_info.h"
 #include "utils/time.h"
 
 #include "constants.h"
@@ -38,7 +41,7 @@ class Task;
 
 using TaskListener = std::function<void (Task *)>;
 
-class Task {
+class Task : public std::enable_shared_from_this<Task> {
 friend class CallListener;
 public:
     enum class State {
@@ -91,6 +94,15 @@ public:
         return dht;
     }
 
+    // priority of the calls sent by this task
+    void setPriority(RPCCall::Priority priority) {
+        this->priority = priority;
+    }
+
+    RPCCall::Priority getPriority() const {
+        return priority;
+    }
+
     void addListener(TaskListener listener);
     void removeListener(TaskListener listener);
 
@@ -123,12 +135,16 @@ public:
     std::string toString() const;
 
 protected:
-    bool canDoRequest() const {
-        return inFlight.size() < Constants::MAX_CONCURRENT_TASK_REQUESTS;
-    }
+    // stalled calls stay in flight until they time out, but no longer hold a slot
+    bool canDoRequest() const;
 
     bool sendCall(Sp<NodeInfo> node, Sp<Message> request, std::function<void(Sp<RPCCall>&)> modifyCallBeforeSubmit);
 
+    // Verify the signatures off the rx thread. The task doesn't finish while a
+    // verification is pending; the completion is skipped if it finished anyway.
+    void verify(const Value& value, std::function<void(bool)>&& done);
+    void verify(const std::vector<PeerInfo>& peers, std::function<void(bool)>&& done);
+
     virtual void callSent(RPCCall* call) {}
     virtual void callResponsed(RPCCall* call, Sp<Message> response) {}
     virtual void callError(RPCCall* call) {}
@@ -138,7 +154,7 @@ protected:
     virtual void update() {}
 
     virtual bool isDone() const {
-        return inFlight.empty() || isFinished();
+        return (inFlight.empty() && pendingVerifications == 0) || isFinished();
     }
 
     virtual std::string className() const {
@@ -157,18 +173,22 @@ private:
     void finish();
     void notifyCompletionListeners();
     void clearInFlight();
+    std::function<void(bool)> verified(std::function<void(bool)>&& done);
 
     friend class TaskManager;
 
     int taskId {};
     std::string name {};
     State state { State::INITIAL };
+    RPCCall::Priority priority { RPCCall::Priority::USER };
     std::shared_ptr<Task> nested {};
 
     uint64_t startTime {};
     uint64_t finishTime {};
 
     std::map<std::size_t, Sp<RPCCall>> inFlight {};
+    size_t pendingVerifications {0};
+    bool verifying {false};
     std::list<TaskListener> listeners {};
 
     int lock {0};
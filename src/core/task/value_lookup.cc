@@ -78,18 +78,20 @@ void ValueLookup::callResponsed(RPCCall* call, Sp<Message> message) {
             log->warn("Responsed value id {} mismatched with expected {}", id.toString(), getTarget().toString());
             return;
         }
-        if (!value.isValid()) {
-            log->warn("Responsed value {} is invalid, signature mismatch", id.toString());
-            return;
-        }
-
         if (expectedSequence >= 0 && value.getSequenceNumber() < expectedSequence) {
             log->warn("Responsed value {} is outdated, sequence {}, expected {}",
                     id.toString(), value.getSequenceNumber(), expectedSequence);
             return;
         }
 
-        resultHandler(value, this);
+        verify(value, [this, value](bool valid) {
+            if (!valid) {
+                log->warn("Responsed value {} is invalid, signature mismatch", value.getId().toString());
+                return;
+            }
+
+            resultHandler(value, this);
+        });
     }
     else {
         auto nodes = response->getNodes(getDHT().getType());
@@ -21,6 +21,8 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 
 #include "boson/socket_address.h"
@@ -44,6 +46,23 @@ TokenManager::TokenManager() {
     auto a = reinterpret_cast<uint32_t*>(sessionSecret.data());
     auto b = reinterpret_cast<uint32_t*>(sessionSecret.data()+ sessionSecret.size());
     std::generate(a, b, generator);
+
+    currentKey = deriveKey(0);
+    previousKey = currentKey;
+}
+
+SipHash::Key TokenManager::deriveKey(uint64_t timestamp) const {
+    const uint64_t stamp = htonll(timestamp);
+
+    // sessionSecret + timestamp
+    auto sha256 = SHA256();
+    sha256.update(sessionSecret);
+    sha256.update({(const uint8_t*)&stamp, sizeof(uint64_t)});
+    auto digest = sha256.digest();
+
+    SipHash::Key key;
+    std::memcpy(key.data(), digest.data(), key.size());
+    return key;
 }
 
 void TokenManager::updateTokenTimestamps() {
@@ -51,48 +70,45 @@ void TokenManager::updateTokenTimestamps() {
     uint64_t now = currentTimeMillis();
     while (now - current > TOKEN_TIMEOUT) {
         if (timestamp.compare_exchange_weak(current, now)) {
-            previousTimestamp = current;
+            previousKey = currentKey;
+            currentKey = deriveKey(now);
             break;
         }
         current = timestamp.load();
     }
 }
 
-int TokenManager::generateToken(const Id& nodeId, const SocketAddress& addr, const Id& targetId, long timestamp, std::array<uint8_t, 32>& sessionSecret) {
+int TokenManager::generateToken(const Id& nodeId, const SocketAddress& addr, const Id& targetId, const SipHash::Key& key) {
     const uint16_t port = htons(addr.port());
-    const uint64_t stamp = htonll(timestamp);
-
-    // nodeId + ip + port + targetId + timestamp + sessionSecret
-    auto sha256 = SHA256();
-    sha256.update(nodeId.blob());
-    sha256.update({addr.inaddr(), addr.inaddrLength()});
-    sha256.update({(const uint8_t*)&port, sizeof(uint16_t)});
-    sha256.update(targetId.blob());
-    sha256.update({(const uint8_t*)&stamp, sizeof(uint64_t)});
-    sha256.update(sessionSecret);
-
-    auto digest = sha256.digest();
-    int pos = (digest[0] & 0xff) & 0x1f; // mod 32
-    int token = ((digest[pos] & 0xff) << 24) |
-            ((digest[(pos + 1) & 0x1f] & 0xff) << 16) |
-            ((digest[(pos + 2) & 0x1f] & 0xff) << 8) |
-            (digest[(pos + 3) & 0x1f] & 0xff);
 
-    return token;
+    // nodeId + ip + port + targetId, MACed in one pass
+    std::array<uint8_t, Id::BYTES * 2 + 16 + sizeof(uint16_t)> input;
+    uint8_t* ptr = input.data();
+    std::memcpy(ptr, nodeId.data(), Id::BYTES);
+    ptr += Id::BYTES;
+    std::memcpy(ptr, addr.inaddr(), addr.inaddrLength());
+    ptr += addr.inaddrLength();
+    std::memcpy(ptr, &port, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    std::memcpy(ptr, targetId.data(), Id::BYTES);
+    ptr += Id::BYTES;
+
+    auto mac = SipHash::digest({input.data(), static_cast<size_t>(ptr - input.data())}, key);
+    return static_cast<int>(static_cast<uint32_t>(mac ^ (mac >> 32)));
 }
 
 int TokenManager::generateToken(const Id& nodeId, const SocketAddress& addr, const Id& targetId) {
     updateTokenTimestamps();
-    return generateToken(nodeId, addr, targetId, timestamp.load(), sessionSecret);
+    return generateToken(nodeId, addr, targetId, currentKey);
 }
 
 bool TokenManager::verifyToken(int token, const Id& nodeId, const SocketAddress& addr, const Id& targetId) {
     updateTokenTimestamps();
 
-    int currentToken = generateToken(nodeId, addr, targetId, timestamp.load(), sessionSecret);
+    int currentToken = generateToken(nodeId, addr, targetId, currentKey);
     if (token == currentToken)
         return true;
-    int previousToken = generateToken(nodeId, addr, targetId, previousTimestamp, sessionSecret);
+    int previousToken = generateToken(nodeId, addr, targetId, previousKey);
     if (token == previousToken)
         return true;
 
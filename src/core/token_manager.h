@@ -27,11 +27,18 @@
 
 #include "boson/id.h"
 #include "boson/socket_address.h"
+#include "crypto/siphash.h"
 
 namespace boson {
 
 class SocketAddress;
 
+/*
+ * Write tokens: a SipHash-2-4 MAC of the requester and the target, keyed by a
+ * per-period key derived from the session secret. The key rotates every
+ * TOKEN_TIMEOUT; tokens of the current and the previous period are accepted.
+ * The key derivation (one SHA-256) runs once per rotation, not per token.
+ */
 class TokenManager {
 public:
     TokenManager();
@@ -41,11 +48,13 @@ public:
 
 private:
     void updateTokenTimestamps();
-    static int generateToken(const Id&, const SocketAddress&, const Id&, long, std::array<uint8_t, 32>&);
+    SipHash::Key deriveKey(uint64_t timestamp) const;
+    static int generateToken(const Id&, const SocketAddress&, const Id&, const SipHash::Key&);
 
     std::atomic_uint64_t timestamp {0};
-    uint64_t previousTimestamp;
     std::array<uint8_t, 32> sessionSecret {};
+    SipHash::Key currentKey {};
+    SipHash::Key previousKey {};
 };
 
 } // namespace boson
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+namespace boson {
+
+/*
+ * Vector with a fixed capacity and inline storage, for small collections on hot
+ * paths that must not allocate. Copying it copies the elements, so a copy is a
+ * snapshot that stays valid while the original is modified.
+ */
+template <class T, size_t N>
+class FixedVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    iterator begin() noexcept { return items.data(); }
+    iterator end() noexcept { return items.data() + count; }
+    const_iterator begin() const noexcept { return items.data(); }
+    const_iterator end() const noexcept { return items.data() + count; }
+
+    size_t size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+    bool full() const noexcept { return count == N; }
+    static constexpr size_t capacity() noexcept { return N; }
+
+    T& operator[](size_t index) noexcept { return items[index]; }
+    const T& operator[](size_t index) const noexcept { return items[index]; }
+
+    T& back() noexcept { return items[count - 1]; }
+    const T& back() const noexcept { return items[count - 1]; }
+
+    void push_back(T value) {
+        assert(count < N);
+        items[count++] = std::move(value);
+    }
+
+    void insert(size_t index, T value) {
+        assert(count < N && index <= count);
+        for (size_t i = count; i > index; i--)
+            items[i] = std::move(items[i - 1]);
+        items[index] = std::move(value);
+        count++;
+    }
+
+    void erase(size_t index) {
+        assert(index < count);
+        for (size_t i = index + 1; i < count; i++)
+            items[i - 1] = std::move(items[i]);
+        items[--count] = T {};
+    }
+
+    void clear() {
+        for (size_t i = 0; i < count; i++)
+            items[i] = T {};
+        count = 0;
+    }
+
+private:
+    std::array<T, N> items {};
+    size_t count {0};
+};
+
+} // namespace boson
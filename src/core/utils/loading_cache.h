@@ -23,81 +23,223 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
 #include "utils/time.h"
 
 namespace boson {
 
-template <typename Key, typename Value>
-class LocadingCache{
+/*
+ * Bounded, thread-safe loading cache.
+ *
+ * The key space is split into a power-of-two number of shards, each with its
+ * own lock, hash index and fixed number of slots, so concurrent lookups only
+ * contend when they land in the same shard. A full shard evicts with the CLOCK
+ * algorithm: every hit sets the entry's reference bit, and the clock hand
+ * clears bits until it finds an entry that was not used since its last pass.
+ *
+ * Values are loaded outside the shard lock and shared as immutable Sp<const>
+ * handles; the cache never copies a value, so Value only needs to be movable.
+ * An evicted value stays alive until the last caller drops its handle.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LoadingCache {
 public:
-    LocadingCache(int _ttl) : ttl(_ttl) { }
+    using ValuePtr = std::shared_ptr<const Value>;
+
+    LoadingCache(size_t capacity, int _ttl, size_t shards = 16) : ttl(_ttl) {
+        if (shards == 0 || (shards & (shards - 1)) != 0)
+            throw std::invalid_argument("Cache shards must be a power of 2");
+        if (capacity < shards)
+            throw std::invalid_argument("Cache capacity is less than the shards");
+
+        shardCount = shards;
+        while ((size_t(1) << shardBits) < shards)
+            shardBits++;
+
+        shardCapacity = capacity / shards;
+        this->shards = std::make_unique<Shard[]>(shards);
+        for (size_t i = 0; i < shards; i++) {
+            this->shards[i].index.reserve(shardCapacity);
+            this->shards[i].slots.reserve(shardCapacity);
+        }
+    }
+
+    virtual ~LoadingCache() = default;
+
+    LoadingCache(const LoadingCache&) = delete;
+    LoadingCache& operator=(const LoadingCache&) = delete;
 
-    Value& get(Key key) {
-        auto it = cache.find(key);
-        if (it == cache.end()) {
-            cache[key] = Entry(load(key), ttl);
-            it = cache.find(key);
+    ValuePtr get(const Key& key) {
+        auto hash = hasher(key);
+        auto& shard = shardOf(hash);
+        auto now = currentTimeMillis();
+
+        {
+            std::lock_guard<std::mutex> lk(shard.lock);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                auto& entry = shard.slots[it->second];
+                entry.referenced = true;
+                entry.expiration = now + ttl;
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return entry.value;
+            }
         }
-        else {
-            it->second.setExpirationTime(ttl);
+
+        // Loading may be expensive (key agreement), don't hold the shard meanwhile
+        misses.fetch_add(1, std::memory_order_relaxed);
+        auto value = std::make_shared<const Value>(load(key));
+
+        std::lock_guard<std::mutex> lk(shard.lock);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            // Lost the race against another loader, keep the cached one
+            auto& entry = shard.slots[it->second];
+            entry.referenced = true;
+            return entry.value;
         }
-        return it->second.value;
-    };
+
+        auto slot = allocate(shard);
+        auto& entry = shard.slots[slot];
+        entry.key = key;
+        entry.value = value;
+        entry.expiration = now + ttl;
+        entry.referenced = false;
+        shard.index.emplace(key, slot);
+        return value;
+    }
 
     void handleExpiration() {
         auto now = currentTimeMillis();
-        auto it = cache.begin();
-        while (it != cache.end()) {
-            auto entry = (*it).second;
-            auto cur_it = it++;
-            if (entry.expired(now)) {
-                onRemoval(entry.value);
-                cache.erase(cur_it);
+        for (size_t i = 0; i < shardCount; i++) {
+            auto& shard = shards[i];
+            std::lock_guard<std::mutex> lk(shard.lock);
+            for (uint32_t slot = 0; slot < shard.slots.size(); slot++) {
+                auto& entry = shard.slots[slot];
+                if (entry.value && now >= entry.expiration) {
+                    release(shard, slot);
+                    expirations.fetch_add(1, std::memory_order_relaxed);
+                }
             }
         }
-    };
+    }
 
-private:
-    struct Entry {
-        Entry() {};
-        ~Entry()=default;
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount; i++) {
+            std::lock_guard<std::mutex> lk(shards[i].lock);
+            total += shards[i].index.size();
+        }
+        return total;
+    }
 
-        Entry(const Entry& e) : value(e.value), expiration_time(e.expiration_time) {}
-        Entry(Entry&& e) : value(e.value), expiration_time(e.expiration_time) {}
+    size_t capacity() const noexcept {
+        return shardCapacity * shardCount;
+    }
 
-        Entry& operator=(const Entry& o) noexcept {
-            value = o.value;
-            expiration_time = o.expiration_time;
-            return *this;
-        }
+    uint64_t getHits() const noexcept {
+        return hits.load(std::memory_order_relaxed);
+    }
 
-        Entry& operator=(Entry&& o) noexcept {
-            value = o.value;
-            expiration_time = o.expiration_time;
-            return *this;
-        }
+    uint64_t getMisses() const noexcept {
+        return misses.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getEvictions() const noexcept {
+        return evictions.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getExpirations() const noexcept {
+        return expirations.load(std::memory_order_relaxed);
+    }
+
+protected:
+    virtual Value load(const Key& key) = 0;
+    virtual void onRemoval(const Value& val) {}
+
+private:
+    struct Entry {
+        Key key {};
+        ValuePtr value {};
+        uint64_t expiration {0};
+        bool referenced {false};
+    };
 
-        Entry(Value&& _value, int valid): value(_value),
-                expiration_time(currentTimeMillis() + valid) {}
+    struct Shard {
+        mutable std::mutex lock {};
+        std::unordered_map<Key, uint32_t, Hash> index {};
+        std::vector<Entry> slots {};
+        std::vector<uint32_t> freeSlots {};
+        size_t hand {0};
+    };
 
-        bool expired(uint64_t now) const {
-            return now >= expiration_time;
+    Shard& shardOf(size_t hash) const noexcept {
+        if (shardBits == 0)
+            return shards[0];
+        // the index buckets use the low bits, pick the shard by the mixed high bits
+        uint64_t mixed = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+        return shards[mixed >> (64 - shardBits)];
+    }
+
+    uint32_t allocate(Shard& shard) {
+        if (!shard.freeSlots.empty()) {
+            auto slot = shard.freeSlots.back();
+            shard.freeSlots.pop_back();
+            return slot;
         }
 
-        void setExpirationTime(int valid) {
-            expiration_time = currentTimeMillis() + valid;
+        if (shard.slots.size() < shardCapacity) {
+            shard.slots.emplace_back();
+            return static_cast<uint32_t>(shard.slots.size() - 1);
         }
 
-        Value value;
-        uint64_t expiration_time = 0;
-    };
+        // CLOCK sweep: at most one full turn clears every reference bit
+        while (true) {
+            auto slot = static_cast<uint32_t>(shard.hand);
+            shard.hand = (shard.hand + 1) % shard.slots.size();
 
-    virtual Value load(const Key &key) = 0;
-    virtual void onRemoval(const Value &val) = 0;
+            auto& entry = shard.slots[slot];
+            if (entry.referenced) {
+                entry.referenced = false;
+                continue;
+            }
 
-    std::map<Key, Entry> cache {};
+            release(shard, slot);
+            evictions.fetch_add(1, std::memory_order_relaxed);
+            shard.freeSlots.pop_back();
+            return slot;
+        }
+    }
+
+    void release(Shard& shard, uint32_t slot) {
+        auto& entry = shard.slots[slot];
+        onRemoval(*entry.value);
+        shard.index.erase(entry.key);
+        entry.value.reset();
+        entry.referenced = false;
+        shard.freeSlots.push_back(slot);
+    }
+
+    std::unique_ptr<Shard[]> shards {};
+    size_t shardCount {0};
+    size_t shardBits {0};
+    size_t shardCapacity {0};
     int ttl;
+    Hash hasher {};
+
+    std::atomic<uint64_t> hits {0};
+    std::atomic<uint64_t> misses {0};
+    std::atomic<uint64_t> evictions {0};
+    std::atomic<uint64_t> expirations {0};
 };
 
 } // namespace boson
@@ -73,6 +73,15 @@ enum PatternTimeType {
 #    define BOSON_LOG_ACTIVE_LEVEL BOSON_LOG_LEVEL_INFO
 #endif
 
+/*
+ * Levels below BOSON_LOG_MIN_LEVEL are compiled out of the Logger print methods. The
+ * arguments of a disabled call are still evaluated, so pass the objects themselves and
+ * let the formatters in log_formatters.h stringify them only when the message is logged.
+ */
+#if !defined(BOSON_LOG_MIN_LEVEL)
+#    define BOSON_LOG_MIN_LEVEL BOSON_LOG_LEVEL_TRACE
+#endif
+
 #define BOSON_LOGGER_CALL(logger, level, ...) (logger)->source_log(__FILE__, __LINE__, BOSON_FUNCTION, level, __VA_ARGS__);
 
 #if BOSON_LOG_ACTIVE_LEVEL <= BOSON_LOG_LEVEL_TRACE
@@ -136,6 +145,9 @@ public:
     //---- Print -----
     template<typename... Args>
     inline void log(Level level, format_string_t<Args...> fmt, Args &&... args) const {
+        if (!shouldLog(level))
+            return;
+
         spdlog::level::level_enum log_level =  spdlog::level::level_enum(level);
         spd_logger->log(log_level, fmt, std::forward<Args>(args)...);
     }
@@ -148,32 +160,38 @@ public:
 
     template<typename... Args>
     inline void trace(Args &&... args) const {
-        log(Level::Trace, std::forward<Args>(args)...);
+        if constexpr (BOSON_LOG_MIN_LEVEL <= BOSON_LOG_LEVEL_TRACE)
+            log(Level::Trace, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     inline void debug(Args &&... args) const {
-        log(Level::Debug, std::forward<Args>(args)...);
+        if constexpr (BOSON_LOG_MIN_LEVEL <= BOSON_LOG_LEVEL_DEBUG)
+            log(Level::Debug, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     inline void warn(Args &&... args) const {
-        log(Level::Warn, std::forward<Args>(args)...);
+        if constexpr (BOSON_LOG_MIN_LEVEL <= BOSON_LOG_LEVEL_WARN)
+            log(Level::Warn, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     inline void info(Args &&... args) const {
-        log(Level::Info, std::forward<Args>(args)...);
+        if constexpr (BOSON_LOG_MIN_LEVEL <= BOSON_LOG_LEVEL_INFO)
+            log(Level::Info, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     inline void error(Args &&... args) const {
-        log(Level::Error, std::forward<Args>(args)...);
+        if constexpr (BOSON_LOG_MIN_LEVEL <= BOSON_LOG_LEVEL_ERROR)
+            log(Level::Error, std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     inline void critical(Args &&... args) const {
-        log(Level::Critical, std::forward<Args>(args)...);
+        if constexpr (BOSON_LOG_MIN_LEVEL <= BOSON_LOG_LEVEL_CRITICAL)
+            log(Level::Critical, std::forward<Args>(args)...);
     }
 
     void setLevel(Level level);
@@ -182,6 +200,11 @@ public:
 
     bool isEnabled(Level level);
 
+    // Whether a message at the level passes the compile-time and the runtime level
+    bool shouldLog(Level level) const {
+        return level >= BOSON_LOG_MIN_LEVEL && spd_logger->should_log(spdlog::level::level_enum(level));
+    }
+
     bool isTraceEnabled() {
         return isEnabled(Level::Trace);
     }
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "boson/id.h"
+#include "boson/node_info.h"
+#include "boson/socket_address.h"
+#include "messages/message.h"
+
+namespace boson {
+
+/*
+ * Formats an object through its toString(). Logging the object instead of its string
+ * defers the stringification until the logger has accepted the message, so calls below
+ * the active level cost nothing but the level check.
+ */
+template <typename Base>
+struct ToStringFormatter : fmt::formatter<std::string_view> {
+    template <typename FormatContext>
+    auto format(const Base& object, FormatContext& ctx) const -> decltype(ctx.out()) {
+        return fmt::formatter<std::string_view>::format(object.toString(), ctx);
+    }
+};
+
+} // namespace boson
+
+namespace fmt {
+
+template <typename T>
+struct formatter<T, char, std::enable_if_t<std::is_base_of_v<boson::Id, T>>>
+    : boson::ToStringFormatter<boson::Id> {};
+
+template <typename T>
+struct formatter<T, char, std::enable_if_t<std::is_base_of_v<boson::NodeInfo, T>>>
+    : boson::ToStringFormatter<boson::NodeInfo> {};
+
+template <typename T>
+struct formatter<T, char, std::enable_if_t<std::is_base_of_v<boson::SocketAddress, T>>>
+    : boson::ToStringFormatter<boson::SocketAddress> {};
+
+template <typename T>
+struct formatter<T, char, std::enable_if_t<std::is_base_of_v<boson::Message, T>>>
+    : boson::ToStringFormatter<boson::Message> {};
+
+} // namespace fmt
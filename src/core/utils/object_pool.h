@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "boson/types.h"
+
+namespace boson {
+
+/*
+ * Free list of equally sized raw memory blocks, the backing store of
+ * PoolAllocator. The block size is fixed by the first allocation; requests of
+ * any other size, and blocks released while the list is full, go straight to
+ * the global heap. Thread-safe.
+ */
+class BlockPool {
+public:
+    explicit BlockPool(size_t _maxPooled) : maxPooled(_maxPooled) {
+        blocks.reserve(maxPooled);
+    }
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    ~BlockPool() {
+        for (auto block : blocks)
+            ::operator delete(block);
+    }
+
+    void* allocate(size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (blockSize == 0)
+                blockSize = size;
+
+            if (size == blockSize && !blocks.empty()) {
+                auto block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, size_t size) noexcept {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (size == blockSize && blocks.size() < maxPooled) {
+                blocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return blocks.size();
+    }
+
+private:
+    size_t maxPooled;
+    size_t blockSize {0};
+    std::vector<void*> blocks;
+    mutable std::mutex mutex;
+};
+
+/*
+ * Standard allocator over a BlockPool. Meant for the single-object allocations
+ * of std::allocate_shared and the shared_ptr control blocks, so the blocks it
+ * hands out are recycled instead of going back to the heap.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(BlockPool& _pool) noexcept : pool(&_pool) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool(other.pool) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(pool->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        pool->deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool == other.pool;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept {
+        return pool != other.pool;
+    }
+
+private:
+    template <typename U> friend class PoolAllocator;
+
+    BlockPool* pool;
+};
+
+/*
+ * Recycling pool for the objects behind Sp<T>.
+ *
+ * acquire() returns an object in its freshly constructed state. When the last
+ * reference is dropped the object is not destroyed: it is reset() in place and
+ * kept for the next acquire(), together with whatever storage it has grown, and
+ * the shared_ptr control block is recycled through a BlockPool. In the steady
+ * state acquiring and releasing an object does not touch the heap.
+ *
+ * T must be default constructible and provide reset(), restoring the default
+ * constructed state. Thread-safe: objects may be released on any thread.
+ */
+template <typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t _maxPooled)
+            : maxPooled(_maxPooled), controlBlocks(_maxPooled) {
+        objects.reserve(maxPooled);
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    ~ObjectPool() {
+        for (auto object : objects)
+            delete object;
+    }
+
+    Sp<T> acquire() {
+        T* object = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!objects.empty()) {
+                object = objects.back();
+                objects.pop_back();
+            }
+        }
+
+        if (object == nullptr)
+            object = new T();
+
+        // if the control block can't be allocated, the object goes to the recycler
+        return Sp<T>(object, Recycler{this}, PoolAllocator<T>(controlBlocks));
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return objects.size();
+    }
+
+private:
+    struct Recycler {
+        ObjectPool* pool;
+
+        void operator()(T* object) const noexcept {
+            pool->recycle(object);
+        }
+    };
+
+    void recycle(T* object) noexcept {
+        object->reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (objects.size() < maxPooled) {
+                objects.push_back(object);
+                return;
+            }
+        }
+        delete object;
+    }
+
+    size_t maxPooled;
+    std::vector<T*> objects;
+    BlockPool controlBlocks;
+    mutable std::mutex mutex;
+};
+
+} // namespace boson
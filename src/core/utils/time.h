@@ -35,4 +35,10 @@ inline uint64_t currentTimeMillis() {
     return value.count();
 }
 
+// Monotonic clock for measuring intervals
+inline uint64_t steadyTimeMicros() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+}
+
 } // namespace boson
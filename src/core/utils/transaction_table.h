@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace boson {
+
+/*
+ * Pending RPC transactions keyed by txid.
+ *
+ * Entries live in a fixed pool allocated up front, so nothing is allocated
+ * after construction. The index is an open-addressing hash table with linear
+ * probing and backward-shift deletion (no tombstones), pointing into the pool.
+ * Every entry is also linked into an intrusive list in insertion order; all
+ * entries get the same lifetime, so the list is ordered by deadline as well
+ * and the expired ones are always at its head.
+ */
+template <class T>
+class TransactionTable {
+public:
+    explicit TransactionTable(size_t capacity) {
+        if (capacity == 0 || capacity >= NIL)
+            throw std::invalid_argument("Invalid transaction table capacity");
+
+        // keep the index at most half full
+        size_t buckets = 2;
+        while (buckets < capacity * 2)
+            buckets <<= 1;
+
+        mask = buckets - 1;
+        slots.resize(buckets);
+        entries.resize(capacity);
+
+        for (size_t i = 0; i < capacity; i++)
+            entries[i].next = static_cast<uint32_t>(i + 1 < capacity ? i + 1 : NIL);
+        freeList = 0;
+    }
+
+    TransactionTable(const TransactionTable&) = delete;
+    TransactionTable& operator=(const TransactionTable&) = delete;
+
+    size_t size() const noexcept {
+        return count;
+    }
+
+    size_t capacity() const noexcept {
+        return entries.size();
+    }
+
+    bool empty() const noexcept {
+        return count == 0;
+    }
+
+    bool full() const noexcept {
+        return count == entries.size();
+    }
+
+    bool contains(int txid) const noexcept {
+        return slots[probe(txid)].entry != NIL;
+    }
+
+    // Fails if the txid is still in use, e.g. after the txid counter wrapped, or if the table is full
+    bool insert(int txid, T value, uint64_t deadline) {
+        size_t slot = probe(txid);
+        if (slots[slot].entry != NIL || freeList == NIL)
+            return false;
+
+        uint32_t index = freeList;
+        Entry& entry = entries[index];
+        freeList = entry.next;
+
+        entry.value = std::move(value);
+        entry.txid = txid;
+        entry.deadline = deadline;
+        entry.prev = tail;
+        entry.next = NIL;
+        if (tail != NIL)
+            entries[tail].next = index;
+        else
+            head = index;
+        tail = index;
+
+        slots[slot].txid = txid;
+        slots[slot].entry = index;
+        count++;
+        return true;
+    }
+
+    // nullptr if there is no such transaction
+    T* find(int txid) noexcept {
+        size_t slot = probe(txid);
+        return slots[slot].entry == NIL ? nullptr : &entries[slots[slot].entry].value;
+    }
+
+    // The removed value, or a default constructed one if there is no such transaction
+    T remove(int txid) {
+        size_t slot = probe(txid);
+        if (slots[slot].entry == NIL)
+            return T{};
+
+        return release(slot);
+    }
+
+    // Remove the oldest transaction if its deadline passed, a default constructed value otherwise
+    T popExpired(uint64_t now) {
+        if (head == NIL || entries[head].deadline > now)
+            return T{};
+
+        return release(probe(entries[head].txid));
+    }
+
+    void clear() {
+        while (head != NIL)
+            release(probe(entries[head].txid));
+    }
+
+private:
+    static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        int txid {0};
+        uint32_t entry {NIL};
+    };
+
+    struct Entry {
+        T value {};
+        int txid {0};
+        uint64_t deadline {0};
+        uint32_t prev {NIL};
+        uint32_t next {NIL};
+    };
+
+    size_t home(int txid) const noexcept {
+        // Fibonacci hashing spreads the sequential txids over the whole index
+        return (static_cast<uint32_t>(txid) * 2654435769u) & mask;
+    }
+
+    // The slot holding the txid, or the empty slot that ends its probe sequence
+    size_t probe(int txid) const noexcept {
+        size_t slot = home(txid);
+        while (slots[slot].entry != NIL && slots[slot].txid != txid)
+            slot = (slot + 1) & mask;
+
+        return slot;
+    }
+
+    T release(size_t slot) {
+        uint32_t index = slots[slot].entry;
+        Entry& entry = entries[index];
+
+        if (entry.prev != NIL)
+            entries[entry.prev].next = entry.next;
+        else
+            head = entry.next;
+        if (entry.next != NIL)
+            entries[entry.next].prev = entry.prev;
+        else
+            tail = entry.prev;
+
+        T value = std::move(entry.value);
+        entry.value = T{};
+        entry.prev = NIL;
+        entry.next = freeList;
+        freeList = index;
+
+        // backward-shift the rest of the cluster so lookups never hit a hole
+        size_t hole = slot;
+        size_t next = slot;
+        while (true) {
+            next = (next + 1) & mask;
+            if (slots[next].entry == NIL)
+                break;
+
+            // the entry may move into the hole unless the hole lies before its home slot
+            size_t distance = (next - home(slots[next].txid)) & mask;
+            if (distance >= ((next - hole) & mask)) {
+                slots[hole] = slots[next];
+                hole = next;
+            }
+        }
+        slots[hole].entry = NIL;
+
+        count--;
+        return value;
+    }
+
+    std::vector<Slot> slots {};
+    std::vector<Entry> entries {};
+    size_t mask {0};
+    size_t count {0};
+    uint32_t freeList {NIL};
+    uint32_t head {NIL};
+    uint32_t tail {NIL};
+};
+
+} // namespace boson
@@ -28,6 +28,7 @@
 #include "crypto/shasum.h"
 #include "exceptions/state_error.h"
 #include "serializers.h"
+#include "verified_records.h"
 
 namespace boson {
 
@@ -129,7 +130,7 @@ bool Value::isValid() const {
         assert(signature.has_value() && signature.value().size() == Signature::BYTES);
 
         auto pk = publicKey->toSignatureKey();
-        return Signature::verify(getSignData(), signature.value(), pk);
+        return VerifiedRecords::global().verify(getSignData(), signature.value(), pk);
     }
 
     return true;
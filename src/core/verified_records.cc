@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstring>
+#include <stdexcept>
+
+#include "crypto/shasum.h"
+#include "constants.h"
+#include "verified_records.h"
+
+namespace boson {
+
+VerifiedRecords::VerifiedRecords(size_t capacity) {
+    if (capacity < LOCK_STRIPES || (capacity & (capacity - 1)) != 0)
+        throw std::invalid_argument("Verified records capacity must be a power of 2");
+
+    // all zeros marks an empty slot, no real digest is expected to be zero
+    slots.resize(capacity, Digest {});
+    mask = capacity - 1;
+}
+
+VerifiedRecords::Digest VerifiedRecords::digestOf(const Blob& data, const Blob& signature,
+        const Signature::PublicKey& pk) {
+    SHA256 sha;
+    sha.update(Blob(pk.bytes(), Signature::PublicKey::BYTES));
+    sha.update(signature);
+    sha.update(data);
+
+    Digest digest;
+    Blob hash(digest);
+    sha.digest(hash);
+    return digest;
+}
+
+size_t VerifiedRecords::slotOf(const Digest& digest) const noexcept {
+    uint64_t h;
+    std::memcpy(&h, digest.data(), sizeof(h));
+    return static_cast<size_t>(h) & mask;
+}
+
+bool VerifiedRecords::contains(const Digest& digest) {
+    auto slot = slotOf(digest);
+    std::lock_guard<std::mutex> lk(lockOf(slot));
+    return slots[slot] == digest;
+}
+
+void VerifiedRecords::add(const Digest& digest) {
+    auto slot = slotOf(digest);
+    std::lock_guard<std::mutex> lk(lockOf(slot));
+    slots[slot] = digest;
+}
+
+void VerifiedRecords::clear() {
+    for (size_t slot = 0; slot < slots.size(); slot++) {
+        std::lock_guard<std::mutex> lk(lockOf(slot));
+        slots[slot] = Digest {};
+    }
+}
+
+bool VerifiedRecords::verify(const Blob& data, const Blob& signature, const Signature::PublicKey& pk) {
+    auto digest = digestOf(data, signature, pk);
+    if (contains(digest)) {
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+    if (!Signature::verify(data, signature, pk))
+        return false;
+
+    add(digest);
+    return true;
+}
+
+VerifiedRecords& VerifiedRecords::global() {
+    static VerifiedRecords records(Constants::VERIFIED_RECORDS_CAPACITY);
+    return records;
+}
+
+} // namespace boson
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "boson/blob.h"
+#include "boson/signature.h"
+
+namespace boson {
+
+/*
+ * Digests of the recently verified signed records, so a value or peer that
+ * comes back from many nodes during one lookup is only verified once.
+ *
+ * The digest covers the public key, the signature and the whole signed
+ * payload, so a hit can only vouch for exactly the record that was verified.
+ * Only successful verifications are remembered. The table is direct-mapped:
+ * each digest has a single slot chosen by its leading bytes, and a newer
+ * record mapped to the same slot replaces the older one.
+ */
+class VerifiedRecords {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    explicit VerifiedRecords(size_t capacity);
+
+    VerifiedRecords(const VerifiedRecords&) = delete;
+    VerifiedRecords& operator=(const VerifiedRecords&) = delete;
+
+    // Signature::verify(), skipped for the records verified recently
+    bool verify(const Blob& data, const Blob& signature, const Signature::PublicKey& pk);
+
+    static Digest digestOf(const Blob& data, const Blob& signature, const Signature::PublicKey& pk);
+    bool contains(const Digest& digest);
+    void add(const Digest& digest);
+    void clear();
+
+    size_t capacity() const noexcept {
+        return slots.size();
+    }
+
+    uint64_t getHits() const noexcept {
+        return hits.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getMisses() const noexcept {
+        return misses.load(std::memory_order_relaxed);
+    }
+
+    double getHitRate() const noexcept {
+        auto h = getHits();
+        auto total = h + getMisses();
+        return total == 0 ? 0.0 : static_cast<double>(h) / total;
+    }
+
+    // The cache shared by Value::isValid() and PeerInfo::isValid()
+    static VerifiedRecords& global();
+
+private:
+    static const size_t LOCK_STRIPES = 16;
+
+    size_t slotOf(const Digest& digest) const noexcept;
+    std::mutex& lockOf(size_t slot) noexcept {
+        return locks[slot & (LOCK_STRIPES - 1)];
+    }
+
+    std::vector<Digest> slots;
+    size_t mask;
+    std::array<std::mutex, LOCK_STRIPES> locks {};
+
+    std::atomic<uint64_t> hits {0};
+    std::atomic<uint64_t> misses {0};
+};
+
+} // namespace boson
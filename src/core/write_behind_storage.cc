@@ -0,0 +1,676 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <functional>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <utility>
+
+#include "constants.h"
+#include "utils/time.h"
+#include "write_behind_storage.h"
+
+namespace boson {
+
+WriteBehindStorage::WriteBehindStorage(Sp<DataStorage> _backend, int _commitInterval, int _commitBatchSize)
+    : backend(std::move(_backend)), commitInterval(_commitInterval),
+      commitBatchSize(_commitBatchSize > 0 ? _commitBatchSize : 1) {
+    log = Logger::get("Storage");
+
+    running = true;
+    executor = std::thread(&WriteBehindStorage::run, this);
+}
+
+WriteBehindStorage::WriteBehindStorage(Sp<DataStorage> backend)
+    : WriteBehindStorage(std::move(backend), Constants::STORAGE_COMMIT_INTERVAL,
+            Constants::STORAGE_COMMIT_BATCH_SIZE) {
+}
+
+WriteBehindStorage::~WriteBehindStorage() {
+    close();
+}
+
+void WriteBehindStorage::close() {
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (closed)
+            return;
+        closed = true;
+        running = false;
+    }
+    ready.notify_all();
+
+    if (executor.joinable())
+        executor.join();
+
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        log->error("Closing with {} records not committed: {}", getQueueDepth(), e.what());
+    }
+    backend->close();
+}
+
+void WriteBehindStorage::run() {
+    bool failed = false;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(lock);
+            ready.wait(lk, [this]() { return !running || !pending.empty(); });
+            if (!running)
+                break;
+
+            // give the batch a chance to fill up before paying for the commit,
+            // a failed one is retried no sooner than the interval
+            ready.wait_for(lk, commitInterval, [this, failed]() {
+                return !running || (!failed && pending.size() >= commitBatchSize);
+            });
+        }
+
+        std::lock_guard<std::mutex> wl(writeLock);
+        try {
+            commit();
+            failed = false;
+        } catch (const std::exception&) {
+            // logged by commit(), the records are pending again
+            failed = true;
+        }
+    }
+}
+
+void WriteBehindStorage::flush() {
+    std::lock_guard<std::mutex> wl(writeLock);
+    commit();
+}
+
+void WriteBehindStorage::commit() {
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (pending.empty())
+            return;
+        std::swap(pending, committing);
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    try {
+        backend->transaction([this]() {
+            // a rejected record must not roll back the rest of the batch
+            auto apply = [this](const char* what, const Id& id, const std::function<void()>& write) {
+                try {
+                    write();
+                } catch (const std::exception& e) {
+                    log->warn("Dropped {} {} on commit: {}", what, id.toBase58String(), e.what());
+                }
+            };
+
+            for (const auto& id : committing.removedValues)
+                apply("value removal", id, [&]() { backend->removeValue(id); });
+            for (const auto& key : committing.removedPeers)
+                apply("peer removal", key.first, [&]() { backend->removePeer(key.first, key.second); });
+
+            for (const auto& entry : committing.values) {
+                const auto& v = entry.second;
+                apply("value", entry.first, [&]() {
+                    backend->putValue(v.value, -1, v.persistent, v.updateLastAnnounce);
+                });
+            }
+            for (const auto& entry : committing.peers) {
+                const auto& p = entry.second;
+                apply("peer", p.peer.getId(), [&]() {
+                    backend->putPeer(p.peer, p.persistent, p.updateLastAnnounce);
+                });
+            }
+
+            for (const auto& id : committing.announcedValues)
+                apply("value announce", id, [&]() { backend->updateValueLastAnnounce(id); });
+            for (const auto& key : committing.announcedPeers)
+                apply("peer announce", key.first, [&]() { backend->updatePeerLastAnnounce(key.first, key.second); });
+        });
+    } catch (const std::exception& e) {
+        log->error("Commit of {} records failed, will retry: {}", committing.size(), e.what());
+        std::lock_guard<std::mutex> lk(lock);
+        requeue();
+        throw;
+    }
+
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count();
+    lastCommitLatency = latency;
+    totalCommitLatency += latency;
+    ++commits;
+    log->debug("Committed {} records in {}us", committing.size(), latency);
+
+    std::lock_guard<std::mutex> lk(lock);
+    committing = {};
+}
+
+void WriteBehindStorage::requeue() {
+    // the failed batch is older than anything put since, the newer writes win
+    for (auto& [id, v] : committing.values) {
+        if (pending.removedValues.count(id))
+            continue;
+
+        auto [it, inserted] = pending.values.try_emplace(id, std::move(v));
+        if (!inserted) {
+            // as when coalescing, the first write decides the persistent and announce state
+            it->second.persistent = v.persistent;
+            it->second.updateLastAnnounce = v.updateLastAnnounce;
+        }
+    }
+
+    for (auto& [key, p] : committing.peers) {
+        if (pending.removedPeers.count({std::get<0>(key), std::get<2>(key)}))
+            continue;
+        pending.peers.try_emplace(key, std::move(p));
+    }
+
+    for (const auto& id : committing.announcedValues) {
+        if (!pending.removedValues.count(id))
+            pending.announcedValues.insert(id);
+    }
+    for (const auto& key : committing.announcedPeers) {
+        if (!pending.removedPeers.count(key))
+            pending.announcedPeers.insert(key);
+    }
+
+    // the removals are committed first, so they stay older than every put they join
+    pending.removedValues.insert(committing.removedValues.begin(), committing.removedValues.end());
+    pending.removedPeers.insert(committing.removedPeers.begin(), committing.removedPeers.end());
+
+    committing = {};
+}
+
+std::string WriteBehindStorage::toString() const {
+    std::stringstream ss;
+    ss << "### storage writes" << std::endl;
+    ss << "queue depth: " << getQueueDepth() << ", commits: " << getCommits()
+        << ", last commit: " << getLastCommitLatency() << " us"
+        << ", average commit: " << getAverageCommitLatency() << " us" << std::endl;
+    ss << backend->toString();
+    return ss.str();
+}
+
+size_t WriteBehindStorage::getQueueDepth() const {
+    std::lock_guard<std::mutex> lk(lock);
+    return pending.size() + committing.size();
+}
+
+// Erases the peers announced by the origin, whatever node they were announced to
+template <typename Peers>
+static void eraseOrigin(Peers& peers, const Id& peerId, const Id& origin) {
+    auto it = peers.lower_bound({peerId, Id::MIN_ID, Id::MIN_ID});
+    while (it != peers.end() && std::get<0>(it->first) == peerId) {
+        if (std::get<2>(it->first) == origin)
+            it = peers.erase(it);
+        else
+            ++it;
+    }
+}
+
+// Keeps the earlier of the two, 0 stands for no known expiration
+static void earliest(uint64_t& expiration, uint64_t other) {
+    if (other != 0 && (expiration == 0 || other < expiration))
+        expiration = other;
+}
+
+std::optional<Sp<Value>> WriteBehindStorage::findValue(const Id& valueId) const {
+    for (const auto* batch : { &pending, &committing }) {
+        auto it = batch->values.find(valueId);
+        if (it != batch->values.end())
+            return std::make_shared<Value>(it->second.value);
+        // removed, and not put again since
+        if (batch->removedValues.count(valueId))
+            return Sp<Value>();
+    }
+
+    return std::nullopt;
+}
+
+Sp<Value> WriteBehindStorage::getValue(const Id& valueId) {
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (auto value = findValue(valueId))
+            return *value;
+    }
+
+    return backend->getValue(valueId);
+}
+
+Sp<Value> WriteBehindStorage::loadValue(const Id& valueId, uint64_t& expiration) {
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (auto value = findValue(valueId)) {
+            // stamped when committed, so no sooner than from now
+            expiration = *value ? currentTimeMillis() + Constants::MAX_VALUE_AGE : 0;
+            return *value;
+        }
+    }
+
+    return backend->loadValue(valueId, expiration);
+}
+
+Sp<Value> WriteBehindStorage::putValue(const Value& value, int expectedSeq, bool persistent, bool updateLastAnnounce) {
+    if (value.isMutable() && !value.isValid())
+        throw std::invalid_argument("Value signature validation failed");
+
+    auto id = value.getId();
+    Sp<Value> old;
+    bool full;
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        while (true) {
+            if (auto queued = findValue(id)) {
+                old = *queued;
+                break;
+            }
+
+            // read the backend without the lock; the check and the write stay one
+            // step as long as no other value write was queued meanwhile, otherwise
+            // two racing puts could both pass against the same old sequence number
+            auto writes = valueWrites;
+            lk.unlock();
+            old = backend->getValue(id);
+            lk.lock();
+            if (valueWrites == writes)
+                break;
+        }
+
+        checkReplace(old, value, expectedSeq);
+
+        auto [it, inserted] = pending.values.try_emplace(id, PendingValue {value, persistent, updateLastAnnounce});
+        // the backend keeps the persistent and announce state of an existing value,
+        // so a coalesced update does the same
+        if (!inserted)
+            it->second.value = value;
+        valueWrites++;
+        full = pending.size() >= commitBatchSize;
+    }
+
+    if (full)
+        ready.notify_one();
+    return old;
+}
+
+bool WriteBehindStorage::removeValue(const Id& valueId) {
+    bool removed;
+    bool full;
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        auto queued = findValue(valueId);
+        if (!queued) {
+            lk.unlock();
+            auto stored = backend->getValue(valueId);
+            lk.lock();
+            // queued since, that decides
+            queued = findValue(valueId);
+            removed = queued ? *queued != nullptr : stored != nullptr;
+        } else {
+            removed = *queued != nullptr;
+        }
+
+        pending.values.erase(valueId);
+        pending.announcedValues.erase(valueId);
+        pending.removedValues.insert(valueId);
+        valueWrites++;
+        full = pending.size() >= commitBatchSize;
+    }
+
+    if (full)
+        ready.notify_one();
+    return removed;
+}
+
+void WriteBehindStorage::updateValueLastAnnounce(const Id& valueId) {
+    bool full;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        pending.announcedValues.insert(valueId);
+        full = pending.size() >= commitBatchSize;
+    }
+
+    if (full)
+        ready.notify_one();
+}
+
+std::vector<Value> WriteBehindStorage::getPersistentValues(uint64_t lastAnnounceBefore) {
+    Batch newer, older;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        newer = pending;
+        older = committing;
+    }
+
+    std::map<Id, Value> values {};
+    for (auto& value : backend->getPersistentValues(lastAnnounceBefore)) {
+        auto id = value.getId();
+        values.emplace(id, std::move(value));
+    }
+
+    // replay the overlay on the backend's answer, the older batch first
+    auto now = currentTimeMillis();
+    std::set<Id> removed {};
+    for (const auto* batch : { &older, &newer }) {
+        for (const auto& id : batch->removedValues) {
+            values.erase(id);
+            removed.insert(id);
+        }
+
+        for (const auto& [id, v] : batch->values) {
+            auto it = values.find(id);
+            if (it != values.end()) {
+                // the backend keeps the persistent and announce state, only the content changes
+                it->second = v.value;
+            } else if (v.persistent && (v.updateLastAnnounce ? now : 0) <= lastAnnounceBefore &&
+                    (removed.count(id) || !backend->getValue(id))) {
+                // a new record, it takes the state of this put
+                values.emplace(id, v.value);
+            }
+        }
+
+        if (now > lastAnnounceBefore) {
+            for (const auto& id : batch->announcedValues)
+                values.erase(id);
+        }
+    }
+
+    std::vector<Value> result {};
+    result.reserve(values.size());
+    for (auto& [id, value] : values)
+        result.push_back(std::move(value));
+    return result;
+}
+
+std::vector<Id> WriteBehindStorage::getAllValues() {
+    std::vector<Id> removed[2], put[2];    // committing, pending
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        int i = 0;
+        for (const auto* batch : { &committing, &pending }) {
+            removed[i].assign(batch->removedValues.begin(), batch->removedValues.end());
+            for (const auto& [id, v] : batch->values)
+                put[i].push_back(id);
+            i++;
+        }
+    }
+
+    auto ids = backend->getAllValues();
+    std::set<Id> all(ids.begin(), ids.end());
+    for (int i = 0; i < 2; i++) {
+        for (const auto& id : removed[i])
+            all.erase(id);
+        all.insert(put[i].begin(), put[i].end());
+    }
+
+    return std::vector<Id>(all.begin(), all.end());
+}
+
+void WriteBehindStorage::enqueue(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) {
+    PeerKey key {peer.getId(), peer.getNodeId(), peer.getOrigin()};
+    pending.peers.insert_or_assign(std::move(key), PendingPeer {peer, persistent, updateLastAnnounce});
+}
+
+void WriteBehindStorage::putPeer(const std::vector<PeerInfo>& peers) {
+    bool full;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        for (const auto& peer : peers)
+            enqueue(peer, false, false);
+        full = pending.size() >= commitBatchSize;
+    }
+
+    if (full)
+        ready.notify_one();
+}
+
+void WriteBehindStorage::putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) {
+    bool full;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        enqueue(peer, persistent, updateLastAnnounce);
+        full = pending.size() >= commitBatchSize;
+    }
+
+    if (full)
+        ready.notify_one();
+}
+
+WriteBehindStorage::Batch WriteBehindStorage::slicePeers(const Batch& batch, const Id& peerId) {
+    Batch slice {};
+    auto it = batch.peers.lower_bound({peerId, Id::MIN_ID, Id::MIN_ID});
+    for (; it != batch.peers.end() && std::get<0>(it->first) == peerId; ++it)
+        slice.peers.insert(*it);
+
+    auto rit = batch.removedPeers.lower_bound({peerId, Id::MIN_ID});
+    for (; rit != batch.removedPeers.end() && rit->first == peerId; ++rit)
+        slice.removedPeers.insert(*rit);
+    return slice;
+}
+
+std::vector<PeerInfo> WriteBehindStorage::findPeers(const Batch& newer, const Batch& older, const Id& peerId,
+        int maxPeers, uint64_t* expiration) {
+    std::vector<PeerInfo> peers {};
+    std::set<PeerKey> seen {};
+    // removed in a newer batch, hidden in the older ones and in the backend
+    std::set<PeerOrigin> removed {};
+
+    auto visible = [&](const PeerKey& key) {
+        return seen.count(key) == 0 && removed.count({std::get<0>(key), std::get<2>(key)}) == 0;
+    };
+
+    for (const auto* batch : { &newer, &older }) {
+        auto it = batch->peers.lower_bound({peerId, Id::MIN_ID, Id::MIN_ID});
+        for (; it != batch->peers.end() && std::get<0>(it->first) == peerId; ++it) {
+            if (visible(it->first)) {
+                seen.insert(it->first);
+                peers.push_back(it->second.peer);
+                if (expiration)
+                    earliest(*expiration, currentTimeMillis() + Constants::MAX_PEER_AGE);
+            }
+        }
+
+        auto rit = batch->removedPeers.lower_bound({peerId, Id::MIN_ID});
+        for (; rit != batch->removedPeers.end() && rit->first == peerId; ++rit)
+            removed.insert(*rit);
+    }
+
+    if (maxPeers > 0 && peers.size() >= (size_t)maxPeers) {
+        peers.erase(peers.begin() + maxPeers, peers.end());
+        return peers;
+    }
+
+    // ask for more to make up for the peers the overlay already has or hides
+    int wanted = maxPeers > 0 ? maxPeers + (int)(seen.size() + removed.size()) : maxPeers;
+    uint64_t loaded = 0;
+    auto found = expiration ? backend->loadPeers(peerId, wanted, loaded) : backend->getPeer(peerId, wanted);
+    if (expiration)
+        earliest(*expiration, loaded);
+
+    for (auto& peer : found) {
+        if (maxPeers > 0 && peers.size() >= (size_t)maxPeers)
+            break;
+        if (visible({peer.getId(), peer.getNodeId(), peer.getOrigin()}))
+            peers.push_back(std::move(peer));
+    }
+
+    return peers;
+}
+
+std::vector<PeerInfo> WriteBehindStorage::getPeer(const Id& peerId, int maxPeers) {
+    Batch newer, older;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        newer = slicePeers(pending, peerId);
+        older = slicePeers(committing, peerId);
+    }
+
+    return findPeers(newer, older, peerId, maxPeers);
+}
+
+std::vector<PeerInfo> WriteBehindStorage::loadPeers(const Id& peerId, int maxPeers, uint64_t& expiration) {
+    Batch newer, older;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        newer = slicePeers(pending, peerId);
+        older = slicePeers(committing, peerId);
+    }
+
+    expiration = 0;
+    return findPeers(newer, older, peerId, maxPeers, &expiration);
+}
+
+std::optional<Sp<PeerInfo>> WriteBehindStorage::findPeer(const Id& peerId, const Id& origin) const {
+    for (const auto* batch : { &pending, &committing }) {
+        auto it = batch->peers.lower_bound({peerId, Id::MIN_ID, Id::MIN_ID});
+        for (; it != batch->peers.end() && std::get<0>(it->first) == peerId; ++it) {
+            if (std::get<2>(it->first) == origin)
+                return std::make_shared<PeerInfo>(it->second.peer);
+        }
+
+        if (batch->removedPeers.count({peerId, origin}))
+            return Sp<PeerInfo>();
+    }
+
+    return std::nullopt;
+}
+
+Sp<PeerInfo> WriteBehindStorage::getPeer(const Id& peerId, const Id& origin) {
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if (auto peer = findPeer(peerId, origin))
+            return *peer;
+    }
+
+    return backend->getPeer(peerId, origin);
+}
+
+bool WriteBehindStorage::removePeer(const Id& peerId, const Id& origin) {
+    bool removed;
+    bool full;
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        auto queued = findPeer(peerId, origin);
+        if (!queued) {
+            lk.unlock();
+            auto stored = backend->getPeer(peerId, origin);
+            lk.lock();
+            // queued since, that decides
+            queued = findPeer(peerId, origin);
+            removed = queued ? *queued != nullptr : stored != nullptr;
+        } else {
+            removed = *queued != nullptr;
+        }
+
+        eraseOrigin(pending.peers, peerId, origin);
+        pending.announcedPeers.erase({peerId, origin});
+        pending.removedPeers.insert({peerId, origin});
+        full = pending.size() >= commitBatchSize;
+    }
+
+    if (full)
+        ready.notify_one();
+    return removed;
+}
+
+void WriteBehindStorage::updatePeerLastAnnounce(const Id& peerId, const Id& origin) {
+    bool full;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        pending.announcedPeers.insert({peerId, origin});
+        full = pending.size() >= commitBatchSize;
+    }
+
+    if (full)
+        ready.notify_one();
+}
+
+std::vector<PeerInfo> WriteBehindStorage::getPersistentPeers(uint64_t lastAnnounceBefore) {
+    Batch newer, older;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        newer = pending;
+        older = committing;
+    }
+
+    std::map<PeerKey, PeerInfo> peers {};
+    for (auto& peer : backend->getPersistentPeers(lastAnnounceBefore)) {
+        PeerKey key {peer.getId(), peer.getNodeId(), peer.getOrigin()};
+        peers.emplace(std::move(key), std::move(peer));
+    }
+
+    // replay the overlay on the backend's answer, the older batch first
+    auto now = currentTimeMillis();
+    for (const auto* batch : { &older, &newer }) {
+        for (const auto& [peerId, origin] : batch->removedPeers)
+            eraseOrigin(peers, peerId, origin);
+
+        // a put replaces the whole record, the persistent and announce state included
+        for (const auto& [key, p] : batch->peers) {
+            if (p.persistent && (p.updateLastAnnounce ? now : 0) <= lastAnnounceBefore)
+                peers.insert_or_assign(key, p.peer);
+            else
+                peers.erase(key);
+        }
+
+        if (now > lastAnnounceBefore) {
+            for (const auto& [peerId, origin] : batch->announcedPeers)
+                eraseOrigin(peers, peerId, origin);
+        }
+    }
+
+    std::vector<PeerInfo> result {};
+    result.reserve(peers.size());
+    for (auto& [key, peer] : peers)
+        result.push_back(std::move(peer));
+    return result;
+}
+
+std::vector<Id> WriteBehindStorage::getAllPeers() {
+    Batch newer, older;
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        newer = pending;
+        older = committing;
+    }
+
+    auto ids = backend->getAllPeers();
+    std::set<Id> all(ids.begin(), ids.end());
+    std::set<Id> removed {};
+
+    for (const auto* batch : { &older, &newer }) {
+        for (const auto& [peerId, origin] : batch->removedPeers)
+            removed.insert(peerId);
+        for (const auto& [key, p] : batch->peers)
+            all.insert(std::get<0>(key));
+    }
+
+    // a removal takes the id off only with the last of its peers
+    for (const auto& peerId : removed) {
+        if (findPeers(newer, older, peerId, 1).empty())
+            all.erase(peerId);
+    }
+
+    return std::vector<Id>(all.begin(), all.end());
+}
+
+} // namespace boson
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "boson/id.h"
+#include "boson/value.h"
+#include "boson/peer_info.h"
+#include "data_storage.h"
+#include "utils/log.h"
+
+namespace boson {
+
+/*
+ * Keeps the disk I/O of the stored values and peers off the rx thread.
+ *
+ * putValue() and putPeer() only record the write in an in-memory overlay and
+ * return, an executor thread commits the overlay to the backend in a single
+ * transaction once COMMIT_BATCH_SIZE records are queued or COMMIT_INTERVAL
+ * expired (group commit). Repeated writes of the same record are coalesced
+ * into one, and the reads look into the overlay before the backend, so the
+ * records are visible as soon as they are put. Removals and announce updates
+ * are queued the same way, and the listings replay the overlay on the backend's
+ * answer, so no caller but flush() and close() waits for a commit. A batch the
+ * backend fails to commit goes back to the overlay and is retried.
+ *
+ * The overlay lock is never held while the backend is read: a read takes what
+ * the overlay has for its records under the lock, then asks the backend and
+ * merges the two, so a lookup never queues behind another thread's disk read.
+ */
+class WriteBehindStorage final : public DataStorage {
+public:
+    WriteBehindStorage(Sp<DataStorage> backend, int commitInterval, int commitBatchSize);
+    explicit WriteBehindStorage(Sp<DataStorage> backend);
+    ~WriteBehindStorage();
+
+    WriteBehindStorage(const WriteBehindStorage&) = delete;
+    WriteBehindStorage& operator=(const WriteBehindStorage&) = delete;
+
+    void close() override;
+
+    using DataStorage::putValue;
+    using DataStorage::putPeer;
+
+    Sp<Value> getValue(const Id& valueId) override;
+    bool removeValue(const Id& valueId) override;
+    Sp<Value> putValue(const Value& value, int expectedSeq = -1, bool persistent = false, bool updateLastAnnounce = false) override;
+    void updateValueLastAnnounce(const Id& valueId) override;
+    std::vector<Value> getPersistentValues(uint64_t lastAnnounceBefore) override;
+    std::vector<Id> getAllValues() override;
+
+    std::vector<PeerInfo> getPeer(const Id& peerId, int maxPeers) override;
+    Sp<PeerInfo> getPeer(const Id& peerId, const Id& origin) override;
+    bool removePeer(const Id& peerId, const Id& origin) override;
+    void putPeer(const std::vector<PeerInfo>& peers) override;
+    void putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) override;
+    void updatePeerLastAnnounce(const Id& peerId, const Id& origin) override;
+    std::vector<PeerInfo> getPersistentPeers(uint64_t lastAnnounceBefore) override;
+    std::vector<Id> getAllPeers() override;
+
+    Sp<Value> loadValue(const Id& valueId, uint64_t& expiration) override;
+    std::vector<PeerInfo> loadPeers(const Id& peerId, int maxPeers, uint64_t& expiration) override;
+
+    // Commits the queued writes on the calling thread, throws if the backend
+    // fails, the records then stay queued for the next commit
+    void flush();
+
+    // Records waiting for the next commit
+    size_t getQueueDepth() const;
+
+    uint64_t getCommits() const {
+        return commits;
+    }
+
+    // Microseconds taken by the last commit
+    uint64_t getLastCommitLatency() const {
+        return lastCommitLatency;
+    }
+
+    // Microseconds taken by a commit on average
+    uint64_t getAverageCommitLatency() const {
+        uint64_t n = commits;
+        return n ? totalCommitLatency / n : 0;
+    }
+
+    std::string toString() const override;
+
+private:
+    struct PendingValue {
+        Value value;
+        bool persistent;
+        bool updateLastAnnounce;
+    };
+
+    struct PendingPeer {
+        PeerInfo peer;
+        bool persistent;
+        bool updateLastAnnounce;
+    };
+
+    // id, nodeId, origin: the primary key of a peer
+    using PeerKey = std::tuple<Id, Id, Id>;
+    // id, origin: the peers a removal or an announce update applies to
+    using PeerOrigin = std::pair<Id, Id>;
+
+    // Committed as the removals, the puts, then the announce updates. A removal
+    // drops the earlier puts and announce updates of its records from the batch,
+    // so a put next to a removal of the same record is always the newer one.
+    struct Batch {
+        std::map<Id, PendingValue> values {};
+        std::map<PeerKey, PendingPeer> peers {};
+        std::set<Id> removedValues {};
+        std::set<PeerOrigin> removedPeers {};
+        std::set<Id> announcedValues {};
+        std::set<PeerOrigin> announcedPeers {};
+
+        size_t size() const {
+            return values.size() + peers.size() + removedValues.size() + removedPeers.size() +
+                    announcedValues.size() + announcedPeers.size();
+        }
+        bool empty() const {
+            return size() == 0;
+        }
+    };
+
+    void run();
+    // Require lock: the overlay's answer, found or removed, or nullopt when it
+    // is up to the backend. The backend is only read with the lock released.
+    std::optional<Sp<Value>> findValue(const Id& valueId) const;
+    std::optional<Sp<PeerInfo>> findPeer(const Id& peerId, const Id& origin) const;
+    // Requires lock, the overlay records of a peer id, to be merged out of the lock
+    static Batch slicePeers(const Batch& batch, const Id& peerId);
+    // Merges the overlay batches, the newer first, with the backend's peers
+    std::vector<PeerInfo> findPeers(const Batch& newer, const Batch& older, const Id& peerId,
+            int maxPeers, uint64_t* expiration = nullptr);
+    void enqueue(const PeerInfo& peer, bool persistent, bool updateLastAnnounce);
+    // Requires writeLock, throws after putting a failed batch back
+    void commit();
+    // Requires lock, merges the failed committing batch into pending
+    void requeue();
+
+    Sp<DataStorage> backend;
+    const std::chrono::milliseconds commitInterval;
+    const size_t commitBatchSize;
+
+    // the writes not yet handed to the backend
+    Batch pending {};
+    // the writes the backend is committing, still served from memory
+    Batch committing {};
+    // bumped by every queued value put or removal, a put checked against the
+    // backend out of the lock only goes in when nothing moved meanwhile
+    uint64_t valueWrites {0};
+    // never held while the backend is read or written
+    mutable std::mutex lock {};
+    std::condition_variable ready {};
+
+    // serializes the commits
+    std::mutex writeLock {};
+    std::thread executor {};
+    bool running {false};
+    bool closed {false};
+
+    std::atomic<uint64_t> commits {0};
+    std::atomic<uint64_t> lastCommitLatency {0};
+    std::atomic<uint64_t> totalCommitLatency {0};
+
+    Sp<Logger> log;
+};
+
+} // namespace boson
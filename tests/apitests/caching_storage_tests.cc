@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <sqlite3.h>
+#include <boson.h>
+
+#include "constants.h"
+#include "utils/time.h"
+#include "sqlite_storage.h"
+#include "caching_storage.h"
+#include "utils.h"
+#include "caching_storage_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(CachingStorageTests);
+
+static const size_t CAPACITY = 1024 * 1024;
+static const int TTL = 60 * 1000;
+
+void CachingStorageTests::setUp() {
+    path = Utils::getPwdStorage("apitests.db");
+}
+
+void CachingStorageTests::tearDown() {
+    Utils::removeStorage(path);
+}
+
+void CachingStorageTests::testValues() {
+    CachingStorage storage(SqliteStorage::open(path, scheduler), CAPACITY, TTL);
+
+    std::string str = "Hello, world";
+    auto signedValue = Value::createSignedValue(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    auto valueId = signedValue.getId();
+    storage.putValue(signedValue, 0);
+
+    auto value = storage.getValue(valueId);
+    CPPUNIT_ASSERT(value);
+    CPPUNIT_ASSERT(*value == signedValue);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, storage.getHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getMisses());
+
+    value = storage.getValue(valueId);
+    CPPUNIT_ASSERT(*value == signedValue);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getHits());
+    CPPUNIT_ASSERT(storage.getMemoryUsage() > signedValue.getData().size());
+
+    // an update drops the cached value
+    str = "Hello, world2";
+    auto updated = signedValue.update(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    storage.putValue(updated, 0);
+    value = storage.getValue(valueId);
+    CPPUNIT_ASSERT(*value == updated);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, storage.getMisses());
+
+    // a failed update leaves it alone
+    CPPUNIT_ASSERT_THROW(storage.putValue(signedValue, 10), std::invalid_argument);
+    CPPUNIT_ASSERT(*storage.getValue(valueId) == updated);
+
+    CPPUNIT_ASSERT(storage.removeValue(valueId));
+    CPPUNIT_ASSERT(!storage.getValue(valueId));
+
+    storage.close();
+}
+
+void CachingStorageTests::testMissingValues() {
+    CachingStorage storage(SqliteStorage::open(path, scheduler), CAPACITY, TTL);
+
+    auto value = Value::createValue(Utils::getRandomData(64));
+    CPPUNIT_ASSERT(!storage.getValue(value.getId()));
+    CPPUNIT_ASSERT(!storage.getValue(value.getId()));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getMisses());
+
+    storage.putValue(value);
+    auto stored = storage.getValue(value.getId());
+    CPPUNIT_ASSERT(stored);
+    CPPUNIT_ASSERT(*stored == value);
+
+    storage.close();
+}
+
+void CachingStorageTests::testPeers() {
+    CachingStorage storage(SqliteStorage::open(path, scheduler), CAPACITY, TTL);
+
+    auto keypair = Signature::KeyPair::random();
+    auto peerId = Id(keypair.publicKey());
+
+    CPPUNIT_ASSERT(storage.getPeer(peerId, 8).empty());
+    CPPUNIT_ASSERT(storage.getPeer(peerId, 8).empty());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getHits());
+
+    std::vector<PeerInfo> peers {};
+    for (int i = 0; i < 8; i++)
+        peers.push_back(PeerInfo::create(keypair, Id::random(), Id::random(), 8000 + i));
+    storage.putPeer(peers);
+
+    // the writes went into the cached set, it is still the whole set and
+    // serves any size
+    CPPUNIT_ASSERT_EQUAL((size_t)4, storage.getPeer(peerId, 4).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)2, storage.getPeer(peerId, 2).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPeer(peerId, 16).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPeer(peerId, 0).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)5, storage.getHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getMisses());
+
+    // and every lookup draws its own sample
+    std::set<Id> seen {};
+    for (int i = 0; i < 32; i++) {
+        for (const auto& peer : storage.getPeer(peerId, 2))
+            seen.insert(peer.getOrigin());
+    }
+    CPPUNIT_ASSERT(seen.size() > 2);
+
+    // announced again, or anew, and removed, all without a reload
+    peers[1] = PeerInfo::create(keypair, peers[1].getNodeId(), peers[1].getOrigin(), 7000);
+    storage.putPeer(peers[1]);
+    storage.putPeer(PeerInfo::create(keypair, Id::random(), Id::random(), 9000));
+    storage.updatePeerLastAnnounce(peerId, peers[2].getOrigin());
+    auto all = storage.getPeer(peerId, 16);
+    CPPUNIT_ASSERT_EQUAL((size_t)9, all.size());
+    CPPUNIT_ASSERT(std::any_of(all.begin(), all.end(), [](const PeerInfo& p) { return p.getPort() == 7000; }));
+
+    CPPUNIT_ASSERT(storage.removePeer(peerId, peers[0].getOrigin()));
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPeer(peerId, 16).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getMisses());
+
+    storage.close();
+}
+
+void CachingStorageTests::testBoundedPeerSample() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    CachingStorage storage(backend, CAPACITY, TTL);
+
+    auto keypair = Signature::KeyPair::random();
+    auto peerId = Id(keypair.publicKey());
+    for (int i = 0; i < 64; i++)
+        backend->putPeer(PeerInfo::create(keypair, Id::random(), Id::random(), 8000 + i));
+
+    // loads and keeps 4 times what is asked for, not the whole set
+    CPPUNIT_ASSERT_EQUAL((size_t)4, storage.getPeer(peerId, 4).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)4, storage.getPeer(peerId, 4).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)2, storage.getPeer(peerId, 2).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, storage.getHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getMisses());
+
+    // too small a sample for a larger lookup
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPeer(peerId, 8).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, storage.getMisses());
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPeer(peerId, 8).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, storage.getHits());
+
+    // a new peer takes a place in the sample, which stays bounded
+    auto usage = storage.getMemoryUsage();
+    storage.putPeer(PeerInfo::create(keypair, Id::random(), Id::random(), 9000));
+    CPPUNIT_ASSERT_EQUAL(usage, storage.getMemoryUsage());
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPeer(peerId, 8).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, storage.getMisses());
+
+    storage.close();
+
+    // a set too large for the cache is served, but not kept
+    CachingStorage small(SqliteStorage::open(path, scheduler), 4096, TTL);
+    CPPUNIT_ASSERT_EQUAL((size_t)65, small.getPeer(peerId, 0).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)65, small.getPeer(peerId, 0).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, small.getMisses());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, small.getOversized());
+    CPPUNIT_ASSERT_EQUAL((size_t)0, small.size());
+
+    small.close();
+}
+
+void CachingStorageTests::testCapacityAndTtl() {
+    const size_t capacity = 64 * 1024;
+    CachingStorage storage(SqliteStorage::open(path, scheduler), capacity, 200);
+
+    std::vector<Value> values {};
+    for (int i = 0; i < 256; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(1024)));
+        storage.putValue(values.back());
+        storage.getValue(values.back().getId());
+    }
+
+    CPPUNIT_ASSERT(storage.getEvictions() > 0);
+    CPPUNIT_ASSERT(storage.getMemoryUsage() <= capacity);
+    CPPUNIT_ASSERT(storage.size() < values.size());
+
+    // the most recent one is still there
+    auto hits = storage.getHits();
+    CPPUNIT_ASSERT(storage.getValue(values.back().getId()));
+    CPPUNIT_ASSERT_EQUAL(hits + 1, storage.getHits());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    auto misses = storage.getMisses();
+    CPPUNIT_ASSERT(storage.getValue(values.back().getId()));
+    CPPUNIT_ASSERT_EQUAL(misses + 1, storage.getMisses());
+
+    storage.close();
+}
+
+void CachingStorageTests::testRecordAgeLimit() {
+    CachingStorage storage(SqliteStorage::open(path, scheduler), CAPACITY, TTL);
+
+    auto value = Value::createValue(Utils::getRandomData(64));
+    storage.putValue(value);
+
+    auto keypair = Signature::KeyPair::random();
+    auto peer = PeerInfo::create(keypair, Id::random(), Id::random(), 8000);
+    storage.putPeer(peer);
+
+    // both records age out of the backend in 200ms
+    sqlite3* db {nullptr};
+    sqlite3_open(path.c_str(), &db);
+    auto now = currentTimeMillis();
+    auto sql = "UPDATE valores SET timestamp = " + std::to_string(now - Constants::MAX_VALUE_AGE + 200) +
+            "; UPDATE peers SET timestamp = " + std::to_string(now - Constants::MAX_PEER_AGE + 200);
+    CPPUNIT_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db, sql.c_str(), 0, 0, 0));
+    sqlite3_close(db);
+
+    CPPUNIT_ASSERT(storage.getValue(value.getId()));
+    CPPUNIT_ASSERT_EQUAL((size_t)1, storage.getPeer(peer.getId(), 8).size());
+    CPPUNIT_ASSERT(storage.getValue(value.getId()));
+    CPPUNIT_ASSERT_EQUAL((size_t)1, storage.getPeer(peer.getId(), 8).size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, storage.getHits());
+
+    // gone from the cache with them, well within the ttl
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    CPPUNIT_ASSERT(!storage.getValue(value.getId()));
+    CPPUNIT_ASSERT(storage.getPeer(peer.getId(), 8).empty());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)4, storage.getMisses());
+
+    storage.close();
+}
+
+}  // namespace test
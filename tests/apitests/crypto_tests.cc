@@ -23,6 +23,8 @@
 
 #include <boson.h>
 #include "crypto_context.h"
+#include "packet_buffer.h"
+#include "messages/find_node_request.h"
 #include "crypto_tests.h"
 
 namespace test {
@@ -187,6 +189,45 @@ void CryptoTester::testCrytoContext()
     CPPUNIT_ASSERT(data1 == decrypted);
 }
 
+void CryptoTester::testPacketBuffer()
+{
+    auto senderKeyPair = CryptoBox::KeyPair();
+    auto receiverKeyPair = CryptoBox::KeyPair();
+
+    auto encryptContext = CryptoContext(senderKeyPair.publicKey(), receiverKeyPair);
+    auto decryptContext = CryptoContext(receiverKeyPair.publicKey(), senderKeyPair);
+
+    auto sender = Id::random();
+    FindNodeRequest msg(Id::random());
+    msg.setWant4(true);
+    msg.setTxid(0x76543210);
+    auto expected = msg.serialize();
+
+    PacketBufferPool pool {4, 64 * 1024};
+    for (int i = 0; i < 3; i++) {
+        auto packet = pool.acquire();
+        CPPUNIT_ASSERT_EQUAL(PacketBuffer::HEADROOM, packet.size());
+
+        msg.serialize(packet);
+        CPPUNIT_ASSERT_EQUAL(PacketBuffer::HEADROOM + expected.size(), packet.size());
+        CPPUNIT_ASSERT(std::equal(expected.begin(), expected.end(), packet.plain().cbegin()));
+
+        // encrypt in place, then check against the plain datagram layout
+        auto plain = packet.plain();
+        auto cipher = packet.cipher();
+        encryptContext.encrypt(cipher, plain);
+        packet.setSender(sender);
+
+        CPPUNIT_ASSERT(std::equal(sender.cbegin(), sender.cend(), packet.bytes()));
+
+        auto decrypted = decryptContext.decrypt({packet.bytes() + ID_BYTES, packet.size() - ID_BYTES});
+        CPPUNIT_ASSERT(expected == decrypted);
+
+        pool.release(std::move(packet));
+        CPPUNIT_ASSERT_EQUAL((size_t)1, pool.size());
+    }
+}
+
 void CryptoTester::tearDown() {}
 
 }  // namespace test
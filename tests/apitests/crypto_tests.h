@@ -34,6 +34,7 @@ class CryptoTester : public CppUnit::TestFixture {
     CPPUNIT_TEST(testSignatrue);
     CPPUNIT_TEST(testPublicKey);
     CPPUNIT_TEST(testCrytoContext);
+    CPPUNIT_TEST(testPacketBuffer);
     CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -44,6 +45,7 @@ class CryptoTester : public CppUnit::TestFixture {
     void testSignatrue();
     void testPublicKey();
     void testCrytoContext();
+    void testPacketBuffer();
 };
 
 }  // namespace test
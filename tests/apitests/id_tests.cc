@@ -153,4 +153,59 @@ void IdTests::testBitsCopy() {
     }
 }
 
+void IdTests::testCompareKernels() {
+    auto bytesOf = [](const Id& id) {
+        std::array<uint8_t, ID_BYTES> b;
+        std::copy_n(id.data(), ID_BYTES, b.begin());
+        return b;
+    };
+
+    // Byte-wise reference of the XOR metric
+    auto referenceCompare = [&](const Id& target, const Id& id1, const Id& id2) {
+        auto t = bytesOf(target), a = bytesOf(id1), b = bytesOf(id2);
+        for (int i = 0; i < ID_BYTES; i++) {
+            if (a[i] != b[i])
+                return (a[i] ^ t[i]) < (b[i] ^ t[i]) ? -1 : 1;
+        }
+        return 0;
+    };
+
+    Id target = Id::random();
+    auto base = bytesOf(Id::random());
+
+    for (int i = 0; i < ID_BYTES; i++) {
+        for (int k = 0; k < 8; k++) {
+            uint8_t bit = 0x80 >> k;
+            auto flipped = base;
+            flipped[i] ^= bit;
+            Id id1(base), id2(flipped);
+
+            CPPUNIT_ASSERT_EQUAL(referenceCompare(target, id1, id2), target.threeWayCompare(id1, id2));
+            CPPUNIT_ASSERT_EQUAL(referenceCompare(target, id2, id1), target.threeWayCompare(id2, id1));
+            CPPUNIT_ASSERT_EQUAL(0, target.threeWayCompare(id1, Id(base)));
+
+            CPPUNIT_ASSERT((id1 < id2) == (base < flipped));
+            CPPUNIT_ASSERT((id2 < id1) == (flipped < base));
+            CPPUNIT_ASSERT(!(id1 < Id(base)));
+
+            auto d = bytesOf(Id::distance(id1, id2));
+            for (int j = 0; j < ID_BYTES; j++)
+                CPPUNIT_ASSERT_EQUAL(j == i ? bit : (uint8_t)0, d[j]);
+
+            int bitIndex = i * 8 + k;
+            CPPUNIT_ASSERT(Id::bitsEqual(id1, id2, bitIndex - 1));
+            CPPUNIT_ASSERT(!Id::bitsEqual(id1, id2, bitIndex));
+        }
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        Id id1 = Id::random();
+        Id id2 = Id::random();
+
+        CPPUNIT_ASSERT_EQUAL(referenceCompare(target, id1, id2), target.threeWayCompare(id1, id2));
+        CPPUNIT_ASSERT((id1 < id2) == (bytesOf(id1) < bytesOf(id2)));
+        CPPUNIT_ASSERT(Id::distance(id1, id2).distance(id2) == id1);
+    }
+}
+
 }  // namespace test
@@ -42,6 +42,7 @@ class IdTests : public CppUnit::TestFixture {
     CPPUNIT_TEST(testThreeWayCompare);
     CPPUNIT_TEST(testBitsEqual);
     CPPUNIT_TEST(testBitsCopy);
+    CPPUNIT_TEST(testCompareKernels);
     CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -60,6 +61,7 @@ class IdTests : public CppUnit::TestFixture {
     void testThreeWayCompare();
     void testBitsEqual();
     void testBitsCopy();
+    void testCompareKernels();
 };
 
 }  // namespace test
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <boson.h>
+
+#include "constants.h"
+#include "kbucket.h"
+#include "kbucket_entry.h"
+#include "kbucket_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(KBucketTests);
+
+static Sp<KBucketEntry> makeEntry(int i, uint64_t created) {
+    KBucketEntry entry(Id::random(), SocketAddress("10.0.0." + std::to_string(i + 1), 39001));
+    auto json = entry.toJson();
+    json["created"] = created;
+    json["reachable"] = true;
+    return KBucketEntry::fromJson(json);
+}
+
+static void assertOrdered(const KBucket& bucket) {
+    const auto& entries = bucket.getEntries();
+    for (size_t i = 1; i < entries.size(); i++)
+        CPPUNIT_ASSERT(entries[i - 1]->getCreationTime() <= entries[i]->getCreationTime());
+
+    // every entry is found through the id index
+    for (const auto& entry : entries)
+        CPPUNIT_ASSERT(bucket.get(entry->getId()) == entry);
+}
+
+void KBucketTests::testPutAndGet() {
+    KBucket bucket(Prefix {}, true);
+    std::vector<Sp<KBucketEntry>> entries;
+    for (int i = 0; i < Constants::MAX_ENTRIES_PER_BUCKET; i++) {
+        entries.push_back(makeEntry(i, 1000 + i));
+        bucket._put(entries.back());
+    }
+
+    CPPUNIT_ASSERT(bucket.isFull());
+    CPPUNIT_ASSERT_EQUAL(Constants::MAX_ENTRIES_PER_BUCKET, bucket.size());
+    for (const auto& entry : entries) {
+        CPPUNIT_ASSERT(bucket.exists(entry->getId()));
+        CPPUNIT_ASSERT(bucket.get(entry->getId()) == entry);
+        CPPUNIT_ASSERT(bucket.find(Id::random(), entry->getAddress()) == entry);
+    }
+    CPPUNIT_ASSERT(bucket.get(Id::random()) == nullptr);
+    CPPUNIT_ASSERT(!bucket.exists(Id::random()));
+
+    // a younger entry does not fit into a full bucket of good entries
+    auto younger = makeEntry(100, 2000);
+    bucket._put(younger);
+    CPPUNIT_ASSERT_EQUAL(Constants::MAX_ENTRIES_PER_BUCKET, bucket.size());
+    CPPUNIT_ASSERT(!bucket.exists(younger->getId()));
+
+    // the same node again is merged into the existing entry
+    auto again = std::make_shared<KBucketEntry>(entries[3]->getId(), entries[3]->getAddress());
+    bucket._put(again);
+    CPPUNIT_ASSERT_EQUAL(Constants::MAX_ENTRIES_PER_BUCKET, bucket.size());
+    CPPUNIT_ASSERT(bucket.get(again->getId()) == entries[3]);
+    assertOrdered(bucket);
+}
+
+void KBucketTests::testCreationTimeOrder() {
+    KBucket bucket(Prefix {}, true);
+    std::vector<uint64_t> created {5000, 1000, 3000, 3000, 7000, 2000, 6000, 4000};
+    for (size_t i = 0; i < created.size(); i++)
+        bucket._put(makeEntry(i, created[i]));
+
+    CPPUNIT_ASSERT_EQUAL((int)created.size(), bucket.size());
+    assertOrdered(bucket);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1000), bucket.getEntries()[0]->getCreationTime());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(7000), bucket.getEntries().back()->getCreationTime());
+}
+
+void KBucketTests::testOlderEntryDisplacesYoungest() {
+    KBucket bucket(Prefix {}, true);
+    for (int i = 0; i < Constants::MAX_ENTRIES_PER_BUCKET; i++)
+        bucket._put(makeEntry(i, 1000 * (i + 1)));
+
+    auto youngest = bucket.getEntries().back();
+    auto older = makeEntry(100, 1500);
+    bucket._put(older);
+
+    CPPUNIT_ASSERT_EQUAL(Constants::MAX_ENTRIES_PER_BUCKET, bucket.size());
+    CPPUNIT_ASSERT(bucket.get(older->getId()) == older);
+    CPPUNIT_ASSERT(!bucket.exists(youngest->getId()));
+    CPPUNIT_ASSERT(bucket.getEntries()[1] == older);
+    assertOrdered(bucket);
+}
+
+void KBucketTests::testRemove() {
+    KBucket bucket(Prefix {}, true);
+    std::vector<Sp<KBucketEntry>> entries;
+    for (int i = 0; i < Constants::MAX_ENTRIES_PER_BUCKET; i++) {
+        entries.push_back(makeEntry(i, 1000 + i));
+        bucket._put(entries.back());
+    }
+
+    // good entries stay unless forced
+    bucket._removeIfBad(entries[2], false);
+    CPPUNIT_ASSERT(bucket.exists(entries[2]->getId()));
+
+    bucket._removeIfBad(entries[2], true);
+    bucket._removeIfBad(entries[0], true);
+    bucket._removeIfBad(entries.back(), true);
+    CPPUNIT_ASSERT_EQUAL(Constants::MAX_ENTRIES_PER_BUCKET - 3, bucket.size());
+    CPPUNIT_ASSERT(!bucket.exists(entries[0]->getId()));
+    CPPUNIT_ASSERT(!bucket.exists(entries[2]->getId()));
+    CPPUNIT_ASSERT(!bucket.exists(entries.back()->getId()));
+    CPPUNIT_ASSERT(entries[2].use_count() == 1);
+    assertOrdered(bucket);
+
+    // the freed slots are reused
+    auto entry = makeEntry(100, 500);
+    bucket._put(entry);
+    CPPUNIT_ASSERT(bucket.getEntries()[0] == entry);
+    assertOrdered(bucket);
+}
+
+}  // namespace test
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "utils/loading_cache.h"
+#include "loading_cache_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(LoadingCacheTests);
+
+// Move-only value: the cache must never copy it
+struct Payload {
+    explicit Payload(int v) : value(std::make_unique<int>(v)) {}
+    std::unique_ptr<int> value;
+};
+
+class TestCache : public LoadingCache<int, Payload> {
+public:
+    TestCache(size_t capacity, int ttl, size_t shards = 1)
+        : LoadingCache(capacity, ttl, shards) {}
+
+    std::atomic<int> loads {0};
+    std::atomic<int> removals {0};
+
+protected:
+    Payload load(const int& key) override {
+        loads++;
+        return Payload(key * 10);
+    }
+
+    void onRemoval(const Payload&) override {
+        removals++;
+    }
+};
+
+void LoadingCacheTests::testLoadAndHit() {
+    TestCache cache(64, 60000, 4);
+    CPPUNIT_ASSERT_EQUAL((size_t)64, cache.capacity());
+
+    auto v1 = cache.get(7);
+    CPPUNIT_ASSERT_EQUAL(70, *v1->value);
+    auto v2 = cache.get(7);
+    CPPUNIT_ASSERT(v1 == v2);
+
+    CPPUNIT_ASSERT_EQUAL(1, cache.loads.load());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getMisses());
+    CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+
+    CPPUNIT_ASSERT_THROW(TestCache(64, 1000, 3), std::invalid_argument);
+    CPPUNIT_ASSERT_THROW(TestCache(2, 1000, 4), std::invalid_argument);
+}
+
+void LoadingCacheTests::testClockEviction() {
+    TestCache cache(4, 60000);
+    for (int i = 0; i < 4; i++)
+        cache.get(i);
+
+    // Hot entries get the reference bit and survive the next sweep
+    cache.get(0);
+    cache.get(2);
+
+    auto held = cache.get(1);
+    cache.get(1);
+    cache.get(4);
+    CPPUNIT_ASSERT_EQUAL((size_t)4, cache.size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getEvictions());
+    CPPUNIT_ASSERT_EQUAL(1, cache.removals.load());
+
+    // 3 was the only entry not touched since it was loaded
+    auto loads = cache.loads.load();
+    cache.get(0);
+    cache.get(1);
+    cache.get(2);
+    cache.get(4);
+    CPPUNIT_ASSERT_EQUAL(loads, cache.loads.load());
+    cache.get(3);
+    CPPUNIT_ASSERT_EQUAL(loads + 1, cache.loads.load());
+
+    // Bounded no matter how many keys pass through
+    for (int i = 100; i < 1100; i++)
+        cache.get(i);
+    CPPUNIT_ASSERT_EQUAL((size_t)4, cache.size());
+
+    // An evicted value stays valid while it is still referenced
+    CPPUNIT_ASSERT_EQUAL(10, *held->value);
+}
+
+void LoadingCacheTests::testExpiration() {
+    TestCache cache(16, 0, 2);
+    for (int i = 0; i < 8; i++)
+        cache.get(i);
+    CPPUNIT_ASSERT_EQUAL((size_t)8, cache.size());
+
+    cache.handleExpiration();
+    CPPUNIT_ASSERT_EQUAL((size_t)0, cache.size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)8, cache.getExpirations());
+    CPPUNIT_ASSERT_EQUAL(8, cache.removals.load());
+
+    // Freed slots are reused
+    for (int i = 0; i < 8; i++)
+        cache.get(i);
+    CPPUNIT_ASSERT_EQUAL((size_t)8, cache.size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, cache.getEvictions());
+}
+
+void LoadingCacheTests::testConcurrentAccess() {
+    TestCache cache(256, 60000, 16);
+    std::atomic<int> errors {0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 20000; i++) {
+                int key = (i * 7 + t) % 512;
+                auto value = cache.get(key);
+                if (*value->value != key * 10)
+                    errors++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    CPPUNIT_ASSERT_EQUAL(0, errors.load());
+    CPPUNIT_ASSERT(cache.size() <= cache.capacity());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)80000, cache.getHits() + cache.getMisses());
+}
+
+}  // namespace test
@@ -46,6 +46,8 @@
 
 #include "utils.h"
 #include "utils/log.h"
+#include "utils/log_formatters.h"
+#include "messages/find_node_response.h"
 
 #include <boson.h>
 using namespace boson;
@@ -236,6 +238,33 @@ void LoggerTester::testConf() {
     log->info(name + " info test.");
 }
 
+void LoggerTester::testFormatters() {
+    auto id = Id::random();
+    CPPUNIT_ASSERT_EQUAL(id.toString(), fmt::format("{}", id));
+
+    SocketAddress addr("192.168.1.1", 39001);
+    CPPUNIT_ASSERT_EQUAL(addr.toString(), fmt::format("{}", addr));
+
+    auto node = std::make_shared<NodeInfo>(id, addr);
+    CPPUNIT_ASSERT_EQUAL(node->toString(), fmt::format("{}", *node));
+
+    // derived classes are formatted as their base
+    FindNodeResponse msg(0x1234);
+    msg.setNodes4(std::list<Sp<NodeInfo>> {node});
+    msg.setToken(0x5678);
+    const Message& base = msg;
+    CPPUNIT_ASSERT_EQUAL(base.toString(), fmt::format("{}", msg));
+    CPPUNIT_ASSERT_EQUAL("[" + base.toString() + "]", fmt::format("[{:<8}]", base));
+
+    auto log = Logger::get("testFormatters");
+    log->setLevel(Level::Info);
+    CPPUNIT_ASSERT(log->shouldLog(Level::Info));
+    CPPUNIT_ASSERT(log->shouldLog(Level::Error));
+    CPPUNIT_ASSERT(!log->shouldLog(Level::Debug));
+    log->debug("Skipped: {} {} {}", id, addr, msg);
+    log->info("Formatted: {} {} {}", id, addr, *node);
+}
+
 void
 LoggerTester::tearDown() {
 
@@ -34,6 +34,7 @@ class LoggerTester : public CppUnit::TestFixture {
     CPPUNIT_TEST(testNormal);
     CPPUNIT_TEST(testMacro);
     CPPUNIT_TEST(testConf);
+    CPPUNIT_TEST(testFormatters);
     CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -43,6 +44,7 @@ class LoggerTester : public CppUnit::TestFixture {
     void testNormal();
     void testMacro();
     void testConf();
+    void testFormatters();
 };
 
 }  // namespace test
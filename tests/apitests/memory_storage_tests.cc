@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boson.h>
+
+#include "constants.h"
+#include "memory_storage.h"
+#include "utils.h"
+#include "memory_storage_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(MemoryStorageTests);
+
+void MemoryStorageTests::testValues() {
+    MemoryStorage storage {};
+    std::vector<Value> values {};
+
+    for (int i = 0; i < 64; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+        storage.putValue(values.back(), i % 2 == 0);
+    }
+
+    for (const auto& value : values) {
+        auto stored = storage.getValue(value.getId());
+        CPPUNIT_ASSERT(stored);
+        CPPUNIT_ASSERT(*stored == value);
+    }
+
+    auto ids = storage.getAllValues();
+    CPPUNIT_ASSERT_EQUAL((size_t)64, ids.size());
+    CPPUNIT_ASSERT(std::is_sorted(ids.begin(), ids.end()));
+
+    CPPUNIT_ASSERT_EQUAL((size_t)32, storage.getPersistentValues(currentTimeMillis()).size());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto ts = currentTimeMillis();
+    for (int i = 0; i < 16; i++)
+        storage.updateValueLastAnnounce(values[i * 2].getId());
+    CPPUNIT_ASSERT_EQUAL((size_t)16, storage.getPersistentValues(ts - 1).size());
+
+    CPPUNIT_ASSERT(storage.removeValue(values[0].getId()));
+    CPPUNIT_ASSERT(!storage.getValue(values[0].getId()));
+    CPPUNIT_ASSERT(!storage.removeValue(values[0].getId()));
+    CPPUNIT_ASSERT_EQUAL((size_t)63, storage.getAllValues().size());
+
+    storage.close();
+    CPPUNIT_ASSERT(storage.getAllValues().empty());
+}
+
+void MemoryStorageTests::testUpdateSignedValue() {
+    MemoryStorage storage {};
+
+    std::string str = "Hello, world";
+    auto signedValue = Value::createSignedValue(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    auto valueId = signedValue.getId();
+    CPPUNIT_ASSERT(!storage.putValue(signedValue, 0));
+
+    // update: invalid sequence number
+    CPPUNIT_ASSERT_THROW(storage.putValue(signedValue, 10), std::invalid_argument);
+    CPPUNIT_ASSERT(*storage.getValue(valueId) == signedValue);
+
+    str = "Hello, world2";
+    auto updated = signedValue.update(std::vector<uint8_t>(str.cbegin(), str.cend()));
+
+    // update: CAS fail
+    CPPUNIT_ASSERT_THROW(storage.putValue(updated, 9), std::invalid_argument);
+
+    auto old = storage.putValue(updated, 0);
+    CPPUNIT_ASSERT(old);
+    CPPUNIT_ASSERT(*old == signedValue);
+    CPPUNIT_ASSERT(*storage.getValue(valueId) == updated);
+}
+
+void MemoryStorageTests::testPeers() {
+    MemoryStorage storage {};
+
+    auto keypair = Signature::KeyPair::random();
+    auto peerId = Id(keypair.publicKey());
+    std::vector<PeerInfo> peers {};
+    for (int i = 0; i < 32; i++)
+        peers.push_back(PeerInfo::create(keypair, Id::random(), Id::random(), 8000 + i));
+    storage.putPeer(peers);
+    storage.putPeer(peers[0]);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)32, storage.getPeer(peerId, 64).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)32, storage.getPeer(peerId, 0).size());
+
+    auto sample = storage.getPeer(peerId, 8);
+    CPPUNIT_ASSERT_EQUAL((size_t)8, sample.size());
+    std::set<int> ports {};
+    for (const auto& peer : sample)
+        ports.insert(peer.getPort());
+    CPPUNIT_ASSERT_EQUAL((size_t)8, ports.size());
+
+    auto peer = storage.getPeer(peerId, peers[5].getOrigin());
+    CPPUNIT_ASSERT(peer);
+    CPPUNIT_ASSERT(*peer == peers[5]);
+    CPPUNIT_ASSERT(!storage.getPeer(peerId, Id::random()));
+    CPPUNIT_ASSERT(storage.getPeer(Id::random(), 8).empty());
+
+    CPPUNIT_ASSERT(storage.removePeer(peerId, peers[5].getOrigin()));
+    CPPUNIT_ASSERT(!storage.getPeer(peerId, peers[5].getOrigin()));
+    CPPUNIT_ASSERT(!storage.removePeer(peerId, peers[5].getOrigin()));
+    CPPUNIT_ASSERT_EQUAL((size_t)31, storage.getPeer(peerId, 64).size());
+
+    auto ts = currentTimeMillis();
+    storage.putPeer(peers[6], true);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, storage.getPersistentPeers(ts).size());
+    storage.updatePeerLastAnnounce(peerId, peers[6].getOrigin());
+    CPPUNIT_ASSERT(storage.getPersistentPeers(ts - 1).empty());
+
+    auto other = PeerInfo::create(Id::random(), 9000);
+    storage.putPeer(other);
+    auto ids = storage.getAllPeers();
+    CPPUNIT_ASSERT_EQUAL((size_t)2, ids.size());
+    CPPUNIT_ASSERT(std::is_sorted(ids.begin(), ids.end()));
+}
+
+void MemoryStorageTests::testExpire() {
+    MemoryStorage storage {};
+
+    std::vector<Value> values {};
+    for (int i = 0; i < 16; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(64)));
+        storage.putValue(values.back(), i < 4);
+    }
+
+    std::vector<PeerInfo> peers {};
+    for (int i = 0; i < 16; i++) {
+        peers.push_back(PeerInfo::create(Id::random(), 8000 + i));
+        storage.putPeer(peers.back(), i < 2);
+    }
+
+    auto now = currentTimeMillis();
+    CPPUNIT_ASSERT_EQUAL((size_t)0, storage.expire(now));
+
+    // becoming persistent takes a peer out of the expiry index
+    storage.putPeer(peers[2], true);
+
+    auto later = currentTimeMillis() + std::max(Constants::MAX_VALUE_AGE, Constants::MAX_PEER_AGE) + 1;
+    CPPUNIT_ASSERT_EQUAL((size_t)(12 + 13), storage.expire(later));
+    CPPUNIT_ASSERT_EQUAL((size_t)0, storage.expire(later));
+
+    CPPUNIT_ASSERT(storage.getValue(values[0].getId()));
+    CPPUNIT_ASSERT(!storage.getValue(values[4].getId()));
+    CPPUNIT_ASSERT_EQUAL((size_t)4, storage.getPersistentValues(later).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)3, storage.getPersistentPeers(later).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)3, storage.getAllPeers().size());
+}
+
+void MemoryStorageTests::testOpenAndClose() {
+    Scheduler scheduler {};
+
+    // the expire job doesn't keep the storage alive
+    auto storage = MemoryStorage::open(scheduler);
+    std::weak_ptr<DataStorage> ref = storage;
+    storage.reset();
+    CPPUNIT_ASSERT(ref.expired());
+    scheduler.syncTime();
+    scheduler.run();
+
+    // and close() takes it off the scheduler
+    Scheduler other {};
+    storage = MemoryStorage::open(other);
+    CPPUNIT_ASSERT(other.getNextJobTime() != std::numeric_limits<uint64_t>::max());
+    storage->close();
+    CPPUNIT_ASSERT_EQUAL(std::numeric_limits<uint64_t>::max(), other.getNextJobTime());
+}
+
+}  // namespace test
@@ -0,0 +1,549 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <list>
+#include <random>
+#include <limits>
+#include <algorithm>
+
+#include "boson/node_info.h"
+#include "boson/peer_info.h"
+#include "boson/value.h"
+#include "messages/message.h"
+#include "messages/message_error.h"
+#include "messages/cbor.h"
+#include "messages/ping_request.h"
+#include "messages/ping_response.h"
+#include "messages/find_node_request.h"
+#include "messages/find_node_response.h"
+#include "messages/find_value_request.h"
+#include "messages/find_value_response.h"
+#include "messages/find_peer_request.h"
+#include "messages/find_peer_response.h"
+#include "messages/store_value_request.h"
+#include "messages/announce_peer_request.h"
+#include "messages/error_message.h"
+#include "serializers.h"
+
+#include "utils.h"
+#include "cbor_codec_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(CborCodecTests);
+
+namespace {
+
+// Fixed seed, failures must be reproducible
+std::mt19937 rng(0x626f736f);
+
+int randomInt(int min, int max) {
+    return std::uniform_int_distribution<int>(min, max)(rng);
+}
+
+bool randomBool() {
+    return randomInt(0, 1) == 1;
+}
+
+std::vector<uint8_t> randomBytes(size_t length) {
+    std::vector<uint8_t> data(length);
+    for (auto& b : data)
+        b = static_cast<uint8_t>(randomInt(0, 255));
+    return data;
+}
+
+std::string randomString(size_t length) {
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789:/.-";
+    std::string str;
+    for (size_t i = 0; i < length; i++)
+        str.push_back(chars[randomInt(0, sizeof(chars) - 2)]);
+    return str;
+}
+
+std::list<Sp<NodeInfo>> randomNodes(bool ipv6) {
+    std::list<Sp<NodeInfo>> nodes;
+    int count = randomInt(0, 8);
+    for (int i = 0; i < count; i++) {
+        std::string ip;
+        if (ipv6) {
+            std::stringstream ss;
+            ss << std::hex;
+            for (int g = 0; g < 8; g++)
+                ss << (g == 0 ? "" : ":") << randomInt(0, 0xFFFF);
+            ip = ss.str();
+        } else {
+            ip = std::to_string(randomInt(1, 254)) + "." + std::to_string(randomInt(0, 255)) + "."
+                + std::to_string(randomInt(0, 255)) + "." + std::to_string(randomInt(1, 254));
+        }
+        nodes.push_back(std::make_shared<NodeInfo>(Id::random(), ip, randomInt(1, 65535)));
+    }
+    return nodes;
+}
+
+Value randomValue() {
+    auto data = randomBytes(randomInt(0, 3) == 0 ? randomInt(256, 2048) : randomInt(1, 64));
+    switch (randomInt(0, 2)) {
+    case 0:
+        return Value::createValue(data);
+    case 1:
+        return Value::createSignedValue(Signature::KeyPair::random(), CryptoBox::Nonce::random(),
+                randomInt(0, 65535), data);
+    default:
+        return Value::createEncryptedValue(Signature::KeyPair::random(), Id(Signature::KeyPair::random().publicKey()),
+                CryptoBox::Nonce::random(), randomInt(0, 65535), data);
+    }
+}
+
+void randomizeHeader(Message& msg) {
+    msg.setTxid(randomInt(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()));
+    msg.setVersion(randomBool() ? 0 : randomInt(0, std::numeric_limits<int>::max()));
+}
+
+// The document the nlohmann::json based codec built for a message
+nlohmann::json legacyRoot(const Message& msg) {
+    nlohmann::json root = nlohmann::json::object();
+    root["y"] = static_cast<int>(msg.getType()) | static_cast<int>(msg.getMethod());
+    root["t"] = msg.getTxid();
+    root["v"] = msg.getVersion();
+    return root;
+}
+
+nlohmann::json legacyNodes(const std::list<Sp<NodeInfo>>& nodes) {
+    nlohmann::json json;
+    for (const auto& node : nodes)
+        json.push_back(*node);
+    return json;
+}
+
+void legacyLookupResponse(nlohmann::json& object, const std::list<Sp<NodeInfo>>& nodes4,
+        const std::list<Sp<NodeInfo>>& nodes6, int token) {
+    if (!nodes4.empty())
+        object["n4"] = legacyNodes(nodes4);
+    if (!nodes6.empty())
+        object["n6"] = legacyNodes(nodes6);
+    if (token != 0)
+        object["tok"] = token;
+}
+
+void legacyValue(nlohmann::json& object, const Value& value) {
+    if (value.isMutable()) {
+        object["k"] = value.getPublicKey();
+        if (value.isEncrypted())
+            object["rec"] = value.getRecipient();
+        object["n"] = nlohmann::json::binary_t {{value.getNonce().cbegin(), value.getNonce().cend()}};
+        if (value.getSequenceNumber() >= 0)
+            object["seq"] = value.getSequenceNumber();
+        object["sig"] = nlohmann::json::binary_t {value.getSignature()};
+    }
+}
+
+struct Sample {
+    Sp<Message> message;
+    nlohmann::json legacy;
+};
+
+Sample randomMessage(int kind) {
+    Sample sample;
+    int token = randomBool() ? 0 : randomInt(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+
+    switch (kind) {
+    case 0: {
+        auto msg = std::make_shared<PingRequest>();
+        randomizeHeader(*msg);
+        sample = { msg, legacyRoot(*msg) };
+        break;
+    }
+    case 1: {
+        auto msg = std::make_shared<PingResponse>(0);
+        randomizeHeader(*msg);
+        sample = { msg, legacyRoot(*msg) };
+        break;
+    }
+    case 2:
+    case 4:
+    case 6: {
+        auto target = Id::random();
+        bool wantToken = kind != 2 || randomBool();
+        Sp<LookupRequest> msg;
+        int seq = -1;
+        if (kind == 2) {
+            msg = std::make_shared<FindNodeRequest>(target, wantToken);
+        } else if (kind == 4) {
+            auto fv = std::make_shared<FindValueRequest>(target);
+            seq = randomBool() ? -1 : randomInt(0, std::numeric_limits<int>::max());
+            fv->setSequenceNumber(seq);
+            msg = fv;
+        } else {
+            msg = std::make_shared<FindPeerRequest>(target);
+        }
+        msg->setWant4(randomBool());
+        msg->setWant6(randomBool());
+        randomizeHeader(*msg);
+
+        auto root = legacyRoot(*msg);
+        nlohmann::json object = {
+            {"t", target},
+            {"w", (msg->doesWant4() ? 0x01 : 0) | (msg->doesWant6() ? 0x02 : 0) | (wantToken ? 0x04 : 0)}
+        };
+        if (seq >= 0)
+            object["seq"] = seq;
+        root["q"] = object;
+        sample = { msg, root };
+        break;
+    }
+    case 3:
+    case 5:
+    case 7: {
+        auto nodes4 = randomNodes(false);
+        auto nodes6 = randomNodes(true);
+        Sp<LookupResponse> msg;
+        auto object = nlohmann::json::object();
+        legacyLookupResponse(object, nodes4, nodes6, token);
+
+        if (kind == 3) {
+            msg = std::make_shared<FindNodeResponse>(0);
+        } else if (kind == 5) {
+            auto fv = std::make_shared<FindValueResponse>(0);
+            if (randomBool()) {
+                auto value = randomValue();
+                fv->setValue(value);
+                legacyValue(object, value);
+                object["v"] = nlohmann::json::binary_t {value.getData()};
+            }
+            msg = fv;
+        } else {
+            auto fp = std::make_shared<FindPeerResponse>(0);
+            auto keypair = Signature::KeyPair::random();
+            std::vector<PeerInfo> peers;
+            int count = randomInt(0, 4);
+            for (int i = 0; i < count; i++) {
+                auto nodeId = Id::random();
+                int port = randomInt(1, 65535);
+                auto alt = randomBool() ? std::string() : "http://" + randomString(randomInt(1, 40));
+                if (randomBool())
+                    peers.push_back(PeerInfo::create(keypair, nodeId, Id::random(), port, alt));
+                else
+                    peers.push_back(PeerInfo::create(keypair, nodeId, port, alt));
+            }
+            fp->setPeers(peers);
+
+            if (!peers.empty()) {
+                auto array = nlohmann::json::array();
+                array.push_back(peers.front().getId());
+                for (const auto& peer : peers) {
+                    auto ar = nlohmann::json::array();
+                    ar.push_back(peer.getNodeId());
+                    if (peer.isDelegated())
+                        ar.push_back(peer.getOrigin());
+                    else
+                        ar.push_back(nullptr);
+                    ar.push_back(peer.getPort());
+                    if (peer.hasAlternativeURL())
+                        ar.push_back(peer.getAlternativeURL());
+                    else
+                        ar.push_back(nullptr);
+                    ar.push_back(nlohmann::json::binary_t(peer.getSignature()));
+                    array.push_back(ar);
+                }
+                object["p"] = array;
+            }
+            msg = fp;
+        }
+
+        msg->setNodes4(nodes4);
+        msg->setNodes6(nodes6);
+        msg->setToken(token);
+        randomizeHeader(*msg);
+
+        auto root = legacyRoot(*msg);
+        root["r"] = object;
+        sample = { msg, root };
+        break;
+    }
+    case 8: {
+        auto value = randomValue();
+        auto msg = std::make_shared<StoreValueRequest>(value, token);
+        int cas = -1;
+        if (value.isMutable() && randomBool()) {
+            cas = randomInt(0, 65535);
+            msg->setExpectedSequenceNumber(cas);
+        }
+        randomizeHeader(*msg);
+
+        auto object = nlohmann::json::object();
+        object["tok"] = token;
+        legacyValue(object, value);
+        if (cas >= 0)
+            object["cas"] = cas;
+        object["v"] = nlohmann::json::binary_t {value.getData()};
+
+        auto root = legacyRoot(*msg);
+        root["q"] = object;
+        sample = { msg, root };
+        break;
+    }
+    case 9: {
+        auto nodeId = Id::random();
+        int port = randomInt(1, 65535);
+        auto alt = randomBool() ? std::string() : "http://" + randomString(randomInt(1, 40));
+        auto peer = randomBool() ? PeerInfo::create(nodeId, Id::random(), port, alt)
+                : PeerInfo::create(nodeId, port, alt);
+        auto msg = std::make_shared<AnnouncePeerRequest>(peer, token);
+        randomizeHeader(*msg);
+
+        nlohmann::json object = {
+            {"tok", token},
+            {"t", peer.getId()},
+            {"p", peer.getPort()},
+            {"sig", nlohmann::json::binary_t {peer.getSignature()}}
+        };
+        if (peer.isDelegated())
+            object["x"] = peer.getNodeId();
+        if (peer.hasAlternativeURL())
+            object["alt"] = peer.getAlternativeURL();
+
+        auto root = legacyRoot(*msg);
+        root["q"] = object;
+        sample = { msg, root };
+        break;
+    }
+    default: {
+        auto method = Message::Method::valueOf(randomInt(1, 6));
+        int code = randomInt(-1, 65535);
+        auto text = randomString(randomInt(0, 300));
+        auto msg = std::make_shared<ErrorMessage>(method, 0, code, text);
+        randomizeHeader(*msg);
+
+        auto root = legacyRoot(*msg);
+        root["e"] = { {"c", code}, {"m", text} };
+        sample = { msg, root };
+        break;
+    }
+    }
+
+    return sample;
+}
+
+const int MESSAGE_KINDS = 11;
+
+// Re-encode a document with indefinite-length containers, chunked strings and reversed map keys
+void encodeIndefinite(const nlohmann::json& json, std::vector<uint8_t>& out) {
+    auto chunked = [&](uint8_t initial, const nlohmann::json& first, const nlohmann::json& second) {
+        out.push_back(initial);
+        nlohmann::json::to_cbor(first, out);
+        nlohmann::json::to_cbor(second, out);
+        out.push_back(0xFF);
+    };
+
+    if (json.is_object()) {
+        std::vector<std::pair<std::string, const nlohmann::json*>> items;
+        for (const auto& [key, value] : json.items())
+            items.emplace_back(key, &value);
+        std::reverse(items.begin(), items.end());
+
+        out.push_back(0xBF);
+        for (const auto& [key, value] : items) {
+            nlohmann::json::to_cbor(nlohmann::json(key), out);
+            encodeIndefinite(*value, out);
+        }
+        out.push_back(0xFF);
+    } else if (json.is_array()) {
+        out.push_back(0x9F);
+        for (const auto& value : json)
+            encodeIndefinite(value, out);
+        out.push_back(0xFF);
+    } else if (json.is_binary()) {
+        const auto& bin = json.get_binary();
+        auto middle = bin.begin() + bin.size() / 2;
+        chunked(0x5F, nlohmann::json::binary_t {std::vector<uint8_t>(bin.begin(), middle)},
+                nlohmann::json::binary_t {std::vector<uint8_t>(middle, bin.end())});
+    } else if (json.is_string()) {
+        const auto& str = json.get_ref<const std::string&>();
+        chunked(0x7F, str.substr(0, str.size() / 2), str.substr(str.size() / 2));
+    } else {
+        nlohmann::json::to_cbor(json, out);
+    }
+}
+
+} // namespace
+
+void CborCodecTests::testWriterPrimitives() {
+    std::vector<int64_t> integers {
+        0, 1, 23, 24, 255, 256, 65535, 65536, 4294967295LL, 4294967296LL,
+        std::numeric_limits<int64_t>::max(), -1, -24, -25, -256, -257, -65536, -65537,
+        -4294967296LL, -4294967297LL, std::numeric_limits<int64_t>::min()
+    };
+    std::vector<size_t> lengths { 0, 1, 23, 24, 255, 256, 65535, 65536 };
+
+    auto expected = nlohmann::json::array();
+    std::vector<uint8_t> out;
+    CborWriter writer(out);
+    writer.beginArray(integers.size() + lengths.size() * 2 + 1);
+
+    for (auto i : integers) {
+        expected.push_back(i);
+        writer.writeInt(i);
+    }
+
+    for (auto length : lengths) {
+        auto bytes = randomBytes(length);
+        auto str = randomString(length);
+        expected.push_back(nlohmann::json::binary_t {bytes});
+        expected.push_back(str);
+        writer.writeBytes(bytes);
+        writer.writeString(str);
+    }
+
+    expected.push_back(nullptr);
+    writer.writeNull();
+
+    CPPUNIT_ASSERT(out == nlohmann::json::to_cbor(expected));
+
+    std::vector<uint8_t> decoded;
+    CborReader reader(out.data(), out.size());
+    size_t index = 0;
+    reader.readArray([&]() {
+        if (index < integers.size()) {
+            CPPUNIT_ASSERT_EQUAL(integers[index], reader.readInt64());
+        } else if (index == integers.size() + lengths.size() * 2) {
+            CPPUNIT_ASSERT(reader.isNull());
+            reader.readNull();
+        } else if ((index - integers.size()) % 2 == 0) {
+            auto bytes = reader.readBytes();
+            CPPUNIT_ASSERT(std::vector<uint8_t>(bytes.cbegin(), bytes.cend()) == expected[index].get_binary());
+        } else {
+            CPPUNIT_ASSERT(std::string(reader.readString()) == expected[index].get<std::string>());
+        }
+        index++;
+    });
+    CPPUNIT_ASSERT_EQUAL(expected.size(), index);
+    CPPUNIT_ASSERT(reader.atEnd());
+}
+
+void CborCodecTests::testWriterSortsMapKeys() {
+    std::vector<std::string> keys;
+    for (int i = 0; i < 30; i++)
+        keys.push_back(randomString(randomInt(1, 4)));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    nlohmann::json expected = nlohmann::json::object();
+    std::vector<uint8_t> out { 0x01, 0x02 };    // existing content must be left alone
+    CborWriter writer(out);
+    writer.beginMap();
+    for (const auto& key : keys) {
+        writer.key(key);
+        if (key.size() == 1) {
+            // nested maps are sorted on their own
+            writer.beginMap();
+            writer.key("z");
+            writer.writeInt(1);
+            writer.key("a");
+            writer.writeString(key);
+            writer.endMap();
+            expected[key] = { {"z", 1}, {"a", key} };
+        } else {
+            auto value = randomBytes(randomInt(0, 40));
+            writer.writeBytes(value);
+            expected[key] = nlohmann::json::binary_t {value};
+        }
+    }
+    writer.endMap();
+
+    auto cbor = nlohmann::json::to_cbor(expected);
+    cbor.insert(cbor.begin(), { 0x01, 0x02 });
+    CPPUNIT_ASSERT(out == cbor);
+}
+
+void CborCodecTests::testReaderIndefiniteLength() {
+    for (int i = 0; i < 200; i++) {
+        auto sample = randomMessage(i % MESSAGE_KINDS);
+
+        std::vector<uint8_t> data;
+        encodeIndefinite(sample.legacy, data);
+
+        auto parsed = Message::parse(data.data(), data.size());
+        CPPUNIT_ASSERT(parsed->serialize() == sample.message->serialize());
+    }
+}
+
+void CborCodecTests::testMessagesMatchLegacyCodec() {
+    for (int i = 0; i < 1000; i++) {
+        auto sample = randomMessage(i % MESSAGE_KINDS);
+
+        // encoding matches the nlohmann::json based codec byte for byte
+        auto data = sample.message->serialize();
+        auto legacy = nlohmann::json::to_cbor(sample.legacy);
+        CPPUNIT_ASSERT(data == legacy);
+
+        // and decoding it yields the same message
+        auto parsed = Message::parse(legacy.data(), legacy.size());
+        CPPUNIT_ASSERT(parsed->getType() == sample.message->getType());
+        CPPUNIT_ASSERT(parsed->getMethod() == sample.message->getMethod());
+        CPPUNIT_ASSERT_EQUAL(sample.message->getTxid(), parsed->getTxid());
+        CPPUNIT_ASSERT_EQUAL(sample.message->getVersion(), parsed->getVersion());
+        CPPUNIT_ASSERT_EQUAL(sample.message->toString(), parsed->toString());
+        CPPUNIT_ASSERT(parsed->serialize() == legacy);
+    }
+}
+
+void CborCodecTests::testMalformedInput() {
+    for (int i = 0; i < 200; i++) {
+        auto data = randomMessage(i % MESSAGE_KINDS).message->serialize();
+
+        // every proper prefix is incomplete
+        for (size_t length = 0; length < data.size(); length++) {
+            CPPUNIT_ASSERT_THROW(Message::parse(data.data(), length), std::exception);
+        }
+
+        // random corruption must either decode or be rejected cleanly
+        for (int j = 0; j < 50; j++) {
+            auto corrupted = data;
+            int flips = randomInt(1, 4);
+            for (int k = 0; k < flips; k++)
+                corrupted[randomInt(0, corrupted.size() - 1)] = static_cast<uint8_t>(randomInt(0, 255));
+
+            try {
+                Message::parse(corrupted.data(), corrupted.size());
+            } catch (const std::exception&) {
+            }
+        }
+    }
+
+    // trailing garbage, excessive nesting and impossible lengths
+    auto data = randomMessage(0).message->serialize();
+    data.push_back(0x00);
+    CPPUNIT_ASSERT_THROW(Message::parse(data.data(), data.size()), MessageError);
+
+    std::vector<uint8_t> nested { 0xA2, 0x61, 'y', 0x18, 0x21, 0x61, 'z' };
+    nested.insert(nested.end(), 1000, 0x81);
+    nested.push_back(0x00);
+    CPPUNIT_ASSERT_THROW(Message::parse(nested.data(), nested.size()), MessageError);
+
+    std::vector<uint8_t> huge { 0xA2, 0x61, 'y', 0x18, 0x21, 0x61, 'z', 0x5B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    CPPUNIT_ASSERT_THROW(Message::parse(huge.data(), huge.size()), MessageError);
+}
+
+}  // namespace test
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <list>
+#include <new>
+
+#include "boson/node_info.h"
+#include "boson/peer_info.h"
+#include "boson/value.h"
+#include "messages/message.h"
+#include "messages/ping_request.h"
+#include "messages/ping_response.h"
+#include "messages/find_node_request.h"
+#include "messages/find_node_response.h"
+#include "messages/find_value_request.h"
+#include "messages/find_value_response.h"
+#include "messages/find_peer_request.h"
+#include "messages/find_peer_response.h"
+#include "messages/store_value_request.h"
+#include "messages/store_value_response.h"
+#include "messages/announce_peer_request.h"
+#include "messages/announce_peer_response.h"
+#include "packet_buffer.h"
+
+#include "utils.h"
+#include "message_pool_tests.h"
+
+// Count the heap allocations made by the current thread while enabled
+static thread_local bool countAllocations = false;
+static thread_local size_t allocations = 0;
+
+void* operator new(std::size_t size) {
+    if (countAllocations)
+        allocations++;
+
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    if (countAllocations)
+        allocations++;
+
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(MessagePoolTests);
+
+static std::list<Sp<NodeInfo>> makeNodes(const std::string& ip, int count) {
+    std::list<Sp<NodeInfo>> nodes;
+    for (int i = 0; i < count; i++)
+        nodes.push_back(std::make_shared<NodeInfo>(Id::random(), ip, 39001 + i));
+    return nodes;
+}
+
+// Decode a fully populated message into a pooled object, drop it and check
+// the next object of the class comes back recycled and in the default state.
+template <typename T>
+static void checkReset(const Message& full) {
+    auto data = full.serialize();
+    const Message* recycled;
+    {
+        auto parsed = Message::parse(data.data(), data.size());
+        CPPUNIT_ASSERT(dynamic_cast<T*>(parsed.get()) != nullptr);
+        parsed->setId(Id::random());
+        parsed->setOrigin(SocketAddress("192.168.1.1", 39001));
+        parsed->setRemote(Id::random(), SocketAddress("192.168.1.2", 39002));
+        recycled = parsed.get();
+    }
+
+    auto msg = Message::acquire<T>();
+    CPPUNIT_ASSERT(msg.get() == recycled);
+    CPPUNIT_ASSERT(msg->getId() == Id());
+    CPPUNIT_ASSERT(msg->getRemoteId() == Id());
+    CPPUNIT_ASSERT(!msg->getOrigin());
+    CPPUNIT_ASSERT(!msg->getRemoteAddress());
+    CPPUNIT_ASSERT(msg->getAssociatedCall() == nullptr);
+
+    T fresh;
+    CPPUNIT_ASSERT(fresh.serialize() == msg->serialize());
+}
+
+void MessagePoolTests::testRecycle() {
+    const FindNodeResponse* first;
+    {
+        auto msg = Message::acquire<FindNodeResponse>();
+        msg->setTxid(0x1234);
+        msg->setVersion(VERSION);
+        msg->setToken(0x5678);
+        msg->setNodes4(makeNodes("192.168.1.1", 8));
+        first = msg.get();
+
+        // the pool only gets the object back with the last reference
+        Sp<Message> other = msg;
+        msg.reset();
+        CPPUNIT_ASSERT(Message::acquire<FindNodeResponse>().get() != first);
+    }
+
+    auto msg = Message::acquire<FindNodeResponse>();
+    CPPUNIT_ASSERT(msg.get() == first);
+    CPPUNIT_ASSERT_EQUAL(0, msg->getTxid());
+    CPPUNIT_ASSERT_EQUAL(0, msg->getVersion());
+    CPPUNIT_ASSERT_EQUAL(0, msg->getToken());
+    CPPUNIT_ASSERT(msg->getNodes4().empty());
+
+    // the recycled node list holds no references
+    auto nodes = makeNodes("192.168.1.1", 4);
+    msg->setNodes4(nodes);
+    msg->setNodes6(makeNodes("2001:db8::1", 2));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), msg->getNodes4().size());
+    CPPUNIT_ASSERT_EQUAL(size_t(2), msg->getNodes6().size());
+    CPPUNIT_ASSERT(Utils::arrayEquals(nodes, const_cast<std::list<Sp<NodeInfo>>&>(msg->getNodes4())));
+    msg.reset();
+    for (const auto& node : nodes)
+        CPPUNIT_ASSERT_EQUAL(1L, node.use_count());
+}
+
+void MessagePoolTests::testReset() {
+    auto nodes4 = makeNodes("192.168.1.1", 8);
+    auto nodes6 = makeNodes("2001:db8::1", 8);
+    auto keypair = Signature::KeyPair::random();
+    auto value = Value::createEncryptedValue(keypair, Id(Signature::KeyPair::random().publicKey()),
+            CryptoBox::Nonce::random(), 3, Utils::getRandomData(256));
+    auto peer = PeerInfo::create(keypair, Id::random(), Id::random(), 39001, "http://abc.pc2.net:8888");
+
+    auto setHeader = [&](Message& msg) {
+        msg.setTxid(0x1234);
+        msg.setVersion(VERSION);
+    };
+
+    PingRequest ping;
+    setHeader(ping);
+    checkReset<PingRequest>(ping);
+
+    PingResponse pong(0x1234);
+    setHeader(pong);
+    checkReset<PingResponse>(pong);
+
+    FindNodeRequest findNode(Id::random(), true);
+    findNode.setWant4(true);
+    findNode.setWant6(true);
+    setHeader(findNode);
+    checkReset<FindNodeRequest>(findNode);
+
+    FindNodeResponse nodes(0x1234);
+    nodes.setNodes4(nodes4);
+    nodes.setNodes6(nodes6);
+    nodes.setToken(0x5678);
+    setHeader(nodes);
+    checkReset<FindNodeResponse>(nodes);
+
+    FindValueRequest findValue(Id::random());
+    findValue.setWant4(true);
+    findValue.setSequenceNumber(5);
+    setHeader(findValue);
+    checkReset<FindValueRequest>(findValue);
+
+    FindValueResponse valueResponse(0x1234);
+    valueResponse.setNodes4(nodes4);
+    valueResponse.setToken(0x5678);
+    valueResponse.setValue(value);
+    setHeader(valueResponse);
+    checkReset<FindValueResponse>(valueResponse);
+
+    FindPeerRequest findPeer(Id::random());
+    findPeer.setWant6(true);
+    setHeader(findPeer);
+    checkReset<FindPeerRequest>(findPeer);
+
+    FindPeerResponse peers(0x1234);
+    peers.setNodes6(nodes6);
+    peers.setPeers({peer, peer});
+    setHeader(peers);
+    checkReset<FindPeerResponse>(peers);
+
+    StoreValueRequest store(value, 0x5678);
+    store.setExpectedSequenceNumber(2);
+    setHeader(store);
+    checkReset<StoreValueRequest>(store);
+
+    StoreValueResponse stored(0x1234);
+    setHeader(stored);
+    checkReset<StoreValueResponse>(stored);
+
+    AnnouncePeerRequest announce(peer, 0x5678);
+    setHeader(announce);
+    checkReset<AnnouncePeerRequest>(announce);
+
+    AnnouncePeerResponse announced(0x1234);
+    setHeader(announced);
+    checkReset<AnnouncePeerResponse>(announced);
+}
+
+void MessagePoolTests::testFindNodeServingAllocations() {
+    auto nodes4 = makeNodes("192.168.1.1", 8);
+    auto nodes6 = makeNodes("2001:db8::1", 8);
+
+    FindNodeRequest request(Id::random(), true);
+    request.setTxid(0x1234);
+    request.setVersion(VERSION);
+    request.setWant4(true);
+    request.setWant6(true);
+    auto data = request.serialize();
+
+    PacketBuffer packet;
+    auto serve = [&]() {
+        // decode the request, answer with the closest nodes and encode the reply
+        auto msg = Message::parse(data.data(), data.size());
+        auto req = std::static_pointer_cast<FindNodeRequest>(msg);
+
+        auto response = Message::acquire<FindNodeResponse>();
+        response->setTxid(req->getTxid());
+        if (req->doesWant4())
+            response->setNodes4(nodes4);
+        if (req->doesWant6())
+            response->setNodes6(nodes6);
+        if (req->doesWantToken())
+            response->setToken(0x5678);
+        response->setRemote(req->getId(), req->getOrigin());
+
+        packet.reset();
+        response->serialize(packet);
+    };
+
+    // warm up the pools
+    for (int i = 0; i < 16; i++)
+        serve();
+
+    allocations = 0;
+    countAllocations = true;
+    for (int i = 0; i < 1000; i++)
+        serve();
+    countAllocations = false;
+
+    CPPUNIT_ASSERT_EQUAL(size_t(0), allocations);
+}
+
+void MessagePoolTests::testFindNodeResponseAllocations() {
+    FindNodeResponse response(0x1234);
+    response.setVersion(VERSION);
+    response.setNodes4(makeNodes("192.168.1.1", 8));
+    response.setNodes6(makeNodes("2001:db8::1", 8));
+    response.setToken(0x5678);
+    auto data = response.serialize();
+
+    size_t nodes = 0;
+    auto receive = [&]() {
+        auto msg = Message::parse(data.data(), data.size());
+        auto rsp = std::static_pointer_cast<FindNodeResponse>(msg);
+        nodes += rsp->getNodes4().size() + rsp->getNodes6().size();
+    };
+
+    for (int i = 0; i < 16; i++)
+        receive();
+
+    allocations = 0;
+    countAllocations = true;
+    for (int i = 0; i < 1000; i++)
+        receive();
+    countAllocations = false;
+
+    CPPUNIT_ASSERT_EQUAL(size_t(0), allocations);
+    CPPUNIT_ASSERT_EQUAL(size_t(1016 * 16), nodes);
+}
+
+}  // namespace test
@@ -25,6 +25,8 @@
 
 #include <string>
 
+#include <nlohmann/json.hpp>
+
 #include "crypto/hex.h"
 #include "messages/message.h"
 
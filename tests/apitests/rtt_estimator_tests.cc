@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "constants.h"
+#include "rtt_estimator.h"
+#include "rtt_estimator_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(RTTEstimatorTests);
+
+void RTTEstimatorTests::testEstimator() {
+    RTTEstimator rtt;
+    CPPUNIT_ASSERT(!rtt.hasSamples());
+    CPPUNIT_ASSERT_EQUAL(0u, rtt.getRTO());
+
+    // first sample: SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 * RTTVAR
+    rtt.sample(100);
+    CPPUNIT_ASSERT(rtt.hasSamples());
+    CPPUNIT_ASSERT_EQUAL(100u, rtt.getSRTT());
+    CPPUNIT_ASSERT_EQUAL(50u, rtt.getRTTVar());
+    CPPUNIT_ASSERT_EQUAL(300u, rtt.getRTO());
+
+    // SRTT = 112.5, RTTVAR = 62.5
+    rtt.sample(200);
+    CPPUNIT_ASSERT_EQUAL(112u, rtt.getSRTT());
+    CPPUNIT_ASSERT_EQUAL(62u, rtt.getRTTVar());
+    CPPUNIT_ASSERT_EQUAL(362u, rtt.getRTO());
+
+    // a stable path converges to its round-trip time
+    for (int i = 0; i < 100; i++)
+        rtt.sample(40);
+    CPPUNIT_ASSERT_EQUAL(40u, rtt.getSRTT());
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(Constants::RPC_CALL_TIMEOUT_BASELINE_MIN), rtt.getRTO());
+}
+
+void RTTEstimatorTests::testBackoff() {
+    RTTEstimator rtt;
+    rtt.backoff();
+    CPPUNIT_ASSERT_EQUAL(0u, rtt.getRTO());
+
+    rtt.sample(1000);
+    CPPUNIT_ASSERT_EQUAL(3000u, rtt.getRTO());
+
+    rtt.backoff();
+    CPPUNIT_ASSERT_EQUAL(6000u, rtt.getRTO());
+
+    rtt.backoff();
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(Constants::RPC_CALL_TIMEOUT_MAX), rtt.getRTO());
+
+    // a new sample replaces the backed off timeout
+    rtt.sample(1000);
+    CPPUNIT_ASSERT(rtt.getRTO() < static_cast<uint32_t>(Constants::RPC_CALL_TIMEOUT_MAX));
+}
+
+void RTTEstimatorTests::testHistogramBuckets() {
+    int last = 0;
+    for (uint32_t v = 0; v < 200000; v++) {
+        int bucket = RTTHistogram::bucketOf(v);
+        CPPUNIT_ASSERT(bucket == last || bucket == last + 1);
+        last = bucket;
+
+        if (bucket == RTTHistogram::BUCKETS - 1)
+            continue;
+
+        uint32_t upper = RTTHistogram::upperBoundOf(bucket);
+        CPPUNIT_ASSERT(upper >= v);
+        // at most 25% above the recorded value
+        CPPUNIT_ASSERT(upper <= v + v / 4 + 1);
+    }
+}
+
+void RTTEstimatorTests::testHistogramPercentile() {
+    RTTHistogram histogram;
+    CPPUNIT_ASSERT_EQUAL(0u, histogram.percentile(0.5));
+
+    for (int i = 0; i < 90; i++)
+        histogram.record(20);
+    for (int i = 0; i < 10; i++)
+        histogram.record(1000);
+
+    CPPUNIT_ASSERT_EQUAL(100u, histogram.count());
+    CPPUNIT_ASSERT_EQUAL(23u, histogram.percentile(0.5));
+    CPPUNIT_ASSERT_EQUAL(23u, histogram.percentile(0.9));
+
+    uint32_t p99 = histogram.percentile(0.99);
+    CPPUNIT_ASSERT(p99 >= 1000 && p99 <= 1250);
+
+    // old samples fade out once the window is full
+    for (uint32_t i = 0; i < RTTHistogram::WINDOW; i++)
+        histogram.record(500);
+
+    CPPUNIT_ASSERT(histogram.count() < RTTHistogram::WINDOW);
+    uint32_t p50 = histogram.percentile(0.5);
+    CPPUNIT_ASSERT(p50 >= 500 && p50 <= 625);
+}
+
+}  // namespace test
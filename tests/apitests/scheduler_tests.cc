@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <boson.h>
+
+#include "scheduler.h"
+#include "scheduler_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(SchedulerTests);
+
+// The scheduler takes the delays relative to the wall clock, but only runs the
+// jobs due at the time given to syncTime(): the tests drive that time forward.
+static size_t advance(Scheduler& scheduler, uint64_t& now, uint64_t until) {
+    size_t rounds = 0;
+    while (now < until) {
+        uint64_t next = scheduler.getNextJobTime();
+        now = std::min(std::max(now + 1, next), until);
+        scheduler.syncTime(now);
+        scheduler.run();
+        rounds++;
+    }
+    return rounds;
+}
+
+void SchedulerTests::testRunInOrder() {
+    Scheduler scheduler;
+    std::mt19937 rng(20231115);
+    std::map<int, uint64_t> expected;
+    std::vector<std::pair<int, uint64_t>> fired;
+
+    uint64_t now = currentTimeMillis();
+    for (int i = 0; i < 20000; i++) {
+        // spread over all the wheels, up to ~1.5 hours
+        long delay = (i % 10 == 0) ? rng() % 5000000 : rng() % 70000;
+        expected[i] = currentTimeMillis() + delay;
+        scheduler.add([&, i]() {
+            fired.emplace_back(i, scheduler.time());
+        }, delay);
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)20000, scheduler.size());
+
+    size_t rounds = advance(scheduler, now, currentTimeMillis() + 5000000 + 1000);
+
+    CPPUNIT_ASSERT_EQUAL(expected.size(), fired.size());
+    CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.size());
+    CPPUNIT_ASSERT(scheduler.getNextJobTime() == std::numeric_limits<uint64_t>::max());
+    // no busy loop on the outer wheels
+    CPPUNIT_ASSERT(rounds < 2 * expected.size());
+
+    uint64_t last = 0;
+    for (auto& [i, time] : fired) {
+        // never early, and late only by the time it took to schedule them
+        CPPUNIT_ASSERT(time >= expected[i]);
+        CPPUNIT_ASSERT(time <= expected[i] + 1000);
+        CPPUNIT_ASSERT(time >= last);
+        last = time;
+    }
+}
+
+void SchedulerTests::testCancel() {
+    Scheduler scheduler;
+    std::vector<Sp<Scheduler::Job>> jobs;
+    int fired = 0;
+
+    for (int i = 0; i < 1000; i++)
+        jobs.push_back(scheduler.add([&]() { fired++; }, i * 37));
+
+    for (size_t i = 0; i < jobs.size(); i += 2)
+        jobs[i]->cancel();
+    CPPUNIT_ASSERT_EQUAL((size_t)500, scheduler.size());
+
+    // canceling twice or from another job is harmless
+    jobs[0]->cancel();
+    scheduler.add([&]() { jobs[1]->cancel(); }, 0);
+
+    uint64_t now = currentTimeMillis();
+    advance(scheduler, now, now + 1000 * 37 + 1000);
+
+    CPPUNIT_ASSERT_EQUAL(499, fired);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.size());
+}
+
+void SchedulerTests::testFixedDelay() {
+    Scheduler scheduler;
+    int fired = 0;
+    Sp<Scheduler::Job> job;
+    job = scheduler.add([&]() {
+        // a recurring job may stop itself
+        if (++fired == 5)
+            job->cancel();
+    }, 10, 10);
+
+    for (int i = 0; i < 10; i++) {
+        // the next run is relative to the wall clock, as in the rx thread loop
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        scheduler.syncTime();
+        scheduler.run();
+        CPPUNIT_ASSERT_EQUAL(std::min(i + 1, 5), fired);
+    }
+
+    CPPUNIT_ASSERT(!*job);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.size());
+}
+
+void SchedulerTests::testEdit() {
+    Scheduler scheduler;
+    int fired = 0;
+    auto job = scheduler.add([&]() { fired++; }, 100000);
+    auto original = job.get();
+
+    uint64_t now = currentTimeMillis();
+    scheduler.edit(job, 10);
+    // rescheduled in place
+    CPPUNIT_ASSERT(job.get() == original);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, scheduler.size());
+    CPPUNIT_ASSERT(scheduler.getNextJobTime() <= currentTimeMillis() + 10);
+
+    advance(scheduler, now, currentTimeMillis() + 1000);
+    CPPUNIT_ASSERT_EQUAL(1, fired);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.size());
+}
+
+void SchedulerTests::testAddScheduled() {
+    Scheduler scheduler;
+    int fired = 0;
+    auto job = scheduler.add([&]() { fired++; }, 100000);
+
+    // moved, not linked a second time
+    scheduler.add(job, 20);
+    scheduler.add(job, 10);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, scheduler.size());
+
+    uint64_t now = currentTimeMillis();
+    advance(scheduler, now, currentTimeMillis() + 1000);
+    CPPUNIT_ASSERT_EQUAL(1, fired);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.size());
+
+    scheduler.add(job, 10);
+    scheduler.add(job, 10);
+    job->cancel();
+    CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.size());
+    CPPUNIT_ASSERT(scheduler.getNextJobTime() == std::numeric_limits<uint64_t>::max());
+}
+
+}  // namespace test
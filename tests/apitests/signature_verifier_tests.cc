@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boson.h>
+
+#include "signature_verifier.h"
+#include "utils.h"
+#include "signature_verifier_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(SignatureVerifierTests);
+
+static Value tamperedValue() {
+    auto value = Value::createSignedValue(Utils::getRandomData(32));
+    auto data = Utils::getRandomData(32);
+    return Value::of(value.getPublicKey().blob(), {}, {}, value.getNonce().blob(),
+            value.getSequenceNumber(), Blob(value.getSignature()), Blob(data));
+}
+
+static PeerInfo tamperedPeer() {
+    auto peer = PeerInfo::create(Id::random(), 8888);
+    return PeerInfo::of(peer.getId().blob(), {}, peer.getNodeId().blob(), peer.getOrigin().blob(),
+            peer.getPort() + 1, {}, Blob(peer.getSignature()));
+}
+
+void SignatureVerifierTests::testInline() {
+    SignatureVerifier verifier([](std::function<void()>&&) {
+        CPPUNIT_FAIL("Nothing should be posted without workers");
+    });
+    CPPUNIT_ASSERT(!verifier.isAsync());
+
+    int completed = 0;
+    verifier.verify(Value::createSignedValue(Utils::getRandomData(32)), [&](bool valid) {
+        CPPUNIT_ASSERT(valid);
+        completed++;
+    });
+    verifier.verify(tamperedValue(), [&](bool valid) {
+        CPPUNIT_ASSERT(!valid);
+        completed++;
+    });
+    verifier.verify(Value::createValue(Utils::getRandomData(32)), [&](bool valid) {
+        CPPUNIT_ASSERT(valid);
+        completed++;
+    });
+    CPPUNIT_ASSERT_EQUAL(3, completed);
+}
+
+void SignatureVerifierTests::testPeers() {
+    SignatureVerifier verifier([](std::function<void()>&&) {});
+
+    std::vector<PeerInfo> peers;
+    for (int i = 0; i < 4; i++)
+        peers.push_back(PeerInfo::create(Id::random(), 8000 + i));
+
+    bool result = false;
+    verifier.verify(peers, [&](bool valid) { result = valid; });
+    CPPUNIT_ASSERT(result);
+
+    peers.push_back(tamperedPeer());
+    verifier.verify(peers, [&](bool valid) { result = valid; });
+    CPPUNIT_ASSERT(!result);
+}
+
+void SignatureVerifierTests::testWorkers() {
+    // stands in for the rx thread: collects the posted jobs, runs them here
+    std::mutex lock;
+    std::vector<std::function<void()>> posted;
+    SignatureVerifier verifier([&](std::function<void()>&& job) {
+        std::lock_guard<std::mutex> lk(lock);
+        posted.emplace_back(std::move(job));
+    });
+
+    verifier.start(2);
+    CPPUNIT_ASSERT(verifier.isAsync());
+
+    const int COUNT = 100;
+    std::vector<int> results(COUNT, -1);
+    auto self = std::this_thread::get_id();
+    for (int i = 0; i < COUNT; i++) {
+        auto value = (i % 3 == 0) ? tamperedValue() : Value::createSignedValue(Utils::getRandomData(32));
+        verifier.verify(value, [&, i, self](bool valid) {
+            CPPUNIT_ASSERT(std::this_thread::get_id() == self);
+            results[i] = valid ? 1 : 0;
+        });
+    }
+
+    int completed = 0;
+    int jobs = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (completed < COUNT && std::chrono::steady_clock::now() < deadline) {
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            ready.swap(posted);
+        }
+        for (auto& job : ready)
+            job();
+        jobs += ready.size();
+
+        completed = 0;
+        for (auto r : results)
+            completed += (r >= 0);
+        if (completed < COUNT)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    verifier.stop();
+
+    CPPUNIT_ASSERT_EQUAL(COUNT, completed);
+    for (int i = 0; i < COUNT; i++)
+        CPPUNIT_ASSERT_EQUAL(i % 3 == 0 ? 0 : 1, results[i]);
+    // the results come back in batches, not one job per record
+    CPPUNIT_ASSERT(jobs <= COUNT);
+}
+
+}  // namespace test
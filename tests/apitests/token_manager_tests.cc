@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <boson.h>
+
+#include "token_manager.h"
+#include "token_manager_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(TokenManagerTests);
+
+void TokenManagerTests::testVerify() {
+    TokenManager manager;
+    auto nodeId = Id::random();
+    auto target = Id::random();
+    SocketAddress addr4("192.168.8.1", 39001);
+    SocketAddress addr6("2001:db8::1", 39001);
+
+    auto token4 = manager.generateToken(nodeId, addr4, target);
+    auto token6 = manager.generateToken(nodeId, addr6, target);
+    CPPUNIT_ASSERT(manager.verifyToken(token4, nodeId, addr4, target));
+    CPPUNIT_ASSERT(manager.verifyToken(token6, nodeId, addr6, target));
+    CPPUNIT_ASSERT_EQUAL(token4, manager.generateToken(nodeId, addr4, target));
+}
+
+void TokenManagerTests::testMismatch() {
+    TokenManager manager;
+    auto nodeId = Id::random();
+    auto target = Id::random();
+    SocketAddress addr("192.168.8.1", 39001);
+
+    auto token = manager.generateToken(nodeId, addr, target);
+    CPPUNIT_ASSERT(!manager.verifyToken(token + 1, nodeId, addr, target));
+    CPPUNIT_ASSERT(!manager.verifyToken(token, Id::random(), addr, target));
+    CPPUNIT_ASSERT(!manager.verifyToken(token, nodeId, addr, Id::random()));
+    CPPUNIT_ASSERT(!manager.verifyToken(token, nodeId, SocketAddress("192.168.8.2", 39001), target));
+    CPPUNIT_ASSERT(!manager.verifyToken(token, nodeId, SocketAddress("192.168.8.1", 39002), target));
+}
+
+void TokenManagerTests::testSessions() {
+    // every node has its own session secret
+    TokenManager manager1;
+    TokenManager manager2;
+    auto nodeId = Id::random();
+    auto target = Id::random();
+    SocketAddress addr("192.168.8.1", 39001);
+
+    auto token = manager1.generateToken(nodeId, addr, target);
+    CPPUNIT_ASSERT(manager1.verifyToken(token, nodeId, addr, target));
+    CPPUNIT_ASSERT(!manager2.verifyToken(token, nodeId, addr, target));
+}
+
+}  // namespace test
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "utils/transaction_table.h"
+#include "transaction_table_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(TransactionTableTests);
+
+using Table = TransactionTable<std::shared_ptr<int>>;
+
+void TransactionTableTests::testInsertAndRemove() {
+    Table table(16);
+    CPPUNIT_ASSERT(table.empty());
+    CPPUNIT_ASSERT_EQUAL((size_t)16, table.capacity());
+
+    for (int txid = 1; txid <= 10; txid++)
+        CPPUNIT_ASSERT(table.insert(txid, std::make_shared<int>(txid), 1000));
+
+    CPPUNIT_ASSERT_EQUAL((size_t)10, table.size());
+    for (int txid = 1; txid <= 10; txid++) {
+        auto value = table.find(txid);
+        CPPUNIT_ASSERT(value != nullptr);
+        CPPUNIT_ASSERT_EQUAL(txid, **value);
+    }
+    CPPUNIT_ASSERT(table.find(11) == nullptr);
+
+    auto removed = table.remove(5);
+    CPPUNIT_ASSERT(removed != nullptr);
+    CPPUNIT_ASSERT_EQUAL(5, *removed);
+    CPPUNIT_ASSERT(table.remove(5) == nullptr);
+    CPPUNIT_ASSERT(!table.contains(5));
+    CPPUNIT_ASSERT_EQUAL((size_t)9, table.size());
+
+    table.clear();
+    CPPUNIT_ASSERT(table.empty());
+    CPPUNIT_ASSERT(table.find(1) == nullptr);
+}
+
+void TransactionTableTests::testReuseAndCapacity() {
+    Table table(4);
+
+    CPPUNIT_ASSERT(table.insert(42, std::make_shared<int>(1), 1000));
+    // a txid still in use, e.g. after the counter wrapped around
+    CPPUNIT_ASSERT(!table.insert(42, std::make_shared<int>(2), 1000));
+    CPPUNIT_ASSERT_EQUAL(1, **table.find(42));
+
+    CPPUNIT_ASSERT(table.insert(43, std::make_shared<int>(3), 1000));
+    CPPUNIT_ASSERT(table.insert(-7, std::make_shared<int>(4), 1000));
+    CPPUNIT_ASSERT(table.insert(std::numeric_limits<int>::max(), std::make_shared<int>(5), 1000));
+    CPPUNIT_ASSERT(table.full());
+    CPPUNIT_ASSERT(!table.insert(44, std::make_shared<int>(6), 1000));
+
+    table.remove(43);
+    CPPUNIT_ASSERT(table.insert(44, std::make_shared<int>(6), 1000));
+    CPPUNIT_ASSERT_EQUAL(6, **table.find(44));
+}
+
+void TransactionTableTests::testExpire() {
+    Table table(8);
+    for (int txid = 1; txid <= 6; txid++)
+        table.insert(txid, std::make_shared<int>(txid), txid * 100);
+
+    // removing from the middle keeps the order of the others
+    table.remove(2);
+
+    CPPUNIT_ASSERT(table.popExpired(99) == nullptr);
+
+    std::vector<int> expired;
+    while (auto value = table.popExpired(450))
+        expired.push_back(*value);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)3, expired.size());
+    CPPUNIT_ASSERT_EQUAL(1, expired[0]);
+    CPPUNIT_ASSERT_EQUAL(3, expired[1]);
+    CPPUNIT_ASSERT_EQUAL(4, expired[2]);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)2, table.size());
+    CPPUNIT_ASSERT(table.contains(5));
+    CPPUNIT_ASSERT(table.contains(6));
+}
+
+void TransactionTableTests::testRandomOperations() {
+    Table table(256);
+    std::map<int, int> expected;
+    std::mt19937 rng(20231115);
+    // a narrow txid range produces long probe clusters
+    std::uniform_int_distribution<int> txids(0, 600);
+
+    for (int i = 0; i < 200000; i++) {
+        int txid = txids(rng);
+        if (rng() % 2 == 0) {
+            bool inserted = table.insert(txid, std::make_shared<int>(i), 0);
+            bool shouldInsert = expected.count(txid) == 0 && expected.size() < table.capacity();
+            CPPUNIT_ASSERT_EQUAL(shouldInsert, inserted);
+            if (inserted)
+                expected[txid] = i;
+        } else {
+            auto removed = table.remove(txid);
+            auto it = expected.find(txid);
+            if (it == expected.end()) {
+                CPPUNIT_ASSERT(removed == nullptr);
+            } else {
+                CPPUNIT_ASSERT(removed != nullptr);
+                CPPUNIT_ASSERT_EQUAL(it->second, *removed);
+                expected.erase(it);
+            }
+        }
+
+        CPPUNIT_ASSERT_EQUAL(expected.size(), table.size());
+    }
+
+    for (int txid = 0; txid <= 600; txid++) {
+        auto value = table.find(txid);
+        auto it = expected.find(txid);
+        CPPUNIT_ASSERT_EQUAL(it != expected.end(), value != nullptr);
+        if (value != nullptr)
+            CPPUNIT_ASSERT_EQUAL(it->second, **value);
+    }
+}
+
+}  // namespace test
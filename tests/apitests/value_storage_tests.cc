@@ -21,6 +21,8 @@
 * SOFTWARE.
 */
 
+#include <algorithm>
+#include <atomic>
 #include <list>
 #include <vector>
 #include <string>
@@ -29,6 +31,7 @@
 #include <thread>
 #include <boson.h>
 
+#include "constants.h"
 #include "sqlite_storage.h"
 #include "utils/list.h"
 #include "utils.h"
@@ -240,4 +243,84 @@ void ValueStorageTests::testUpdateEncryptedValue() {
     storage->close();
 }
 
+void ValueStorageTests::testExpire() {
+    auto storage = SqliteStorage::open(path, scheduler);
+    auto sqlite = std::static_pointer_cast<SqliteStorage>(storage);
+
+    const int count = Constants::STORAGE_EXPIRE_CHUNK_SIZE * 4 + 10;
+    std::vector<Id> valueIds {};
+    for (int i = 0; i < count; i++) {
+        auto value = Value::createValue(Utils::getRandomData(32));
+        storage->putValue(value, i < 10);
+        valueIds.push_back(value.getId());
+    }
+
+    std::vector<PeerInfo> peers {};
+    for (int i = 0; i < 100; i++)
+        peers.push_back(PeerInfo::create(Id::random(), 8000 + i));
+    storage->putPeer(peers);
+
+    // run the sweep scheduled when the storage was opened, nothing is expired yet
+    scheduler.syncTime();
+    scheduler.run();
+    CPPUNIT_ASSERT(!sqlite->isExpiring());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, sqlite->getLastExpire().values);
+
+    auto later = currentTimeMillis() + std::max(Constants::MAX_VALUE_AGE, Constants::MAX_PEER_AGE) + 1;
+    sqlite->expire(later);
+    // one chunk on the calling thread, the rest spread over the next scheduler runs
+    CPPUNIT_ASSERT(sqlite->isExpiring());
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (sqlite->isExpiring() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        scheduler.syncTime();
+        scheduler.run();
+    }
+
+    CPPUNIT_ASSERT(!sqlite->isExpiring());
+    auto stats = sqlite->getLastExpire();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)(count - 10), stats.values);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)100, stats.peers);
+    CPPUNIT_ASSERT_EQUAL(5, stats.chunks);
+
+    for (int i = 0; i < count; i++)
+        CPPUNIT_ASSERT((storage->getValue(valueIds[i]) != nullptr) == (i < 10));
+    CPPUNIT_ASSERT_EQUAL((size_t)10, storage->getAllValues().size());
+    CPPUNIT_ASSERT(storage->getAllPeers().empty());
+
+    storage->close();
+}
+
+void ValueStorageTests::testReadDuringTransaction() {
+    auto storage = SqliteStorage::open(path, scheduler);
+    auto stored = Value::createValue(Utils::getRandomData(64));
+    storage->putValue(stored);
+
+    auto value = Value::createValue(Utils::getRandomData(64));
+    std::atomic<bool> writing {false};
+    std::atomic<bool> release {false};
+    std::thread writer([&]() {
+        storage->transaction([&]() {
+            storage->putValue(value);
+            writing = true;
+            while (!release)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+    });
+    while (!writing)
+        std::this_thread::yield();
+
+    // the reads don't wait for the open transaction, and don't see it either
+    CPPUNIT_ASSERT(storage->getValue(stored.getId()));
+    CPPUNIT_ASSERT(!storage->getValue(value.getId()));
+    CPPUNIT_ASSERT_EQUAL((size_t)1, storage->getAllValues().size());
+
+    release = true;
+    writer.join();
+    CPPUNIT_ASSERT(storage->getValue(value.getId()));
+
+    storage->close();
+}
+
 }  // namespace test
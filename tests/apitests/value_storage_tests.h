@@ -34,6 +34,8 @@ class ValueStorageTests : public CppUnit::TestFixture {
     CPPUNIT_TEST(testPutAndGetPersistentValue);
     CPPUNIT_TEST(testUpdateSignedValue);
     CPPUNIT_TEST(testUpdateEncryptedValue);
+    CPPUNIT_TEST(testExpire);
+    CPPUNIT_TEST(testReadDuringTransaction);
     CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -44,6 +46,8 @@ class ValueStorageTests : public CppUnit::TestFixture {
     void testPutAndGetPersistentValue();
     void testUpdateSignedValue();
     void testUpdateEncryptedValue();
+    void testExpire();
+    void testReadDuringTransaction();
 
 private:
     boson::Scheduler scheduler {};
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <vector>
+
+#include <boson.h>
+
+#include "verified_records.h"
+#include "utils.h"
+#include "verified_records_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(VerifiedRecordsTests);
+
+void VerifiedRecordsTests::testVerifyOnce() {
+    VerifiedRecords records(64);
+    auto keypair = Signature::KeyPair::random();
+    auto data = Utils::getRandomData(64);
+    auto sig = Signature::sign(data, keypair.privateKey());
+
+    CPPUNIT_ASSERT(records.verify(data, sig, keypair.publicKey()));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, records.getHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, records.getMisses());
+
+    for (int i = 0; i < 9; i++)
+        CPPUNIT_ASSERT(records.verify(data, sig, keypair.publicKey()));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)9, records.getHits());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.9, records.getHitRate(), 0.0001);
+
+    records.clear();
+    CPPUNIT_ASSERT(records.verify(data, sig, keypair.publicKey()));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, records.getMisses());
+}
+
+void VerifiedRecordsTests::testInvalidNotCached() {
+    VerifiedRecords records(64);
+    auto keypair = Signature::KeyPair::random();
+    auto data = Utils::getRandomData(64);
+    auto sig = Signature::sign(data, keypair.privateKey());
+    CPPUNIT_ASSERT(records.verify(data, sig, keypair.publicKey()));
+
+    // any change of the payload, signature or signer is a different record
+    auto tampered = data;
+    tampered[10] ^= 0x01;
+    CPPUNIT_ASSERT(!records.verify(tampered, sig, keypair.publicKey()));
+    CPPUNIT_ASSERT(!records.verify(tampered, sig, keypair.publicKey()));
+
+    auto other = Signature::KeyPair::random();
+    CPPUNIT_ASSERT(!records.verify(data, sig, other.publicKey()));
+
+    auto badSig = sig;
+    badSig[0] ^= 0x01;
+    CPPUNIT_ASSERT(!records.verify(data, badSig, keypair.publicKey()));
+
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, records.getHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)5, records.getMisses());
+}
+
+void VerifiedRecordsTests::testBounded() {
+    VerifiedRecords records(16);
+    CPPUNIT_ASSERT_EQUAL((size_t)16, records.capacity());
+    CPPUNIT_ASSERT_THROW(VerifiedRecords(100), std::invalid_argument);
+
+    auto keypair = Signature::KeyPair::random();
+    std::vector<VerifiedRecords::Digest> digests;
+    for (int i = 0; i < 256; i++) {
+        auto data = Utils::getRandomData(32);
+        auto sig = Signature::sign(data, keypair.privateKey());
+        auto digest = VerifiedRecords::digestOf(data, sig, keypair.publicKey());
+        records.add(digest);
+        digests.push_back(digest);
+    }
+
+    size_t cached = 0;
+    for (auto& digest : digests)
+        cached += records.contains(digest);
+    CPPUNIT_ASSERT(cached <= records.capacity());
+    CPPUNIT_ASSERT(records.contains(digests.back()));
+}
+
+void VerifiedRecordsTests::testValueAndPeer() {
+    auto& records = VerifiedRecords::global();
+
+    auto value = Value::createSignedValue(Utils::getRandomData(32));
+    auto peer = PeerInfo::create(Id::random(), 8888);
+
+    auto hits = records.getHits();
+    CPPUNIT_ASSERT(value.isValid());
+    CPPUNIT_ASSERT(peer.isValid());
+    CPPUNIT_ASSERT(value.isValid());
+    CPPUNIT_ASSERT(peer.isValid());
+    CPPUNIT_ASSERT(records.getHits() >= hits + 2);
+}
+
+}  // namespace test
@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <boson.h>
+
+#include "sqlite_storage.h"
+#include "write_behind_storage.h"
+#include "utils.h"
+#include "write_behind_storage_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(WriteBehindStorageTests);
+
+// long enough for nothing to be committed behind the test's back
+static const int NEVER = 60 * 60 * 1000;
+
+// Fails the group commits, or holds the reads of one value, while asked to
+class FailingStorage : public DataStorage {
+public:
+    FailingStorage(Sp<DataStorage> _backend) : backend(_backend) {}
+
+    using DataStorage::putValue;
+    using DataStorage::putPeer;
+
+    Sp<Value> getValue(const Id& valueId) override {
+        if (blocking && valueId == blockedId) {
+            blocked++;
+            while (blocking)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return backend->getValue(valueId);
+    }
+    bool removeValue(const Id& valueId) override { return backend->removeValue(valueId); }
+    Sp<Value> putValue(const Value& value, int expectedSeq, bool persistent, bool updateLastAnnounce) override {
+        return backend->putValue(value, expectedSeq, persistent, updateLastAnnounce);
+    }
+    void updateValueLastAnnounce(const Id& valueId) override { backend->updateValueLastAnnounce(valueId); }
+    std::vector<Value> getPersistentValues(uint64_t lastAnnounceBefore) override {
+        return backend->getPersistentValues(lastAnnounceBefore);
+    }
+    std::vector<Id> getAllValues() override { return backend->getAllValues(); }
+
+    std::vector<PeerInfo> getPeer(const Id& peerId, int maxPeers) override { return backend->getPeer(peerId, maxPeers); }
+    Sp<PeerInfo> getPeer(const Id& peerId, const Id& origin) override { return backend->getPeer(peerId, origin); }
+    bool removePeer(const Id& peerId, const Id& origin) override { return backend->removePeer(peerId, origin); }
+    void putPeer(const std::vector<PeerInfo>& peers) override { backend->putPeer(peers); }
+    void putPeer(const PeerInfo& peer, bool persistent, bool updateLastAnnounce) override {
+        backend->putPeer(peer, persistent, updateLastAnnounce);
+    }
+    void updatePeerLastAnnounce(const Id& peerId, const Id& origin) override {
+        backend->updatePeerLastAnnounce(peerId, origin);
+    }
+    std::vector<PeerInfo> getPersistentPeers(uint64_t lastAnnounceBefore) override {
+        return backend->getPersistentPeers(lastAnnounceBefore);
+    }
+    std::vector<Id> getAllPeers() override { return backend->getAllPeers(); }
+
+    void transaction(const std::function<void()>& writes) override {
+        backend->transaction([&]() {
+            writes();
+            if (failing)
+                throw std::runtime_error("Disk full");
+        });
+    }
+
+    void close() override { backend->close(); }
+
+    std::atomic<bool> failing {false};
+    std::atomic<bool> blocking {false};
+    Id blockedId {};
+    std::atomic<int> blocked {0};
+
+private:
+    Sp<DataStorage> backend;
+};
+
+void WriteBehindStorageTests::setUp() {
+    path = Utils::getPwdStorage("apitests.db");
+}
+
+void WriteBehindStorageTests::tearDown() {
+    Utils::removeStorage(path);
+}
+
+void WriteBehindStorageTests::testReadPendingWrites() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    WriteBehindStorage storage(backend, NEVER, 1024);
+
+    std::vector<Value> values {};
+    for (int i = 0; i < 16; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+        storage.putValue(values.back());
+    }
+
+    auto keypair = Signature::KeyPair::random();
+    auto peerId = Id(keypair.publicKey());
+    std::vector<PeerInfo> peers {};
+    for (int i = 0; i < 8; i++)
+        peers.push_back(PeerInfo::create(keypair, Id::random(), Id::random(), 8000 + i));
+    storage.putPeer(peers);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)24, storage.getQueueDepth());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, storage.getCommits());
+
+    // served from the overlay, the backend has not seen them yet
+    for (const auto& value : values) {
+        auto v = storage.getValue(value.getId());
+        CPPUNIT_ASSERT(v);
+        CPPUNIT_ASSERT(*v == value);
+        CPPUNIT_ASSERT(!backend->getValue(value.getId()));
+    }
+
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPeer(peerId, 16).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)4, storage.getPeer(peerId, 4).size());
+    auto peer = storage.getPeer(peerId, peers[3].getOrigin());
+    CPPUNIT_ASSERT(peer);
+    CPPUNIT_ASSERT(*peer == peers[3]);
+    CPPUNIT_ASSERT(backend->getPeer(peerId, 16).empty());
+
+    storage.flush();
+    CPPUNIT_ASSERT_EQUAL((size_t)0, storage.getQueueDepth());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getCommits());
+
+    for (const auto& value : values) {
+        auto v = backend->getValue(value.getId());
+        CPPUNIT_ASSERT(v);
+        CPPUNIT_ASSERT(*v == value);
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)8, backend->getPeer(peerId, 16).size());
+
+    // the committed and the pending peers are merged without duplicates
+    auto more = PeerInfo::create(keypair, Id::random(), Id::random(), 9000);
+    storage.putPeer(more);
+    storage.putPeer(peers[0]);
+    CPPUNIT_ASSERT_EQUAL((size_t)9, storage.getPeer(peerId, 16).size());
+
+    storage.close();
+}
+
+void WriteBehindStorageTests::testGroupCommit() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    WriteBehindStorage storage(backend, NEVER, 16);
+
+    std::vector<Value> values {};
+    for (int i = 0; i < 64; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+        storage.putValue(values.back());
+    }
+
+    // every full batch wakes up the executor
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (storage.getQueueDepth() > 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    CPPUNIT_ASSERT_EQUAL((size_t)0, storage.getQueueDepth());
+    CPPUNIT_ASSERT(storage.getCommits() >= 1);
+    CPPUNIT_ASSERT(storage.getCommits() <= 4);
+
+    for (const auto& value : values)
+        CPPUNIT_ASSERT(backend->getValue(value.getId()));
+
+    storage.close();
+}
+
+void WriteBehindStorageTests::testUpdatePendingValue() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    WriteBehindStorage storage(backend, NEVER, 1024);
+
+    std::string str = "Hello, world";
+    auto signedValue = Value::createSignedValue(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    auto valueId = signedValue.getId();
+    storage.putValue(signedValue, 0);
+
+    // checked against the pending value
+    CPPUNIT_ASSERT_THROW(storage.putValue(signedValue, 10), std::invalid_argument);
+
+    str = "Hello, world2";
+    auto updated = signedValue.update(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    auto old = storage.putValue(updated, 0);
+    CPPUNIT_ASSERT(old);
+    CPPUNIT_ASSERT(*old == signedValue);
+
+    // coalesced into a single record
+    CPPUNIT_ASSERT_EQUAL((size_t)1, storage.getQueueDepth());
+    CPPUNIT_ASSERT(*storage.getValue(valueId) == updated);
+
+    storage.flush();
+    CPPUNIT_ASSERT(*backend->getValue(valueId) == updated);
+
+    // a removal sees the pending writes
+    str = "Hello, world3";
+    storage.putValue(updated.update(std::vector<uint8_t>(str.cbegin(), str.cend())));
+    CPPUNIT_ASSERT(storage.removeValue(valueId));
+    CPPUNIT_ASSERT(!storage.getValue(valueId));
+
+    storage.close();
+}
+
+void WriteBehindStorageTests::testQueuedRemovalAndAnnounce() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    WriteBehindStorage storage(backend, NEVER, 1024);
+
+    std::vector<Value> values {};
+    for (int i = 0; i < 8; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+        storage.putValue(values.back(), -1, true, false);
+    }
+
+    auto keypair = Signature::KeyPair::random();
+    auto peerId = Id(keypair.publicKey());
+    std::vector<PeerInfo> peers {};
+    for (int i = 0; i < 4; i++) {
+        peers.push_back(PeerInfo::create(keypair, Id::random(), Id::random(), 8000 + i));
+        storage.putPeer(peers.back(), true, false);
+    }
+
+    // listed before the backend has seen them
+    auto ts = currentTimeMillis();
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getPersistentValues(ts).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)4, storage.getPersistentPeers(ts).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)8, storage.getAllValues().size());
+    CPPUNIT_ASSERT_EQUAL((size_t)1, storage.getAllPeers().size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, storage.getCommits());
+
+    storage.flush();
+    ts = currentTimeMillis();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    // queued like the puts, and seen by the reads right away
+    CPPUNIT_ASSERT(storage.removeValue(values[0].getId()));
+    CPPUNIT_ASSERT(!storage.removeValue(values[0].getId()));
+    storage.updateValueLastAnnounce(values[1].getId());
+    CPPUNIT_ASSERT(storage.removePeer(peerId, peers[0].getOrigin()));
+    storage.updatePeerLastAnnounce(peerId, peers[1].getOrigin());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, storage.getCommits());
+    CPPUNIT_ASSERT_EQUAL((size_t)4, storage.getQueueDepth());
+
+    CPPUNIT_ASSERT(!storage.getValue(values[0].getId()));
+    CPPUNIT_ASSERT(backend->getValue(values[0].getId()));
+    CPPUNIT_ASSERT(!storage.getPeer(peerId, peers[0].getOrigin()));
+    CPPUNIT_ASSERT_EQUAL((size_t)3, storage.getPeer(peerId, 16).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)7, storage.getAllValues().size());
+    CPPUNIT_ASSERT_EQUAL((size_t)6, storage.getPersistentValues(ts).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)2, storage.getPersistentPeers(ts).size());
+
+    // put again after the removal, a new record
+    storage.putValue(values[0], -1, true, false);
+    CPPUNIT_ASSERT(storage.getValue(values[0].getId()));
+    CPPUNIT_ASSERT_EQUAL((size_t)7, storage.getPersistentValues(ts).size());
+
+    // the backend ends up where the overlay said
+    storage.flush();
+    CPPUNIT_ASSERT_EQUAL((size_t)8, backend->getAllValues().size());
+    CPPUNIT_ASSERT_EQUAL((size_t)7, backend->getPersistentValues(ts).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)3, backend->getPeer(peerId, 16).size());
+    CPPUNIT_ASSERT_EQUAL((size_t)2, backend->getPersistentPeers(ts).size());
+
+    storage.close();
+}
+
+void WriteBehindStorageTests::testConcurrentUpdate() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    WriteBehindStorage storage(backend, 10, 4);
+
+    std::string str = "Hello, world";
+    auto value = Value::createSignedValue(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    storage.putValue(value);
+
+    // every round all the writers race from the same sequence number, only one may win
+    for (int round = 0; round < 32; round++) {
+        std::vector<Value> updates {};
+        for (int i = 0; i < 8; i++)
+            updates.push_back(value.update(Utils::getRandomData(32)));
+
+        std::atomic<bool> go {false};
+        std::atomic<int> winners {0};
+        std::vector<std::thread> writers {};
+        for (const auto& update : updates) {
+            writers.emplace_back([&]() {
+                while (!go)
+                    std::this_thread::yield();
+                try {
+                    storage.putValue(update, value.getSequenceNumber());
+                    winners++;
+                } catch (const std::invalid_argument&) {
+                }
+            });
+        }
+        go = true;
+        for (auto& writer : writers)
+            writer.join();
+
+        CPPUNIT_ASSERT_EQUAL(1, winners.load());
+        value = *storage.getValue(value.getId());
+    }
+
+    storage.close();
+}
+
+void WriteBehindStorageTests::testSlowBackendRead() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    auto slow = std::make_shared<FailingStorage>(backend);
+    WriteBehindStorage storage(slow, NEVER, 1024);
+
+    auto stored = Value::createValue(Utils::getRandomData(64));
+    storage.putValue(stored);
+    storage.flush();
+
+    // a reader stuck in the backend
+    slow->blockedId = stored.getId();
+    slow->blocking = true;
+    std::thread reader([&]() {
+        CPPUNIT_ASSERT(storage.getValue(stored.getId()));
+    });
+    while (slow->blocked == 0)
+        std::this_thread::yield();
+
+    // doesn't hold up the writes or the reads the overlay answers
+    auto value = Value::createValue(Utils::getRandomData(64));
+    storage.putValue(value);
+    CPPUNIT_ASSERT(storage.getValue(value.getId()));
+    CPPUNIT_ASSERT(storage.removeValue(value.getId()));
+    CPPUNIT_ASSERT(!storage.getValue(value.getId()));
+
+    auto keypair = Signature::KeyPair::random();
+    auto peer = PeerInfo::create(keypair, Id::random(), Id::random(), 8000);
+    storage.putPeer(peer);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, storage.getPeer(peer.getId(), 8).size());
+    CPPUNIT_ASSERT_EQUAL(1, slow->blocked.load());
+
+    slow->blocking = false;
+    reader.join();
+    storage.close();
+}
+
+void WriteBehindStorageTests::testRetryFailedCommit() {
+    auto backend = SqliteStorage::open(path, scheduler);
+    auto failing = std::make_shared<FailingStorage>(backend);
+    WriteBehindStorage storage(failing, NEVER, 1024);
+
+    std::vector<Value> values {};
+    for (int i = 0; i < 8; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+        storage.putValue(values.back(), true);
+    }
+
+    auto keypair = Signature::KeyPair::random();
+    auto peerId = Id(keypair.publicKey());
+    auto peer = PeerInfo::create(keypair, Id::random(), Id::random(), 8000);
+    storage.putPeer(peer, true);
+
+    failing->failing = true;
+    CPPUNIT_ASSERT_THROW(storage.flush(), std::runtime_error);
+
+    // rolled back, but still queued and readable
+    CPPUNIT_ASSERT_EQUAL((size_t)9, storage.getQueueDepth());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, storage.getCommits());
+    for (const auto& value : values) {
+        CPPUNIT_ASSERT(!backend->getValue(value.getId()));
+        CPPUNIT_ASSERT(storage.getValue(value.getId()));
+    }
+    CPPUNIT_ASSERT(storage.getPeer(peerId, peer.getOrigin()));
+
+    // a newer write of a failed record wins over it
+    std::string str = "Hello, world";
+    auto signedValue = Value::createSignedValue(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    storage.putValue(signedValue, true);
+    CPPUNIT_ASSERT_THROW(storage.flush(), std::runtime_error);
+    str = "Hello, world2";
+    auto updated = signedValue.update(std::vector<uint8_t>(str.cbegin(), str.cend()));
+    storage.putValue(updated);
+    CPPUNIT_ASSERT_THROW(storage.flush(), std::runtime_error);
+    CPPUNIT_ASSERT_EQUAL((size_t)10, storage.getQueueDepth());
+
+    failing->failing = false;
+    storage.flush();
+    CPPUNIT_ASSERT_EQUAL((size_t)0, storage.getQueueDepth());
+
+    for (const auto& value : values)
+        CPPUNIT_ASSERT(backend->getValue(value.getId()));
+    CPPUNIT_ASSERT(*backend->getValue(updated.getId()) == updated);
+    CPPUNIT_ASSERT(backend->getPeer(peerId, peer.getOrigin()));
+    // the persistent state of the first write survived the retries
+    CPPUNIT_ASSERT_EQUAL((size_t)9, backend->getPersistentValues(currentTimeMillis()).size());
+
+    storage.close();
+}
+
+void WriteBehindStorageTests::testCloseCommitsPendingWrites() {
+    std::vector<Value> values {};
+    {
+        WriteBehindStorage storage(SqliteStorage::open(path, scheduler), NEVER, 1024);
+        for (int i = 0; i < 32; i++) {
+            values.push_back(Value::createValue(Utils::getRandomData(256)));
+            storage.putValue(values.back(), i % 2 == 0);
+        }
+        storage.close();
+    }
+
+    auto backend = SqliteStorage::open(path, scheduler);
+    for (const auto& value : values)
+        CPPUNIT_ASSERT(backend->getValue(value.getId()));
+    CPPUNIT_ASSERT_EQUAL((size_t)16, backend->getPersistentValues(currentTimeMillis()).size());
+
+    backend->close();
+}
+
+}  // namespace test
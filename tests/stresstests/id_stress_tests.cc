@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boson.h>
+
+#include "id_stress_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(IdStressTests);
+
+static const int CANDIDATES = 10000;
+static const int ROUNDS = 20;
+static const int DISTANCES = 1000000;
+
+static int64_t report(const std::string& name, std::chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << std::setw(32) << std::left << name
+            << std::setw(10) << std::right << elapsed / 1000000 << " ms"
+            << std::setw(10) << std::right << elapsed / ops << " ns/op" << std::endl;
+    return elapsed;
+}
+
+// The byte-wise kernels Id used before, kept as the baseline
+static Id legacyDistance(const Id& id1, const Id& id2) {
+    std::vector<uint8_t> buf(ID_BYTES);
+    for (int i = 0; i < ID_BYTES; i++)
+        buf[i] = id1.data()[i] ^ id2.data()[i];
+
+    return Id(buf);
+}
+
+static int legacyThreeWayCompare(const Id& target, const Id& id1, const Id& id2) {
+    int mmi = -1;
+    for (int i = 0; i < ID_BYTES; i++) {
+        if (id1.data()[i] != id2.data()[i]) {
+            mmi = i;
+            break;
+        }
+    }
+    if (mmi == -1) return 0;
+
+    uint8_t a = id1.data()[mmi] ^ target.data()[mmi];
+    uint8_t b = id2.data()[mmi] ^ target.data()[mmi];
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+// Candidates sharing a prefix of `shared` bytes with the target, as in the
+// later iterations of a lookup where every candidate is already close
+static std::vector<Id> makeCandidates(const Id& target, int shared) {
+    std::vector<Id> candidates;
+    candidates.reserve(CANDIDATES);
+    for (int i = 0; i < CANDIDATES; i++) {
+        auto random = Id::random();
+        std::array<uint8_t, ID_BYTES> bytes {};
+        std::memcpy(bytes.data(), random.data(), ID_BYTES);
+        std::memcpy(bytes.data(), target.data(), shared);
+        candidates.emplace_back(Blob(bytes));
+    }
+    return candidates;
+}
+
+void IdStressTests::testDistance() {
+    std::vector<Id> ids;
+    for (int i = 0; i < 1024; i++)
+        ids.push_back(Id::random());
+
+    std::cout << std::endl << "Distance: " << DISTANCES << std::endl;
+    uint8_t legacySink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < DISTANCES; i++)
+        legacySink ^= legacyDistance(ids[i & 1023], ids[(i + 1) & 1023]).data()[0];
+    auto legacy = report("byte loop", start, DISTANCES);
+
+    uint8_t sink = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < DISTANCES; i++)
+        sink ^= Id::distance(ids[i & 1023], ids[(i + 1) & 1023]).data()[0];
+    auto kernel = report("word kernel", start, DISTANCES);
+
+    CPPUNIT_ASSERT_EQUAL(legacySink, sink);
+    CPPUNIT_ASSERT(kernel < legacy);
+}
+
+void IdStressTests::testSortByDistance() {
+    auto target = Id::random();
+
+    for (int shared : { 0, 16 }) {
+        auto candidates = makeCandidates(target, shared);
+        std::cout << std::endl << "Sort " << CANDIDATES << " candidates by distance, "
+                << shared << " bytes shared with target: " << ROUNDS << " rounds" << std::endl;
+
+        std::vector<Id> legacySorted;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            legacySorted = candidates;
+            std::sort(legacySorted.begin(), legacySorted.end(), [&](const Id& a, const Id& b) {
+                return legacyThreeWayCompare(target, a, b) < 0;
+            });
+        }
+        report("byte loop", start, ROUNDS);
+
+        std::vector<Id> sorted;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            sorted = candidates;
+            std::sort(sorted.begin(), sorted.end(), [&](const Id& a, const Id& b) {
+                return target.threeWayCompare(a, b) < 0;
+            });
+        }
+        report("kernel", start, ROUNDS);
+
+        CPPUNIT_ASSERT(sorted == legacySorted);
+    }
+}
+
+}  // namespace test
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <string>
+
+#include <boson.h>
+
+#include "utils/log.h"
+#include "utils/log_formatters.h"
+#include "messages/find_node_response.h"
+#include "log_stress_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(LogStressTests);
+
+static const int MESSAGES = 50000;
+
+static int64_t report(const std::string& name, std::chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << std::setw(32) << std::left << name
+            << std::setw(10) << std::right << elapsed / 1000000 << " ms"
+            << std::setw(10) << std::right << elapsed / ops << " ns/op" << std::endl;
+    return elapsed;
+}
+
+void LogStressTests::testDisabledLevel() {
+    std::cout << std::endl << "Debug logs of received messages at info level: " << MESSAGES << std::endl;
+
+    auto log = Logger::get("LogStressTests");
+    log->setLevel(Level::Info);
+
+    std::list<Sp<NodeInfo>> nodes4;
+    std::list<Sp<NodeInfo>> nodes6;
+    for (int i = 0; i < 8; i++) {
+        nodes4.push_back(std::make_shared<NodeInfo>(Id::random(), "192.168.1." + std::to_string(i + 1), 39001));
+        nodes6.push_back(std::make_shared<NodeInfo>(Id::random(), "2001:db8::" + std::to_string(i + 1), 39001));
+    }
+
+    auto msg = std::make_shared<FindNodeResponse>(0x1234);
+    msg->setNodes4(nodes4);
+    msg->setNodes6(nodes6);
+    msg->setToken(0x5678);
+    SocketAddress from("192.168.1.100", 39001);
+
+    // the arguments the RPC server used to stringify before the level check
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < MESSAGES; i++)
+        log->debug("Received {}/{} from {}: [{}] {}", msg->getMethodString(), msg->getTypeString(),
+                from.toString(), 1024, static_cast<const Message&>(*msg).toString());
+    auto eager = report("toString arguments", start, MESSAGES);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < MESSAGES; i++)
+        log->debug("Received {}/{} from {}: [{}] {}", msg->getMethodString(), msg->getTypeString(),
+                from, 1024, static_cast<const Message&>(*msg));
+    auto lazy = report("formatted objects", start, MESSAGES);
+
+    CPPUNIT_ASSERT(lazy * 10 < eager);
+}
+
+}  // namespace test
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <boson.h>
+
+#include "constants.h"
+#include "dht.h"
+#include "kbucket.h"
+#include "kbucket_entry.h"
+#include "kclosest_nodes.h"
+#include "routing_table.h"
+#include "utils.h"
+#include "routing_table_stress_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(RoutingTableStressTests);
+
+static const int LOOKUPS = 1000000;
+static const int QUERIES = 100000;
+static const int DEPTHS = 160;
+
+static const std::string TEST_DIR = "routing_table_stress_tests" + Utils::PATH_SEP;
+
+static int64_t report(const std::string& name, std::chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << std::setw(32) << std::left << name
+            << std::setw(10) << std::right << elapsed / 1000000 << " ms"
+            << std::setw(10) << std::right << elapsed / ops << " ns/op" << std::endl;
+    return elapsed;
+}
+
+// An id starting with `depth` one bits followed by a zero bit
+static Id idAtDepth(int depth) {
+    auto random = Id::random();
+    std::array<uint8_t, ID_BYTES> bytes {};
+    std::memcpy(bytes.data(), random.data(), ID_BYTES);
+    for (int bit = 0; bit <= depth; bit++) {
+        uint8_t mask = 0x80 >> (bit % 8);
+        if (bit < depth)
+            bytes[bit / 8] |= mask;
+        else
+            bytes[bit / 8] &= ~mask;
+    }
+    return Id(Blob(bytes));
+}
+
+// Reachable entries for the first DEPTHS levels. A full bucket only splits when
+// an entry for its high branch arrives, so the levels are filled in order along
+// the high branches, every level ending up in a bucket of its own.
+static std::vector<Sp<KBucketEntry>> makeEntries() {
+    std::vector<Sp<KBucketEntry>> entries;
+    for (int depth = 0; depth < DEPTHS; depth++) {
+        for (int i = 0; i < Constants::MAX_ENTRIES_PER_BUCKET; i++) {
+            auto ip = "10." + std::to_string(depth) + "." + std::to_string(i) + ".1";
+            auto entry = std::make_shared<KBucketEntry>(idAtDepth(depth), SocketAddress(ip, 39001));
+            entry->signalResponse();
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+static Sp<Node> makeNode() {
+    auto path = Utils::getPwdStorage(TEST_DIR);
+    Utils::removeStorage(path);
+
+    DefaultConfiguration::Builder builder;
+    builder.setIPv4Address("127.0.0.1");
+    builder.setStoragePath(path);
+    return std::make_shared<Node>(builder.build());
+}
+
+// The list based binary search the routing table used before, kept as the baseline
+static int legacyIndexOf(const std::list<Sp<KBucket>>& buckets, const Id& id) {
+    int low = 0;
+    int mid = 0;
+    int cmp = 0;
+    int high = buckets.size() - 1;
+
+    while (low <= high) {
+        mid = (low + high) >> 1;
+        auto bucket = *std::next(buckets.begin(), mid);
+        cmp = id.compareTo(bucket->getPrefix());
+        if (cmp > 0)
+            low = mid + 1;
+        else if (cmp < 0)
+            high = mid - 1;
+        else
+            return mid;
+    }
+
+    return cmp < 0 ? mid - 1 : mid;
+}
+
+void RoutingTableStressTests::testPut() {
+    auto node = makeNode();
+    DHT dht(Network::IPv4, *node, SocketAddress("127.0.0.1", 39001));
+    auto entries = makeEntries();
+
+    std::cout << std::endl << "Put entries: " << entries.size() << std::endl;
+    auto& routingTable = dht.getRoutingTable();
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& entry : entries)
+        routingTable.put(entry);
+    report("put, splitting", start, entries.size());
+
+    std::cout << "    buckets: " << routingTable.size() << ", entries: "
+            << routingTable.getNumBucketEntries() << std::endl;
+    CPPUNIT_ASSERT(routingTable.size() >= DEPTHS);
+
+    // entries already in the table, the common case on every response
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOKUPS; i++)
+        routingTable.put(entries[i % entries.size()]);
+    report("put, existing", start, LOOKUPS);
+}
+
+void RoutingTableStressTests::testGetEntry() {
+    auto node = makeNode();
+    DHT dht(Network::IPv4, *node, SocketAddress("127.0.0.1", 39001));
+    auto entries = makeEntries();
+    auto& routingTable = dht.getRoutingTable();
+    for (const auto& entry : entries)
+        routingTable.put(entry);
+
+    std::cout << std::endl << "Lookup entries in " << routingTable.size() << " buckets: " << LOOKUPS << std::endl;
+
+    auto buckets = routingTable.getBuckets();
+    std::list<Sp<KBucket>> legacyBuckets(buckets->begin(), buckets->end());
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOKUPS; i++) {
+        const auto& id = entries[i % entries.size()]->getId();
+        found += (*std::next(legacyBuckets.begin(), legacyIndexOf(legacyBuckets, id)))->get(id) != nullptr;
+    }
+    auto legacy = report("list", start, LOOKUPS);
+    CPPUNIT_ASSERT_EQUAL(size_t(LOOKUPS), found);
+
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOKUPS; i++)
+        found += routingTable.getEntry(entries[i % entries.size()]->getId()) != nullptr;
+    auto vector = report("vector", start, LOOKUPS);
+    CPPUNIT_ASSERT_EQUAL(size_t(LOOKUPS), found);
+    CPPUNIT_ASSERT(vector < legacy);
+}
+
+void RoutingTableStressTests::testKClosestNodes() {
+    auto node = makeNode();
+    DHT dht(Network::IPv4, *node, SocketAddress("127.0.0.1", 39001));
+    auto entries = makeEntries();
+    auto& routingTable = dht.getRoutingTable();
+    for (const auto& entry : entries)
+        routingTable.put(entry);
+
+    std::vector<Id> targets;
+    for (int i = 0; i < 1024; i++)
+        targets.push_back(Id::random());
+
+    std::cout << std::endl << "KClosestNodes in " << routingTable.size() << " buckets: " << QUERIES << std::endl;
+    size_t filled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERIES; i++) {
+        KClosestNodes kns(dht, targets[i % targets.size()], Constants::MAX_ENTRIES_PER_BUCKET);
+        kns.fill();
+        filled += kns.size();
+    }
+    report("fill", start, QUERIES);
+    CPPUNIT_ASSERT_EQUAL(size_t(QUERIES) * Constants::MAX_ENTRIES_PER_BUCKET, filled);
+
+    // lookups ask for two buckets worth of nodes
+    filled = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERIES; i++) {
+        KClosestNodes kns(dht, targets[i % targets.size()], Constants::MAX_ENTRIES_PER_BUCKET * 2);
+        kns.fill();
+        filled += kns.size();
+    }
+    report("fill, 2 buckets", start, QUERIES);
+    CPPUNIT_ASSERT_EQUAL(size_t(QUERIES) * Constants::MAX_ENTRIES_PER_BUCKET * 2, filled);
+
+    // fewer than a bucket: the closest entries of the target's own bucket
+    auto buckets = routingTable.getBuckets();
+    for (const auto& target : targets) {
+        KClosestNodes kns(dht, target, 3);
+        kns.fill();
+
+        const auto& bucketEntries = (*buckets)[RoutingTable::indexOf(*buckets, target)]->getEntries();
+        std::vector<Sp<KBucketEntry>> expected(bucketEntries.begin(), bucketEntries.end());
+        std::sort(expected.begin(), expected.end(), [&](const Sp<KBucketEntry>& a, const Sp<KBucketEntry>& b) {
+            return target.threeWayCompare(a->getId(), b->getId()) < 0;
+        });
+        expected.resize(3);
+
+        std::vector<Sp<KBucketEntry>> closest(kns.getEntries().begin(), kns.getEntries().end());
+        std::sort(closest.begin(), closest.end(), [&](const Sp<KBucketEntry>& a, const Sp<KBucketEntry>& b) {
+            return target.threeWayCompare(a->getId(), b->getId()) < 0;
+        });
+        CPPUNIT_ASSERT(closest == expected);
+    }
+
+    // more than the selection holds: capped at its capacity
+    KClosestNodes kns(dht, targets[0], KClosestNodes::CAPACITY * 4);
+    kns.fill();
+    CPPUNIT_ASSERT_EQUAL((int)KClosestNodes::CAPACITY, kns.size());
+}
+
+}  // namespace test
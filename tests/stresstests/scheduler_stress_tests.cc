@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boson.h>
+
+#include "scheduler.h"
+#include "scheduler_stress_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(SchedulerStressTests);
+
+// The multimap based scheduler the timing wheel replaced, kept as the baseline
+class LegacyScheduler {
+public:
+    class Job {
+    public:
+        Job(std::function<void()>&& f) : do_(std::move(f)) {}
+
+        void cancel() {
+            do_ = {};
+            fixedDelay = 0;
+        }
+
+        explicit operator bool() const {
+            return (bool)do_;
+        }
+
+    private:
+        std::function<void()> do_;
+        long fixedDelay = 0;
+        friend class LegacyScheduler;
+    };
+
+    Sp<Job> add(std::function<void()>&& job_func, long delay, long fixedDelay = 0) {
+        auto job = std::make_shared<Job>(std::move(job_func));
+        job->fixedDelay = fixedDelay;
+        timers.emplace(currentTimeMillis() + delay, job);
+        return job;
+    }
+
+    void edit(Sp<Job>& job, long delay, long fixedDelay = 0) {
+        auto task = std::move(job->do_);
+        job->cancel();
+        job = add(std::move(task), delay, fixedDelay);
+    }
+
+    void run() {
+        while (!timers.empty()) {
+            auto timer = timers.begin();
+            if (timer->first > now)
+                break;
+
+            auto job = std::move(timer->second);
+            if (*job)
+                job->do_();
+
+            if (job->fixedDelay > 0)
+                edit(job, job->fixedDelay, job->fixedDelay);
+
+            timers.erase(timer);
+        }
+    }
+
+    uint64_t getNextJobTime() const {
+        return timers.empty() ? std::numeric_limits<uint64_t>::max() : timers.begin()->first;
+    }
+
+    void syncTime(uint64_t n) {
+        now = n;
+    }
+
+private:
+    uint64_t now {currentTimeMillis()};
+    std::multimap<uint64_t, Sp<Job>> timers {};
+};
+
+static const int CALLS = 200000;
+static const int CONCURRENT_CALLS = 4096;
+
+static void report(const std::string& name, std::chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << std::setw(32) << std::left << name
+            << std::setw(10) << std::right << elapsed / 1000000 << " ms"
+            << std::setw(10) << std::right << elapsed / ops << " ns/op" << std::endl;
+}
+
+/*
+ * The RPC call pattern: each call arms a timer when sent, most are canceled by
+ * the response, the rest fire. The time advances 1ms per call sent.
+ */
+template <class S>
+static int callTimers(S& scheduler) {
+    std::mt19937 rng(20231115);
+    std::vector<Sp<typename S::Job>> pending(CONCURRENT_CALLS);
+    int fired = 0;
+
+    uint64_t now = currentTimeMillis();
+    for (int i = 0; i < CALLS; i++) {
+        auto& slot = pending[i % CONCURRENT_CALLS];
+        if (slot && rng() % 10 != 0)
+            slot->cancel();
+
+        slot = scheduler.add([&fired]() { fired++; }, 100 + rng() % 10000);
+
+        scheduler.syncTime(++now);
+        if (scheduler.getNextJobTime() <= now)
+            scheduler.run();
+    }
+
+    return fired;
+}
+
+void SchedulerStressTests::testCallTimers() {
+    std::cout << std::endl << "Call timers: " << CALLS << " calls, " << CONCURRENT_CALLS << " in flight" << std::endl;
+
+    LegacyScheduler legacy;
+    auto start = std::chrono::steady_clock::now();
+    int legacyFired = callTimers(legacy);
+    report("multimap", start, CALLS);
+
+    Scheduler wheel;
+    start = std::chrono::steady_clock::now();
+    int wheelFired = callTimers(wheel);
+    report("timing wheel", start, CALLS);
+
+    CPPUNIT_ASSERT_EQUAL(legacyFired, wheelFired);
+}
+
+/*
+ * Rescheduling: what the recurring jobs do after every run, and what the
+ * stall check of a call does when it re-arms for the final timeout.
+ */
+template <class S>
+static int reschedule(S& scheduler, int jobs, int rounds) {
+    std::mt19937 rng(20231115);
+    std::vector<Sp<typename S::Job>> scheduled;
+    for (int i = 0; i < jobs; i++)
+        scheduled.push_back(scheduler.add([]() {}, 1000 + rng() % 60000));
+
+    for (int round = 0; round < rounds; round++) {
+        for (auto& job : scheduled)
+            scheduler.edit(job, 1000 + rng() % 60000, 1000);
+    }
+
+    return jobs * rounds;
+}
+
+void SchedulerStressTests::testReschedule() {
+    const int jobs = 1000;
+    const int rounds = 200;
+    std::cout << std::endl << "Reschedule: " << jobs << " jobs, " << rounds << " rounds" << std::endl;
+
+    LegacyScheduler legacy;
+    auto start = std::chrono::steady_clock::now();
+    int ops = reschedule(legacy, jobs, rounds);
+    report("multimap", start, ops);
+
+    Scheduler wheel;
+    start = std::chrono::steady_clock::now();
+    ops = reschedule(wheel, jobs, rounds);
+    report("timing wheel", start, ops);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)jobs, wheel.size());
+}
+
+}  // namespace test
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boson.h>
+
+#include "caching_storage.h"
+#include "constants.h"
+#include "memory_storage.h"
+#include "sqlite_storage.h"
+#include "write_behind_storage.h"
+#include "utils.h"
+#include "storage_stress_tests.h"
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(StorageStressTests);
+
+static const int RECORDS = 1000;
+static const int LOOKUPS = 10000;
+
+static int64_t report(const std::string& name, std::chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << std::setw(32) << std::left << name
+            << std::setw(10) << std::right << elapsed / 1000000 << " ms"
+            << std::setw(10) << std::right << elapsed / ops << " ns/op" << std::endl;
+    return elapsed;
+}
+
+// The rollback journal with a full fsync on every commit, the settings used before
+static SqliteStorage::Options legacyOptions() {
+    SqliteStorage::Options options {};
+    options.journalMode = "DELETE";
+    options.synchronous = "FULL";
+    return options;
+}
+
+void StorageStressTests::setUp() {
+    path = Utils::getPwdStorage("storagestress.db");
+}
+
+void StorageStressTests::tearDown() {
+    Utils::removeStorage(path);
+    Utils::removeStorage(path + "-wal");
+    Utils::removeStorage(path + "-shm");
+}
+
+void StorageStressTests::testValues() {
+    std::vector<Value> values;
+    for (int i = 0; i < RECORDS; i++)
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+
+    std::cout << std::endl << "Values: " << RECORDS << " puts, " << LOOKUPS << " gets" << std::endl;
+    for (const auto& [name, options] : { std::make_pair("rollback, full", legacyOptions()),
+            std::make_pair("wal, normal", SqliteStorage::Options {}) }) {
+        tearDown();
+        auto storage = SqliteStorage::open(path, scheduler, options);
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& value : values)
+            storage->putValue(value);
+        report(std::string(name) + ", put", start, RECORDS);
+
+        int found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++)
+            found += storage->getValue(values[i % RECORDS].getId()) != nullptr;
+        report(std::string(name) + ", get", start, LOOKUPS);
+
+        storage->close();
+        CPPUNIT_ASSERT_EQUAL(LOOKUPS, found);
+    }
+}
+
+void StorageStressTests::testPeers() {
+    std::vector<PeerInfo> peers;
+    auto nodeId = Id::random();
+    for (int i = 0; i < RECORDS; i++)
+        peers.push_back(PeerInfo::create(nodeId, 8888));
+
+    std::cout << std::endl << "Peers: " << RECORDS << " puts, " << LOOKUPS << " gets" << std::endl;
+    for (const auto& [name, options] : { std::make_pair("rollback, full", legacyOptions()),
+            std::make_pair("wal, normal", SqliteStorage::Options {}) }) {
+        tearDown();
+        auto storage = SqliteStorage::open(path, scheduler, options);
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& peer : peers)
+            storage->putPeer(peer);
+        report(std::string(name) + ", put", start, RECORDS);
+
+        int found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++)
+            found += storage->getPeer(peers[i % RECORDS].getId(), 8).size();
+        report(std::string(name) + ", get", start, LOOKUPS);
+
+        storage->close();
+        CPPUNIT_ASSERT_EQUAL(LOOKUPS, found);
+    }
+}
+
+// The time the caller (the rx thread in the DHT) spends in put, direct vs write-behind
+void StorageStressTests::testWriteBehind() {
+    std::vector<Value> values;
+    std::vector<PeerInfo> peers;
+    auto nodeId = Id::random();
+    for (int i = 0; i < RECORDS; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+        peers.push_back(PeerInfo::create(nodeId, 8888));
+    }
+
+    std::cout << std::endl << "Write-behind: " << RECORDS << " value puts, " << RECORDS << " peer puts" << std::endl;
+    for (const auto& [name, options] : { std::make_pair("rollback, full", legacyOptions()),
+            std::make_pair("wal, normal", SqliteStorage::Options {}) }) {
+        tearDown();
+        auto storage = SqliteStorage::open(path, scheduler, options);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < RECORDS; i++) {
+            storage->putValue(values[i]);
+            storage->putPeer(peers[i]);
+        }
+        report(std::string(name) + ", direct", start, RECORDS * 2);
+        storage->close();
+
+        tearDown();
+        WriteBehindStorage writeBehind(SqliteStorage::open(path, scheduler, options));
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < RECORDS; i++) {
+            writeBehind.putValue(values[i]);
+            writeBehind.putPeer(peers[i]);
+        }
+        report(std::string(name) + ", write-behind", start, RECORDS * 2);
+
+        start = std::chrono::steady_clock::now();
+        writeBehind.flush();
+        report(std::string(name) + ", flush", start, RECORDS * 2);
+        std::cout << "    " << writeBehind.getCommits() << " commits, "
+                << writeBehind.getAverageCommitLatency() << " us/commit" << std::endl;
+
+        int found = 0;
+        for (const auto& value : values)
+            found += writeBehind.getValue(value.getId()) != nullptr;
+        writeBehind.close();
+        CPPUNIT_ASSERT_EQUAL(RECORDS, found);
+    }
+}
+
+// Repeated lookups of the same targets, as the DHT answers popular ids
+void StorageStressTests::testCache() {
+    std::vector<Id> valueIds;
+    std::vector<Id> peerIds;
+
+    auto storage = SqliteStorage::open(path, scheduler);
+    for (int i = 0; i < RECORDS; i++) {
+        auto value = Value::createValue(Utils::getRandomData(256));
+        storage->putValue(value);
+        valueIds.push_back(value.getId());
+    }
+    for (int i = 0; i < RECORDS / 10; i++) {
+        auto keypair = Signature::KeyPair::random();
+        for (int j = 0; j < 16; j++)
+            storage->putPeer(PeerInfo::create(keypair, Id::random(), Id::random(), 8000 + j));
+        peerIds.push_back(Id(keypair.publicKey()));
+    }
+
+    std::cout << std::endl << "Cache: " << LOOKUPS << " value gets, " << LOOKUPS << " peer gets" << std::endl;
+    CachingStorage cached(storage);
+    for (const auto& [name, target] : { std::make_pair("sqlite", storage.get()),
+            std::make_pair("cached", static_cast<DataStorage*>(&cached)) }) {
+        int found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++)
+            found += target->getValue(valueIds[i % RECORDS]) != nullptr;
+        report(std::string(name) + ", value get", start, LOOKUPS);
+        CPPUNIT_ASSERT_EQUAL(LOOKUPS, found);
+
+        found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++)
+            found += target->getPeer(peerIds[i % peerIds.size()], 8).size();
+        report(std::string(name) + ", peer get", start, LOOKUPS);
+        CPPUNIT_ASSERT_EQUAL(LOOKUPS * 8, found);
+    }
+
+    std::cout << "    hit ratio " << (int)(cached.getHitRatio() * 100) << "%, "
+            << cached.size() << " entries, " << cached.getMemoryUsage() / 1024 << " KiB" << std::endl;
+    cached.close();
+}
+
+// The in-memory backend against SQLite in WAL mode, then the expiry of everything
+void StorageStressTests::testMemory() {
+    std::vector<Value> values;
+    std::vector<PeerInfo> peers;
+    auto nodeId = Id::random();
+    for (int i = 0; i < RECORDS; i++) {
+        values.push_back(Value::createValue(Utils::getRandomData(256)));
+        peers.push_back(PeerInfo::create(nodeId, 8888));
+    }
+
+    std::cout << std::endl << "Memory: " << RECORDS << " puts, " << LOOKUPS << " gets" << std::endl;
+    auto memory = std::make_shared<MemoryStorage>();
+    for (const auto& [name, storage] : { std::make_pair("wal, normal", SqliteStorage::open(path, scheduler)),
+            std::make_pair("memory", std::static_pointer_cast<DataStorage>(memory)) }) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < RECORDS; i++) {
+            storage->putValue(values[i]);
+            storage->putPeer(peers[i]);
+        }
+        report(std::string(name) + ", put", start, RECORDS * 2);
+
+        int found = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++) {
+            found += storage->getValue(values[i % RECORDS].getId()) != nullptr;
+            found += storage->getPeer(peers[i % RECORDS].getId(), 8).size();
+        }
+        report(std::string(name) + ", get", start, LOOKUPS * 2);
+        CPPUNIT_ASSERT_EQUAL(LOOKUPS * 2, found);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto expired = memory->expire(currentTimeMillis() + Constants::MAX_VALUE_AGE + Constants::MAX_PEER_AGE);
+    report("memory, expire", start, RECORDS * 2);
+    CPPUNIT_ASSERT_EQUAL((size_t)RECORDS * 2, expired);
+}
+
+// The longest the rx thread is held by expiry: one big DELETE against one chunk
+void StorageStressTests::testExpire() {
+    const int count = RECORDS * 50;
+    auto later = currentTimeMillis() + Constants::MAX_VALUE_AGE + Constants::MAX_PEER_AGE;
+
+    auto fill = [&]() {
+        tearDown();
+        auto storage = SqliteStorage::open(path, scheduler);
+        storage->transaction([&]() {
+            for (int i = 0; i < count; i++)
+                storage->putValue(Value::createValue(Utils::getRandomData(64)), i % 10 == 0);
+        });
+        return std::static_pointer_cast<SqliteStorage>(storage);
+    };
+
+    std::cout << std::endl << "Expire: " << count << " values, 90% expired" << std::endl;
+    {
+        auto storage = fill();
+        storage->close();
+
+        sqlite3* db {nullptr};
+        sqlite3_open(path.c_str(), &db);
+        auto sql = "DELETE FROM valores WHERE persistent != TRUE and timestamp < " + std::to_string(later);
+        auto start = std::chrono::steady_clock::now();
+        sqlite3_exec(db, sql.c_str(), 0, 0, 0);
+        report("single delete", start, count);
+        sqlite3_close(db);
+    }
+
+    {
+        auto storage = fill();
+        auto stored = storage->getAllValues().size();
+        storage->expire(later);
+        while (storage->isExpiring()) {
+            scheduler.syncTime();
+            scheduler.run();
+        }
+
+        auto stats = storage->getLastExpire();
+        std::cout << "    " << std::setw(32) << std::left << "chunked delete"
+                << std::setw(10) << std::right << stats.time / 1000 << " ms"
+                << std::setw(10) << std::right << stats.time / stats.chunks << " us/chunk, "
+                << stats.chunks << " chunks" << std::endl;
+        CPPUNIT_ASSERT_EQUAL(stored - (size_t)stats.values, storage->getAllValues().size());
+        storage->close();
+    }
+}
+
+}  // namespace test
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022 - 2023 trinity-tech.io
+ * Copyright (c) 2023 -  ~   bosonnetwork.io
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boson.h>
+
+#include "crypto/shasum.h"
+#include "token_manager.h"
+#include "token_stress_tests.h"
+
+#ifdef __linux__
+#include <endian.h>
+#define htonll(n) htobe64(n)
+#endif
+
+using namespace boson;
+
+namespace test {
+CPPUNIT_TEST_SUITE_REGISTRATION(TokenStressTests);
+
+// The SHA-256 token the SipHash one replaced, kept as the baseline
+static int legacyToken(const Id& nodeId, const SocketAddress& addr, const Id& targetId,
+        long timestamp, std::array<uint8_t, 32>& sessionSecret) {
+    const uint16_t port = htons(addr.port());
+    const uint64_t stamp = htonll(timestamp);
+
+    auto sha256 = SHA256();
+    sha256.update(nodeId.blob());
+    sha256.update({addr.inaddr(), addr.inaddrLength()});
+    sha256.update({(const uint8_t*)&port, sizeof(uint16_t)});
+    sha256.update(targetId.blob());
+    sha256.update({(const uint8_t*)&stamp, sizeof(uint64_t)});
+    sha256.update(sessionSecret);
+
+    auto digest = sha256.digest();
+    int pos = (digest[0] & 0xff) & 0x1f; // mod 32
+    return ((digest[pos] & 0xff) << 24) |
+            ((digest[(pos + 1) & 0x1f] & 0xff) << 16) |
+            ((digest[(pos + 2) & 0x1f] & 0xff) << 8) |
+            (digest[(pos + 3) & 0x1f] & 0xff);
+}
+
+static const int TOKENS = 500000;
+
+struct Requester {
+    Id nodeId;
+    SocketAddress addr;
+    Id target;
+};
+
+static std::vector<Requester> requesters() {
+    std::vector<Requester> result;
+    for (int i = 0; i < 1024; i++) {
+        auto ip = "10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+        result.push_back({Id::random(), SocketAddress(ip, 39001), Id::random()});
+    }
+    return result;
+}
+
+static void report(const std::string& name, std::chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << std::setw(32) << std::left << name
+            << std::setw(10) << std::right << elapsed / 1000000 << " ms"
+            << std::setw(10) << std::right << elapsed / ops << " ns/op" << std::endl;
+}
+
+void TokenStressTests::testGenerate() {
+    std::cout << std::endl << "Generate tokens: " << TOKENS << std::endl;
+    auto reqs = requesters();
+    std::array<uint8_t, 32> secret {};
+    secret.fill(0x5a);
+
+    // keep the loops from being optimized away
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TOKENS; i++) {
+        auto& r = reqs[i % reqs.size()];
+        sink ^= legacyToken(r.nodeId, r.addr, r.target, 1700000000000, secret);
+    }
+    report("sha256", start, TOKENS);
+
+    TokenManager manager;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TOKENS; i++) {
+        auto& r = reqs[i % reqs.size()];
+        sink ^= manager.generateToken(r.nodeId, r.addr, r.target);
+    }
+    report("siphash", start, TOKENS);
+}
+
+void TokenStressTests::testVerify() {
+    std::cout << std::endl << "Verify invalid tokens: " << TOKENS << std::endl;
+    auto reqs = requesters();
+    std::array<uint8_t, 32> secret {};
+    secret.fill(0x5a);
+
+    // wrong tokens: both periods are checked, the worst case of a verification
+    std::vector<int> legacyTokens;
+    for (auto& r : reqs)
+        legacyTokens.push_back(legacyToken(r.nodeId, r.addr, r.target, 2, secret) + 1);
+
+    int invalid = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TOKENS; i++) {
+        auto& r = reqs[i % reqs.size()];
+        int token = legacyTokens[i % reqs.size()];
+        invalid += (token != legacyToken(r.nodeId, r.addr, r.target, 2, secret)) &&
+                (token != legacyToken(r.nodeId, r.addr, r.target, 1, secret));
+    }
+    report("sha256", start, TOKENS);
+    CPPUNIT_ASSERT_EQUAL(TOKENS, invalid);
+
+    TokenManager manager;
+    std::vector<int> tokens;
+    for (auto& r : reqs)
+        tokens.push_back(manager.generateToken(r.nodeId, r.addr, r.target) + 1);
+
+    invalid = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TOKENS; i++) {
+        auto& r = reqs[i % reqs.size()];
+        invalid += !manager.verifyToken(tokens[i % reqs.size()], r.nodeId, r.addr, r.target);
+    }
+    report("siphash", start, TOKENS);
+    CPPUNIT_ASSERT_EQUAL(TOKENS, invalid);
+}
+
+}  // namespace test